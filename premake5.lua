@@ -7,6 +7,12 @@ workspace "cdogs-cdl"
 		"MultiProcessorCompile"
 	}
    
+	
+project "cdogs-sdl"
+	kind "ConsoleApp"
+	language "C++"
+	targetdir "bin/%{cfg.buildcfg}"
+	
 	buildoptions
 	{
 		"`pkg-config --cflags --libs gtk+-3.0`",
@@ -21,21 +27,87 @@ workspace "cdogs-cdl"
 		"-lm"
 	}
 	
+	files
+	{
+		"src/**.h",
+		"src/**.cpp"
+	}
+	removefiles
+	{
+		"src/cdogsed/**",
+		"src/server/**",
+		"src/tests/**",
+	}
 	
-project "cdogs-sdl"
+	includedirs
+	{
+		"src/",
+		"src/cdogs",
+		"src/cdogs/include/",
+		"src/cdogs/proto/nanopb/",
+		"src/cdogs/enet/include/",
+		"src/cdogs/yajl/api/"
+	}
+	
+	filter "configurations:Debug"
+      defines { "DEBUG" }
+      symbols "On"
+
+   filter "configurations:Release"
+      defines { "NDEBUG" }
+      optimize "On"
+
+-- Headless dedicated server: simulation, map, campaign and net code only
+-- SDL is only used for timers and loading images (for pic sizes)
+project "cdogs-server"
 	kind "ConsoleApp"
 	language "C++"
 	targetdir "bin/%{cfg.buildcfg}"
 	
+	defines { "CDOGS_HEADLESS" }
+	buildoptions
+	{
+		"`pkg-config --cflags sdl2`",
+	}
+	linkoptions
+	{ 
+		"`pkg-config --libs sdl2`",
+		"-lSDL2_image",
+		"-lm"
+	}
+	
 	files
 	{
-		"src/**.h",
-		"src/**.cpp"
+		"src/cdogs/**.h",
+		"src/cdogs/**.cpp",
+		"src/server/**.h",
+		"src/server/**.cpp",
+		"src/command_line.h",
+		"src/command_line.cpp",
+		"src/game_loop.h",
+		"src/game_loop.cpp",
+		"src/json/**.h",
+		"src/json/**.cpp"
 	}
+	-- Audio and rendering are replaced by no-ops in src/server
 	removefiles
 	{
-		"src/cdogsed/**",
-		"src/tests/**",
+		"src/cdogs/music.cpp",
+		"src/cdogs/sounds.cpp",
+		"src/cdogs/automap.cpp",
+		"src/cdogs/camera.cpp",
+		"src/cdogs/font.cpp",
+		"src/cdogs/font_utils.cpp",
+		"src/cdogs/grafx.cpp",
+		"src/cdogs/grafx_bg.cpp",
+		"src/cdogs/texture.cpp",
+		"src/cdogs/window_context.cpp",
+		"src/cdogs/draw/draw.cpp",
+		"src/cdogs/draw/draw_actor.cpp",
+		"src/cdogs/draw/draw_buffer.cpp",
+		"src/cdogs/draw/drawtools.cpp",
+		"src/cdogs/draw/nine_slice.cpp",
+		"src/cdogs/hud/**.cpp",
 	}
 	
 	includedirs
@@ -54,4 +126,4 @@ project "cdogs-sdl"
 
    filter "configurations:Release"
       defines { "NDEBUG" }
-      optimize "On"
\ No newline at end of file
+      optimize "On"
@@ -71,6 +71,7 @@ static void CampaignIntroTerminate(GameLoopData *data) {
 static void CampaignIntroOnEnter(GameLoopData *data) {
 	UNUSED(data);
 	MusicPlay(&gSoundDevice, MUSIC_BRIEFING, NULL, NULL);
+	MusicPrefetch(&gSoundDevice, MUSIC_GAME);
 }
 static void CampaignIntroOnExit(GameLoopData *data) {
 	const ScreenCampaignIntroData *sData =
@@ -394,6 +395,7 @@ static void MissionSummaryOnEnter(GameLoopData *data) {
 	MissionSummaryData *mData = static_cast<MissionSummaryData*>(data->Data);
 
 	MusicPlay(&gSoundDevice, MUSIC_BRIEFING, NULL, NULL);
+	MusicPrefetch(&gSoundDevice, MUSIC_GAME);
 
 	if (mData->completed && IsPasswordAllowed(mData->c->Entry.Mode)) {
 		// Save password
@@ -54,6 +54,7 @@
 #include <SDL2/SDL.h>
 
 #include <cdogs/ammo.h>
+#include <cdogs/asset_pack.h>
 #include <cdogs/campaigns.h>
 #include <cdogs/character_class.h>
 #include <cdogs/collision/collision.h>
@@ -181,6 +182,14 @@ int main(int argc, char *argv[]) {
 	LOG(LM_MAIN, LL_INFO, "data dir(%s)", buf);
 	LOG(LM_MAIN, LL_INFO, "config dir(%s)", GetConfigFilePath(""));
 
+	// Load assets from the pack if there is one, otherwise from loose files
+	AssetPackInit(&gAssetPack);
+	{
+		char packPath[CDOGS_PATH_MAX];
+		GetDataFilePath(packPath, ASSET_PACK_FILE);
+		AssetPackOpen(&gAssetPack, packPath, buf);
+	}
+
 	SoundInitialize(&gSoundDevice, "sounds");
 	if (!gSoundDevice.isInitialised) {
 		LOG(LM_MAIN, LL_ERROR, "Sound initialization failed!");
@@ -276,6 +285,7 @@ int main(int argc, char *argv[]) {
 	AutosaveTerminate(&gAutosave);
 	PlayerTemplatesTerminate(&gPlayerTemplates);
 	SoundTerminate(&gSoundDevice, true);
+	AssetPackTerminate(&gAssetPack);
 	ConfigDestroy(&gConfig);
 	LogTerminate();
 
@@ -186,5 +186,5 @@ struct vec2 PlacePlayer(Map *map, const PlayerData *p,
 		HandleGameEvents(&gGameEvents, NULL, NULL, NULL);
 	}
 
-	return svec2(aa.Pos.x, aa.Pos.y);
+	return NetToVec2(aa.Pos);
 }
@@ -63,10 +63,12 @@
 #include "collision/collision.h"
 #include "config.h"
 #include "damage.h"
+#include "draw/draw_actor.h"
 #include "draw/drawtools.h"
 #include "events.h"
 #include "game_events.h"
 #include "log.h"
+#include "net_client.h"
 #include "pic_manager.h"
 #include "sounds.h"
 #include "thing.h"
@@ -383,14 +385,66 @@ static struct vec2 GetConstrainedPos(const Map *map, const struct vec2 from,
 	return from;
 }
 
+static bool IsInterpolated(const TActor *a);
+static struct vec2 NetToVec2Keep(const NVec2 v, const struct vec2 current);
 void ActorMove(const NActorMove am) {
 	TActor *a = ActorGetByUID(am.UID);
 	if (a == NULL || !a->isInUse)
 		return;
-	a->Pos = NetToVec2(am.Pos);
-	a->MoveVel = NetToVec2(am.MoveVel);
+	a->MoveVel = NetToVec2Keep(am.MoveVel, a->MoveVel);
+	if (!gCampaign.IsClient) {
+		a->predict.Seq = am.Seq;
+	}
+	if (IsInterpolated(a) && a->interp.Count > 0) {
+		// Smoothly move towards the new position in ActorUpdatePosition
+		NetInterpAdd(&a->interp, gMission.time, NetToVec2(am.Pos),
+				a->MoveVel);
+		return;
+	}
+	a->Pos = NetToVec2Keep(am.Pos, a->Pos);
+	if (IsInterpolated(a)) {
+		NetInterpAdd(&a->interp, gMission.time, a->Pos, a->MoveVel);
+	}
 	OnMove(a);
 }
+static bool IsInterpolated(const TActor *a) {
+	return gCampaign.IsClient && !ActorIsLocalPlayer(a->uid);
+}
+// Moves are sent at network precision; keep the current unrounded value if
+// it is what was sent, e.g. for our own moves, so that they don't change
+// the simulation
+static struct vec2 NetToVec2Keep(const NVec2 v, const struct vec2 current) {
+	const NVec2 nc = Vec2ToNet(current);
+	if (nc.x == v.x && nc.y == v.y) {
+		return current;
+	}
+	return NetToVec2(v);
+}
+
+void ActorReconcile(TActor *a, const uint32_t inputSeq, const struct vec2 pos) {
+	const NetPredictInput *in = NetPredictGet(&a->predict, inputSeq);
+	if (in == NULL
+			|| svec2_distance_squared(in->Pos, pos)
+					<= NET_PREDICT_TOLERANCE * NET_PREDICT_TOLERANCE) {
+		return;
+	}
+	LOG(LM_NET, LL_DEBUG, "reconcile actor(%d) seq(%u) error(%f)", a->uid,
+			inputSeq, svec2_distance(in->Pos, pos));
+	// Start from the server's position and replay the inputs since.
+	// Only collide with walls, as colliding with things has side effects
+	// such as melee, which have already happened.
+	struct vec2 replayPos = pos;
+	for (uint32_t seq = inputSeq + 1; seq <= a->predict.Seq; seq++) {
+		NetPredictInput *replay = NetPredictGet(&a->predict, seq);
+		replayPos = GetConstrainedPos(&gMap, replayPos,
+				svec2_add(replayPos, replay->MoveVel), a->thing.size);
+		replay->Pos = replayPos;
+	}
+	a->Pos = replayPos;
+	OnMove(a);
+	// Let the server know where we are now
+	a->hasCollided = true;
+}
 static void CheckTrigger(const struct vec2i tilePos, const bool showLocked);
 static void CheckRescue(const TActor *a);
 static void OnMove(TActor *a) {
@@ -752,7 +806,13 @@ static bool ActorTryMove(TActor *actor, int cmd, int hasShot, int ticks) {
 		else if (cmd & CMD_DOWN)
 			moveVel.y++;
 		if (!svec2_is_zero(moveVel)) {
-			actor->MoveVel = svec2_scale(svec2_normalize(moveVel), moveAmount);
+			actor->MoveVel =
+					svec2_scale(svec2_normalize(moveVel), moveAmount);
+			// The server moves our players with the velocity we send it;
+			// predict with the same rounded value so we don't drift apart
+			if (gCampaign.IsClient && ActorIsLocalPlayer(actor->uid)) {
+				actor->MoveVel = NetToVec2(Vec2ToNet(actor->MoveVel));
+			}
 		}
 	}
 
@@ -762,6 +822,7 @@ static bool ActorTryMove(TActor *actor, int cmd, int hasShot, int ticks) {
 		e.u.ActorMove.UID = actor->uid;
 		e.u.ActorMove.Pos = Vec2ToNet(actor->Pos);
 		e.u.ActorMove.MoveVel = Vec2ToNet(actor->MoveVel);
+		e.u.ActorMove.Seq = actor->predict.Seq;
 		GameEventsEnqueue(&gGameEvents, e);
 	}
 
@@ -864,9 +925,17 @@ void UpdateAllActors(int ticks) {
 static void CheckManualPickups(TActor *a);
 static void ActorUpdatePosition(TActor *actor, int ticks) {
 	struct vec2 newPos = svec2_add(actor->Pos, actor->MoveVel);
+	// Remote actors on clients follow the positions from the server,
+	// delayed so that there are updates to interpolate between
+	const bool interpolated = IsInterpolated(actor) && NetInterpTryGet(
+			&actor->interp,
+			gMission.time - NetClientGetInterpDelay(&gNetClient), &newPos);
 	if (!svec2_is_zero(actor->thing.Vel)) {
-		newPos = svec2_add(newPos,
-				svec2_scale(actor->thing.Vel, (float) ticks));
+		// The server's positions already include sliding
+		if (!interpolated) {
+			newPos = svec2_add(newPos,
+					svec2_scale(actor->thing.Vel, (float) ticks));
+		}
 
 		for (int i = 0; i < ticks; i++) {
 			if (actor->thing.Vel.x > FLT_EPSILON) {
@@ -885,6 +954,15 @@ static void ActorUpdatePosition(TActor *actor, int ticks) {
 	if (!svec2_is_nearly_equal(actor->Pos, newPos, EPSILON_POS)) {
 		TryMoveActor(actor, newPos);
 	}
+	// Number the inputs of client players; the server follows along
+	// between their moves
+	if (gCampaign.IsClient) {
+		if (ActorIsLocalPlayer(actor->uid)) {
+			NetPredictAdd(&actor->predict, actor->MoveVel, actor->Pos);
+		}
+	} else if (actor->PlayerUID >= 0 && !ActorIsLocalPlayer(actor->uid)) {
+		actor->predict.Seq++;
+	}
 	// Check if we're standing over any manual pickups
 	CheckManualPickups(actor);
 }
@@ -1156,6 +1234,8 @@ TActor* ActorAdd(NActorAdd aa) {
 	GoreEmitterInit(&actor->blood2, "blood2");
 	GoreEmitterInit(&actor->blood3, "blood3");
 
+	ActorLoadSprites(actor);
+
 	TryMoveActor(actor, NetToVec2(aa.Pos));
 
 // Spawn sound for player actors
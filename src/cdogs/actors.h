@@ -54,6 +54,8 @@
 #include "game_mode.h"
 #include "grafx.h"
 #include "mathc/mathc.h"
+#include "net_interp.h"
+#include "net_predict.h"
 #include "player.h"
 #include "thing.h"
 #include "weapon.h"
@@ -93,6 +95,10 @@ typedef struct Actor {
 	struct vec2 Pos;
 	// Vector that the player is attempting to move in, based on input
 	struct vec2 MoveVel;
+	// Positions from the server, for smoothing remote actors on clients
+	NetInterp interp;
+	// Movement inputs, for predicting local players on clients
+	NetPredict predict;
 	direction_e direction;
 	// Rotation used to draw the actor, which will lag behind the actual
 	// rotation in order to show smooth rotation
@@ -160,6 +166,7 @@ typedef struct Actor {
 	// Signals to other AIs what this actor is doing
 	ActorAction action;
 	AIContext *aiContext;
+	CharacterSpritesCache spritesCache;
 	Thing thing;
 	bool isInUse;
 } TActor;
@@ -178,6 +185,9 @@ void ActorSetState(TActor *actor, const ActorAnimation state);
 void UpdateActorState(TActor *actor, int ticks);
 bool TryMoveActor(TActor *actor, struct vec2 pos);
 void ActorMove(const NActorMove am);
+// Correct a local player if the server disagrees with where we predicted
+// them to be after an input
+void ActorReconcile(TActor *a, const uint32_t inputSeq, const struct vec2 pos);
 void CommandActor(TActor *actor, int cmd, int ticks);
 void SlideActor(TActor *actor, int cmd);
 void UpdateAllActors(int ticks);
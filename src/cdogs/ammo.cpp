@@ -29,6 +29,7 @@
 
 #include <string.h>
 
+#include "asset_pack.h"
 #include "json_utils.h"
 #include "log.h"
 #include "pic_manager.h"
@@ -68,7 +69,7 @@ void AmmoInitialize(AmmoClasses *ammo, const char *path) {
 
 	char buf[CDOGS_PATH_MAX];
 	GetDataFilePath(buf, path);
-	FILE *f = fopen(buf, "r");
+	FILE *f = AssetFOpen(buf, "r");
 	if (f == NULL) {
 		LOG(LM_MAIN, LL_ERROR, "Error: cannot load ammo file %s", buf);
 		goto bail;
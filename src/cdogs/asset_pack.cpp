@@ -0,0 +1,573 @@
+/*
+ C-Dogs SDL
+ A port of the legendary (and fun) action/arcade cdogs.
+
+ Copyright (c) 2020 Cong Xu
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "asset_pack.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#define ASSET_PACK_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <SDL2/SDL_endian.h>
+#include <tinydir/tinydir.h>
+
+#include "c_array.h"
+#include "log.h"
+#include "utils.h"
+
+#define ASSET_PACK_MAGIC "CDAP"
+#define ASSET_PACK_VERSION 1
+// File data is aligned so that it can be read in place
+#define ASSET_PACK_ALIGN 16
+
+// All values are little endian
+typedef struct {
+	char Magic[4];
+	uint32_t Version;
+	uint32_t Count;
+	uint32_t Unused;
+	uint64_t DirOffset;	// of the entries, which are followed by the strings
+	uint64_t StringsSize;
+} AssetPackHeader;
+
+AssetPack gAssetPack;
+
+void AssetPackInit(AssetPack *p) {
+	memset(p, 0, sizeof *p);
+}
+void AssetPackTerminate(AssetPack *p) {
+	AssetUnmapFile(p->Data, p->Size);
+	memset(p, 0, sizeof *p);
+}
+
+static void NormalisePath(char *out, const char *path) {
+	strcpy(out, path);
+	for (char *c = out; *c != '\0'; c++) {
+		if (*c == '\\') {
+			*c = '/';
+		}
+	}
+}
+static bool AssetPackMap(AssetPack *p, const char *path);
+static bool AssetPackIndex(AssetPack *p);
+static bool AssetPackIsStale(const AssetPack *p, const char *path);
+bool AssetPackOpen(AssetPack *p, const char *path, const char *root) {
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+	UNUSED(p);
+	UNUSED(path);
+	UNUSED(root);
+	return false;
+#else
+	if (!AssetPackMap(p, path)) {
+		return false;
+	}
+	if (!AssetPackIndex(p)) {
+		LOG(LM_MAIN, LL_WARN, "Asset pack %s is invalid; ignoring", path);
+		AssetPackTerminate(p);
+		return false;
+	}
+	NormalisePath(p->Root, root);
+	// Strip trailing separators
+	for (size_t len = strlen(p->Root); len > 0 && p->Root[len - 1] == '/';
+			len--) {
+		p->Root[len - 1] = '\0';
+	}
+	if (AssetPackIsStale(p, path)) {
+		LOG(LM_MAIN, LL_INFO, "Asset pack %s is older than the data dir; "
+				"using loose files", path);
+		AssetPackTerminate(p);
+		return false;
+	}
+	LOG(LM_MAIN, LL_INFO, "Opened asset pack %s with %u files", path,
+			p->Count);
+	return true;
+#endif
+}
+static bool AssetPackMap(AssetPack *p, const char *path) {
+	size_t size;
+	void *data = AssetMapFile(path, &size);
+	if (data == NULL) {
+		return false;
+	}
+	p->Data = data;
+	p->Size = size;
+	if (size < sizeof(AssetPackHeader)) {
+		AssetPackTerminate(p);
+		return false;
+	}
+	return true;
+}
+static const char* EntryPath(const AssetPack *p, const uint32_t i) {
+	return p->Strings + p->Entries[i].PathOffset;
+}
+static bool AssetPackIndex(AssetPack *p) {
+	const uint8_t *data = static_cast<const uint8_t*>(p->Data);
+	const AssetPackHeader *h = reinterpret_cast<const AssetPackHeader*>(data);
+	if (memcmp(h->Magic, ASSET_PACK_MAGIC, sizeof h->Magic) != 0
+			|| h->Version != ASSET_PACK_VERSION) {
+		return false;
+	}
+	const uint64_t dirSize = (uint64_t) h->Count * sizeof(AssetPackEntry);
+	if (h->DirOffset % sizeof(uint64_t) != 0 || h->DirOffset > p->Size
+			|| dirSize > p->Size - h->DirOffset
+			|| h->StringsSize == 0
+			|| h->StringsSize > p->Size - h->DirOffset - dirSize) {
+		return false;
+	}
+	p->Entries = reinterpret_cast<const AssetPackEntry*>(data + h->DirOffset);
+	p->Count = h->Count;
+	p->Strings = reinterpret_cast<const char*>(data + h->DirOffset + dirSize);
+	if (p->Strings[h->StringsSize - 1] != '\0') {
+		return false;
+	}
+	for (uint32_t i = 0; i < p->Count; i++) {
+		const AssetPackEntry *e = &p->Entries[i];
+		if (e->PathOffset >= h->StringsSize
+				|| e->Compression != ASSET_PACK_STORED
+				|| e->StoredSize != e->Size || e->Offset > p->Size
+				|| e->StoredSize > p->Size - e->Offset) {
+			return false;
+		}
+		// Lookups rely on the paths being sorted
+		if (i > 0 && strcmp(EntryPath(p, i - 1), EntryPath(p, i)) >= 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Files added to or removed from the data dir since packing aren't in the
+// pack, so check the packed dirs and their parents, which change when they do.
+// The root itself is skipped as the pack is written there.
+// Files edited in place aren't checked, to keep lookups free of disk access;
+// repack after editing them.
+static bool IsDirNewer(const char *dir, const time_t t);
+static bool AssetPackIsStale(const AssetPack *p, const char *path) {
+	struct stat st;
+	if (stat(path, &st) != 0) {
+		return true;
+	}
+	const char *lastDir = NULL;
+	size_t lastDirLen = 0;
+	for (uint32_t i = 0; i < p->Count; i++) {
+		const char *rel = EntryPath(p, i);
+		const char *slash = strrchr(rel, '/');
+		const size_t dirLen = slash != NULL ? (size_t) (slash - rel) : 0;
+		// Entries are sorted, so files in the same dir are mostly together
+		if (lastDir != NULL && dirLen == lastDirLen
+				&& strncmp(rel, lastDir, dirLen) == 0) {
+			continue;
+		}
+		lastDir = rel;
+		lastDirLen = dirLen;
+		for (size_t j = 1; j <= dirLen; j++) {
+			if (j < dirLen && rel[j] != '/') {
+				continue;
+			}
+			char dir[CDOGS_PATH_MAX];
+			sprintf(dir, "%s/%.*s", p->Root, (int) j, rel);
+			if (IsDirNewer(dir, st.st_mtime)) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+static bool IsDirNewer(const char *dir, const time_t t) {
+	struct stat st;
+	return stat(dir, &st) == 0 && st.st_mtime > t;
+}
+
+// Get the path relative to the pack root, or NULL if outside it
+static const char* RelPath(const AssetPack *p, const char *path, char *buf) {
+	if (p->Data == NULL) {
+		return NULL;
+	}
+	NormalisePath(buf, path);
+	const size_t rootLen = strlen(p->Root);
+	if (strncmp(buf, p->Root, rootLen) != 0 || buf[rootLen] != '/') {
+		return NULL;
+	}
+	const char *rel = buf + rootLen;
+	while (*rel == '/') {
+		rel++;
+	}
+	return rel;
+}
+// Index of the first entry whose path is not less than key, comparing only
+// the first n chars
+static uint32_t LowerBound(const AssetPack *p, const char *key,
+		const size_t n) {
+	uint32_t lo = 0, hi = p->Count;
+	while (lo < hi) {
+		const uint32_t mid = lo + (hi - lo) / 2;
+		if (strncmp(EntryPath(p, mid), key, n) < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+bool AssetPackFind(const AssetPack *p, const char *path, AssetPackFile *f) {
+	char buf[CDOGS_PATH_MAX];
+	const char *rel = RelPath(p, path, buf);
+	if (rel == NULL) {
+		return false;
+	}
+	const uint32_t i = LowerBound(p, rel, strlen(rel) + 1);
+	if (i == p->Count || strcmp(EntryPath(p, i), rel) != 0) {
+		return false;
+	}
+	const AssetPackEntry *e = &p->Entries[i];
+	f->Data = static_cast<const uint8_t*>(p->Data) + e->Offset;
+	f->Size = (size_t) e->Size;
+	f->MTime = e->MTime;
+	return true;
+}
+
+bool AssetPackDirOpen(AssetPackDir *d, const AssetPack *p, const char *path) {
+	memset(d, 0, sizeof *d);
+	char buf[CDOGS_PATH_MAX];
+	const char *rel = RelPath(p, path, buf);
+	if (rel == NULL) {
+		return false;
+	}
+	char prefix[CDOGS_PATH_MAX];
+	strcpy(prefix, rel);
+	size_t len = strlen(prefix);
+	while (len > 0 && prefix[len - 1] == '/') {
+		len--;
+	}
+	if (len > 0) {
+		prefix[len++] = '/';
+	}
+	prefix[len] = '\0';
+	d->pack = p;
+	d->dirLen = len;
+	d->i = LowerBound(p, prefix, len);
+	d->end = d->i;
+	while (d->end < p->Count
+			&& strncmp(EntryPath(p, d->end), prefix, len) == 0) {
+		d->end++;
+	}
+	return d->i < d->end;
+}
+bool AssetPackDirNext(AssetPackDir *d) {
+	if (d->i >= d->end) {
+		return false;
+	}
+	sprintf(d->Path, "%s/%s", d->pack->Root, EntryPath(d->pack, d->i));
+	d->Name = d->Path + strlen(d->pack->Root) + 1 + d->dirLen;
+	d->i++;
+	return true;
+}
+
+SDL_RWops* AssetRWFromFile(const char *path) {
+	AssetPackFile f;
+	if (AssetPackFind(&gAssetPack, path, &f)) {
+		return SDL_RWFromConstMem(f.Data, (int) f.Size);
+	}
+	return SDL_RWFromFile(path, "rb");
+}
+FILE* AssetFOpen(const char *path, const char *mode) {
+	AssetPackFile f;
+	if (!AssetPackFind(&gAssetPack, path, &f)) {
+		return fopen(path, mode);
+	}
+	if (strpbrk(mode, "wa+") != NULL) {
+		LOG(LM_MAIN, LL_ERROR, "Cannot write packed file %s", path);
+		errno = EACCES;
+		return NULL;
+	}
+#ifdef ASSET_PACK_MMAP
+	// The stream only reads, so the read-only mapping can be used directly
+	if (f.Size > 0) {
+		return fmemopen(const_cast<void*>(f.Data), f.Size, "r");
+	}
+#endif
+	FILE *tmp = tmpfile();
+	if (tmp == NULL) {
+		return NULL;
+	}
+	if (fwrite(f.Data, 1, f.Size, tmp) != f.Size) {
+		fclose(tmp);
+		return NULL;
+	}
+	rewind(tmp);
+	return tmp;
+}
+bool AssetStat(const char *path, int64_t *mtime, int64_t *size) {
+	AssetPackFile f;
+	if (AssetPackFind(&gAssetPack, path, &f)) {
+		*mtime = f.MTime;
+		*size = (int64_t) f.Size;
+		return true;
+	}
+	struct stat st;
+	if (stat(path, &st) != 0) {
+		return false;
+	}
+	*mtime = (int64_t) st.st_mtime;
+	*size = (int64_t) st.st_size;
+	return true;
+}
+
+typedef struct {
+	char *Rel;
+	char *Full;
+} AssetPackSource;
+static void AddSources(CArray *sources, const char *root, const char *rel);
+static int CompareSources(const void *a, const void *b);
+static bool WriteSource(FILE *f, const AssetPackSource *s, AssetPackEntry *e,
+		uint32_t *stringsSize);
+static bool WritePadding(FILE *f, const long pos, const uint64_t align);
+bool AssetPackBuild(const char *path, const char *root,
+		const char **dirs, const int numDirs) {
+	bool ok = false;
+	CArray sources;
+	CArrayInit(&sources, sizeof(AssetPackSource));
+	CArray entries;
+	CArrayInit(&entries, sizeof(AssetPackEntry));
+	AssetPackHeader h;
+	memset(&h, 0, sizeof h);
+	char tmpPath[CDOGS_PATH_MAX];
+	sprintf(tmpPath, "%s.tmp", path);
+	FILE *f = NULL;
+
+	for (int i = 0; i < numDirs; i++) {
+		AddSources(&sources, root, dirs[i]);
+	}
+	if (sources.size == 0) {
+		LOG(LM_MAIN, LL_ERROR, "No files to pack in %s", root);
+		goto bail;
+	}
+	qsort(sources.data, sources.size, sources.elemSize, CompareSources);
+
+	f = fopen(tmpPath, "wb");
+	if (f == NULL) {
+		LOG(LM_MAIN, LL_ERROR, "Cannot write asset pack %s: %s", tmpPath,
+				strerror(errno));
+		goto bail;
+	}
+	// The header is filled in at the end
+	if (fwrite(&h, sizeof h, 1, f) != 1) {
+		goto bail;
+	}
+	{
+		uint32_t stringsSize = 0;
+		CA_FOREACH(const AssetPackSource, s, sources)
+			AssetPackEntry e;
+			if (!WriteSource(f, s, &e, &stringsSize)) {
+				goto bail;
+			}
+			CArrayPushBack(&entries, &e);
+		CA_FOREACH_END()
+		if (!WritePadding(f, ftell(f), sizeof(uint64_t))) {
+			goto bail;
+		}
+		memcpy(h.Magic, ASSET_PACK_MAGIC, sizeof h.Magic);
+		h.Version = ASSET_PACK_VERSION;
+		h.Count = (uint32_t) entries.size;
+		h.DirOffset = (uint64_t) ftell(f);
+		h.StringsSize = stringsSize;
+	}
+	if (fwrite(entries.data, entries.elemSize, entries.size, f) !=
+			entries.size) {
+		goto bail;
+	}
+	CA_FOREACH(const AssetPackSource, s, sources)
+		if (fwrite(s->Rel, strlen(s->Rel) + 1, 1, f) != 1) {
+			goto bail;
+		}
+	CA_FOREACH_END()
+	if (fseek(f, 0, SEEK_SET) != 0 || fwrite(&h, sizeof h, 1, f) != 1) {
+		goto bail;
+	}
+	ok = true;
+
+bail:
+	if (f != NULL && fclose(f) != 0) {
+		ok = false;
+	}
+	if (ok) {
+		remove(path);
+		if (rename(tmpPath, path) != 0) {
+			LOG(LM_MAIN, LL_ERROR, "Cannot replace asset pack %s: %s", path,
+					strerror(errno));
+			ok = false;
+		}
+	}
+	if (!ok) {
+		remove(tmpPath);
+	} else {
+		LOG(LM_MAIN, LL_INFO, "Packed %d files into %s", (int) sources.size,
+				path);
+	}
+	CA_FOREACH(AssetPackSource, s, sources)
+		CFREE(s->Rel);
+		CFREE(s->Full);
+	CA_FOREACH_END()
+	CArrayTerminate(&sources);
+	CArrayTerminate(&entries);
+	return ok;
+}
+static void AddSources(CArray *sources, const char *root, const char *rel) {
+	char buf[CDOGS_PATH_MAX];
+	sprintf(buf, "%s/%s", root, rel);
+	tinydir_dir dir;
+	if (tinydir_open(&dir, buf) == -1) {
+		LOG(LM_MAIN, LL_WARN, "Cannot open dir to pack '%s': %s", buf,
+				strerror(errno));
+		goto bail;
+	}
+	for (; dir.has_next; tinydir_next(&dir)) {
+		tinydir_file file;
+		if (tinydir_readfile(&dir, &file) == -1) {
+			LOG(LM_MAIN, LL_ERROR, "Cannot read file '%s': %s", file.path,
+					strerror(errno));
+			continue;
+		}
+		// Skip hidden files, and the . and .. dirs
+		if (file.name[0] == '.') {
+			continue;
+		}
+		sprintf(buf, "%s/%s", rel, file.name);
+		if (file.is_dir) {
+			AddSources(sources, root, buf);
+		} else if (file.is_reg) {
+			AssetPackSource s;
+			CSTRDUP(s.Rel, buf);
+			CSTRDUP(s.Full, file.path);
+			CArrayPushBack(sources, &s);
+		}
+	}
+
+bail:
+	tinydir_close(&dir);
+}
+static int CompareSources(const void *a, const void *b) {
+	return strcmp(static_cast<const AssetPackSource*>(a)->Rel,
+			static_cast<const AssetPackSource*>(b)->Rel);
+}
+static bool WriteSource(FILE *f, const AssetPackSource *s, AssetPackEntry *e,
+		uint32_t *stringsSize) {
+	memset(e, 0, sizeof *e);
+	FILE *src = fopen(s->Full, "rb");
+	if (src == NULL) {
+		LOG(LM_MAIN, LL_ERROR, "Cannot read file to pack %s: %s", s->Full,
+				strerror(errno));
+		return false;
+	}
+	bool ok = WritePadding(f, ftell(f), ASSET_PACK_ALIGN);
+	e->Offset = (uint64_t) ftell(f);
+	char buf[64 * 1024];
+	size_t n;
+	while (ok && (n = fread(buf, 1, sizeof buf, src)) > 0) {
+		ok = fwrite(buf, 1, n, f) == n;
+		e->Size += n;
+	}
+	ok = ok && !ferror(src);
+	fclose(src);
+	e->StoredSize = e->Size;
+	e->Compression = ASSET_PACK_STORED;
+	e->PathOffset = *stringsSize;
+	*stringsSize += (uint32_t) strlen(s->Rel) + 1;
+	struct stat st;
+	if (stat(s->Full, &st) == 0) {
+		e->MTime = (int64_t) st.st_mtime;
+	}
+	return ok;
+}
+static bool WritePadding(FILE *f, const long pos, const uint64_t align) {
+	static const uint8_t zeros[ASSET_PACK_ALIGN] = { 0 };
+	const size_t len = (size_t) ((align - (uint64_t) pos % align) % align);
+	return fwrite(zeros, 1, len, f) == len;
+}
+
+void* AssetMapFile(const char *path, size_t *size) {
+#ifdef ASSET_PACK_MMAP
+	const int fd = open(path, O_RDONLY);
+	if (fd == -1) {
+		return NULL;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+		close(fd);
+		return NULL;
+	}
+	void *data = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd,
+			0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		LOG(LM_MAIN, LL_WARN, "Cannot map %s: %s", path, strerror(errno));
+		return NULL;
+	}
+	*size = (size_t) st.st_size;
+	return data;
+#else
+	// No mmap; read the whole file instead
+	FILE *f = fopen(path, "rb");
+	if (f == NULL) {
+		return NULL;
+	}
+	void *data = NULL;
+	long len;
+	if (fseek(f, 0, SEEK_END) != 0 || (len = ftell(f)) <= 0
+			|| fseek(f, 0, SEEK_SET) != 0) {
+		goto bail;
+	}
+	CMALLOC(data, len);
+	if (fread(data, 1, (size_t) len, f) != (size_t) len) {
+		CFREE(data);
+		data = NULL;
+		goto bail;
+	}
+	*size = (size_t) len;
+
+bail:
+	fclose(f);
+	return data;
+#endif
+}
+void AssetUnmapFile(void *data, const size_t size) {
+	if (data == NULL) {
+		return;
+	}
+#ifdef ASSET_PACK_MMAP
+	munmap(data, size);
+#else
+	UNUSED(size);
+	CFREE(data);
+#endif
+}
@@ -0,0 +1,110 @@
+/*
+ C-Dogs SDL
+ A port of the legendary (and fun) action/arcade cdogs.
+
+ Copyright (c) 2020 Cong Xu
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <SDL2/SDL_rwops.h>
+
+#include "sys_config.h"
+
+// A pack of data files in a single file, so that assets can be loaded
+// without opening thousands of separate files.
+// The pack has a directory of files sorted by path, so that files can be
+// found by binary search, and the files under a dir are contiguous.
+// File data is aligned and read straight out of the memory-mapped pack.
+// Paths in the pack are relative to the data dir, e.g. "graphics/foo.png",
+// and are looked up using the same full paths that the loose files have.
+
+#define ASSET_PACK_FILE "assets.cdogspak"
+
+typedef struct {
+	uint64_t Offset;	// of the data, from the start of the pack
+	uint64_t Size;
+	uint64_t StoredSize;	// size in the pack; differs if compressed
+	int64_t MTime;	// of the source file, when packed
+	uint32_t PathOffset;	// in the string table
+	uint32_t Compression;	// ASSET_PACK_STORED is the only one for now
+} AssetPackEntry;
+#define ASSET_PACK_STORED 0
+
+typedef struct {
+	void *Data;	// mapped pack file
+	size_t Size;
+	char Root[CDOGS_PATH_MAX];	// paths in the pack are relative to this
+	const AssetPackEntry *Entries;
+	uint32_t Count;
+	const char *Strings;
+} AssetPack;
+
+extern AssetPack gAssetPack;
+
+void AssetPackInit(AssetPack *p);
+void AssetPackTerminate(AssetPack *p);
+// Map a pack whose paths are relative to root; returns false if there is no
+// valid pack, in which case the loose files are used
+bool AssetPackOpen(AssetPack *p, const char *path, const char *root);
+
+typedef struct {
+	const void *Data;
+	size_t Size;
+	int64_t MTime;
+} AssetPackFile;
+// Find a file by its full path
+bool AssetPackFind(const AssetPack *p, const char *path, AssetPackFile *f);
+
+// Iterate over all the files under a dir in the pack, recursively
+typedef struct {
+	const AssetPack *pack;
+	uint32_t i;
+	uint32_t end;
+	size_t dirLen;	// length of the dir's path in the pack, with '/'
+	// Set by AssetPackDirNext
+	char Path[CDOGS_PATH_MAX];	// full path
+	const char *Name;	// path relative to the dir, pointing into Path
+} AssetPackDir;
+// Returns false if the pack has no files under this dir
+bool AssetPackDirOpen(AssetPackDir *d, const AssetPack *p, const char *path);
+bool AssetPackDirNext(AssetPackDir *d);
+
+// Helpers for loaders that take files from the pack if they are in it,
+// or from disk otherwise; packed files can only be opened for reading
+SDL_RWops* AssetRWFromFile(const char *path);
+FILE* AssetFOpen(const char *path, const char *mode);
+bool AssetStat(const char *path, int64_t *mtime, int64_t *size);
+
+// Map a whole file read-only, or read it if mapping is not available;
+// returns NULL on failure
+void* AssetMapFile(const char *path, size_t *size);
+void AssetUnmapFile(void *data, const size_t size);
+
+// Pack all the files under dirs (relative to root) into a new pack file
+bool AssetPackBuild(const char *path, const char *root,
+		const char **dirs, const int numDirs);
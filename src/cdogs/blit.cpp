@@ -92,17 +92,56 @@ void CharColorsGetMaskedName(char *buf, const char *base, const CharColors *c) {
 }
 
 void BlitClearBuf(GraphicsDevice *g) {
-	memset(g->buf, 0, GraphicsGetMemSize(&g->cachedConfig));
+	const Rect2i r = g->bufDirty;
+	if (r.Size.x <= 0 || r.Size.y <= 0) {
+		return;
+	}
+	const int w = g->cachedConfig.Res.x;
+	for (int y = r.Pos.y; y < r.Pos.y + r.Size.y; y++) {
+		memset(&g->buf[r.Pos.x + y * w], 0, r.Size.x * sizeof(Uint32));
+	}
+	g->bufDirty = Rect2iZero();
 }
 void BlitFillBuf(GraphicsDevice *g, const color_t c) {
 	const Uint32 pixel = COLOR2PIXEL(c);
-	RECT_FOREACH(Rect2iNew(svec2i_zero(), g->cachedConfig.Res))
+	const Rect2i r = Rect2iNew(svec2i_zero(), g->cachedConfig.Res);
+	RECT_FOREACH(r)
 	g->buf[_i] = pixel;
 	RECT_FOREACH_END()
+	BlitMarkBufDirty(g, r);
+}
+void BlitMarkBufDirty(GraphicsDevice *g, const Rect2i r) {
+	g->bufDirty = Rect2iUnion(g->bufDirty, r);
 }
+static BufTexture* GetBufTexture(GraphicsDevice *g, SDL_Texture *t);
 void BlitUpdateFromBuf(GraphicsDevice *g, SDL_Texture *t) {
-	if (SDL_UpdateTexture(t, NULL, g->buf,
-			g->cachedConfig.Res.x * sizeof(Uint32)) != 0) {
+	BufTexture *bt = GetBufTexture(g, t);
+	// Upload what was drawn to the buffer, and erase what was previously
+	// uploaded to the texture
+	const Rect2i r = Rect2iUnion(g->bufDirty, bt->Dirty);
+	if (r.Size.x <= 0 || r.Size.y <= 0) {
+		return;
+	}
+	const int w = g->cachedConfig.Res.x;
+	SDL_Rect rect = { r.Pos.x, r.Pos.y, r.Size.x, r.Size.y };
+	if (SDL_UpdateTexture(t, &rect, &g->buf[r.Pos.x + r.Pos.y * w],
+			w * sizeof(Uint32)) != 0) {
 		LOG(LM_GFX, LL_ERROR, "cannot update texture: %s", SDL_GetError());
+		return;
+	}
+	bt->Dirty = g->bufDirty;
+}
+static BufTexture* GetBufTexture(GraphicsDevice *g, SDL_Texture *t) {
+	CA_FOREACH(BufTexture, bt, g->bufTextures)
+	if (bt->Tex == t) {
+		return bt;
 	}
+	CA_FOREACH_END()
+	// New textures have unknown contents; upload to all of it
+	BufTexture bt;
+	bt.Tex = t;
+	bt.Dirty = Rect2iNew(svec2i_zero(), g->cachedConfig.Res);
+	CArrayPushBack(&g->bufTextures, &bt);
+	return static_cast<BufTexture*>(CArrayGet(&g->bufTextures,
+			g->bufTextures.size - 1));
 }
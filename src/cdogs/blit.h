@@ -50,8 +50,12 @@ typedef enum {
 } CharColorType;
 color_t* CharColorGetByType(CharColors *c, const CharColorType t);
 
+// The buffer and textures updated from it track which regions have been
+// drawn to, so that clearing and uploading only touch those regions
 void BlitClearBuf(GraphicsDevice *g);
 void BlitFillBuf(GraphicsDevice *g, const color_t c);
+// Call after writing to the buffer directly
+void BlitMarkBufDirty(GraphicsDevice *g, const Rect2i r);
 void BlitUpdateFromBuf(GraphicsDevice *g, SDL_Texture *t);
 
 CharColors CharColorsFromOneColor(const color_t color);
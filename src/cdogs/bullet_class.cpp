@@ -828,7 +828,8 @@ void BulletAdd(const NAddBullet add) {
 	EmitterInit(&obj->trail, obj->bulletClass->Trail.P, svec2_zero(), 0, 0, 0,
 			0, 0, 0, obj->bulletClass->Trail.TicksPerEmit);
 
-	obj->thing.Vel = svec2_scale(Vec2FromRadians(add.Angle),
+	obj->thing.Vel = svec2_scale(Vec2FromRadians(
+			NetToRadians(add.Angle, NET_ANGLE_BITS_BULLET)),
 			RAND_FLOAT(obj->bulletClass->SpeedLow,
 					obj->bulletClass->SpeedHigh));
 	if (obj->bulletClass->SpeedScale) {
@@ -90,6 +90,12 @@ bool CampaignEntryTryLoad(CampaignEntry *entry, const char *path,
 	}
 	char title[256];
 	sprintf(title, "%s (%d)", buf, numMissions);
+	CampaignEntryInitScanned(entry, path, title, mode, numMissions);
+	CFREE(buf);
+	return true;
+}
+void CampaignEntryInitScanned(CampaignEntry *entry, const char *path,
+		const char *title, const GameMode mode, const int numMissions) {
 	CampaignEntryInit(entry, title, mode);
 	entry->Filename = static_cast<char*>(malloc(
 			strlen(PathGetBasename(path)) + 1));
@@ -112,8 +118,6 @@ bool CampaignEntryTryLoad(CampaignEntry *entry, const char *path,
 	strcpy(entry->Path, pathBuf);
 //	CSTRDUP(entry->Path, pathBuf);
 	entry->NumMissions = numMissions;
-	CFREE(buf);
-	return true;
 }
 void CampaignEntryTerminate(CampaignEntry *entry) {
 	CFREE(entry->Filename);
@@ -42,4 +42,7 @@ void CampaignEntryInit(CampaignEntry *entry, const char *title, GameMode mode);
 void CampaignEntryCopy(CampaignEntry *dst, CampaignEntry *src);
 bool CampaignEntryTryLoad(CampaignEntry *entry, const char *path,
 		GameMode mode);
+// Make an entry from previously scanned info, without loading the campaign
+void CampaignEntryInitScanned(CampaignEntry *entry, const char *path,
+		const char *title, const GameMode mode, const int numMissions);
 void CampaignEntryTerminate(CampaignEntry *entry);
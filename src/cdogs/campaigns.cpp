@@ -29,10 +29,12 @@
 #include "campaigns.h"
 
 #include <stdio.h>
+#include <sys/stat.h>
 
 #include <tinydir/tinydir.h>
 
 #include <cdogs/files.h>
+#include <cdogs/json_utils.h>
 #include <cdogs/log.h>
 #include <cdogs/map_new.h>
 #include <cdogs/mission.h>
@@ -80,10 +82,32 @@ void CampaignSettingTerminate(CampaignSetting *setting) {
 	MapObjectsClear(&gMapObjects.CustomClasses);
 }
 
+// Index of scanned campaigns, saved in the config dir, so that campaigns
+// are only scanned again if they have been added or changed
+#define CAMPAIGN_INDEX_FILE "campaigns.json"
+#define CAMPAIGN_INDEX_VERSION 1
+typedef struct {
+	long long MTime;
+	long long Size;
+	GameMode Mode;
+	// Campaigns that fail to load are also indexed, so they are skipped
+	bool IsOK;
+	char *Title;
+	int NumMissions;
+	// Whether the campaign still exists; others are dropped from the index
+	bool IsFound;
+} CampaignIndexEntry;
+typedef struct {
+	map_t entries;	// of CampaignIndexEntry, by full path
+	bool IsDirty;
+} CampaignIndex;
+
+static void CampaignIndexLoad(CampaignIndex *ci);
+static void CampaignIndexSave(CampaignIndex *ci);
 static void CampaignListInit(campaign_list_t *list);
 static void CampaignListTerminate(campaign_list_t *list);
 static void LoadCampaignsFromFolder(campaign_list_t *list, const char *name,
-		const char *path, const GameMode mode);
+		const char *path, const GameMode mode, CampaignIndex *ci);
 static void LoadQuickPlayEntry(CampaignEntry *entry);
 
 void LoadAllCampaigns(custom_campaigns_t *campaigns) {
@@ -92,20 +116,154 @@ void LoadAllCampaigns(custom_campaigns_t *campaigns) {
 	CampaignListInit(&campaigns->campaignList);
 	CampaignListInit(&campaigns->dogfightList);
 
+	CampaignIndex ci;
+	CampaignIndexLoad(&ci);
+
 	GetDataFilePath(buf, CDOGS_CAMPAIGN_DIR);
 	LOG(LM_MAIN, LL_INFO, "Load campaigns from dir %s...", buf);
 	LoadCampaignsFromFolder(&campaigns->campaignList, "", buf,
-			GAME_MODE_NORMAL);
+			GAME_MODE_NORMAL, &ci);
 
 	GetDataFilePath(buf, CDOGS_DOGFIGHT_DIR);
 	LOG(LM_MAIN, LL_INFO, "Load dogfights from dir %s...", buf);
 	LoadCampaignsFromFolder(&campaigns->dogfightList, "", buf,
-			GAME_MODE_DOGFIGHT);
+			GAME_MODE_DOGFIGHT, &ci);
+
+	CampaignIndexSave(&ci);
 
 	LOG(LM_MAIN, LL_INFO, "Load quick play...");
 	LoadQuickPlayEntry(&campaigns->quickPlayEntry);
 }
 
+static void CampaignIndexLoadJSON(CampaignIndex *ci, json_t *root);
+static void CampaignIndexLoad(CampaignIndex *ci) {
+	ci->entries = hashmap_new();
+	ci->IsDirty = false;
+	json_t *root = NULL;
+	FILE *f = fopen(GetConfigFilePath(CAMPAIGN_INDEX_FILE), "r");
+	if (f == NULL) {
+		goto bail;
+	}
+	if (json_stream_parse(f, &root) != JSON_OK) {
+		LOG(LM_MAIN, LL_WARN, "Cannot parse campaign index; rebuilding");
+		goto bail;
+	}
+	CampaignIndexLoadJSON(ci, root);
+
+bail:
+	json_free_value(&root);
+	if (f != NULL) {
+		fclose(f);
+	}
+}
+static void CampaignIndexLoadJSON(CampaignIndex *ci, json_t *root) {
+	int version = 0;
+	LoadInt(&version, root, "Version");
+	const json_t *campaignsNode = json_find_first_label(root, "Campaigns");
+	if (version != CAMPAIGN_INDEX_VERSION || campaignsNode == NULL) {
+		return;
+	}
+	for (json_t *child = campaignsNode->child->child; child != NULL;
+			child = child->next) {
+		if (json_find_first_label(child, "Path") == NULL
+				|| json_find_first_label(child, "MTime") == NULL
+				|| json_find_first_label(child, "Size") == NULL) {
+			continue;
+		}
+		CampaignIndexEntry *e;
+		CCALLOC(e, sizeof *e);
+		char *path = GetString(child, "Path");
+		char *tmp = GetString(child, "MTime");
+		e->MTime = strtoll(tmp, NULL, 10);
+		CFREE(tmp);
+		tmp = GetString(child, "Size");
+		e->Size = strtoll(tmp, NULL, 10);
+		CFREE(tmp);
+		int mode = 0;
+		LoadInt(&mode, child, "Mode");
+		e->Mode = (GameMode) mode;
+		LoadBool(&e->IsOK, child, "IsOK");
+		if (e->IsOK && json_find_first_label(child, "Title") != NULL) {
+			e->Title = GetString(child, "Title");
+			LoadInt(&e->NumMissions, child, "NumMissions");
+		} else {
+			e->IsOK = false;
+		}
+		if (hashmap_put(ci->entries, path, e) != MAP_OK) {
+			CFREE(e->Title);
+			CFREE(e);
+		}
+		CFREE(path);
+	}
+}
+typedef struct {
+	json_t *items;
+	map_t entries;
+	bool hasRemoved;
+} SaveCampaignIndexData;
+static int CheckEntryFound(any_t data, any_t item);
+static int SaveEntry(any_t data, any_t key);
+static void CampaignIndexEntryDestroy(any_t data);
+static void CampaignIndexSave(CampaignIndex *ci) {
+	SaveCampaignIndexData data = { NULL, ci->entries, false };
+	// Campaigns that weren't found this time are dropped from the index
+	hashmap_iterate(ci->entries, CheckEntryFound, &data);
+	if (ci->IsDirty || data.hasRemoved) {
+		json_t *root = json_new_object();
+		AddIntPair(root, "Version", CAMPAIGN_INDEX_VERSION);
+		data.items = json_new_array();
+		hashmap_iterate_keys(ci->entries, SaveEntry, &data);
+		json_insert_pair_into_object(root, "Campaigns", data.items);
+		if (!TrySaveJSONFile(root, GetConfigFilePath(CAMPAIGN_INDEX_FILE))) {
+			LOG(LM_MAIN, LL_WARN, "Cannot save campaign index");
+		}
+		json_free_value(&root);
+	}
+	hashmap_destroy(ci->entries, CampaignIndexEntryDestroy);
+}
+static int CheckEntryFound(any_t data, any_t item) {
+	SaveCampaignIndexData *sData = (SaveCampaignIndexData*) data;
+	const CampaignIndexEntry *e = (const CampaignIndexEntry*) item;
+	if (!e->IsFound) {
+		sData->hasRemoved = true;
+	}
+	return MAP_OK;
+}
+static int SaveEntry(any_t data, any_t key) {
+	SaveCampaignIndexData *sData = (SaveCampaignIndexData*) data;
+	CampaignIndexEntry *e;
+	const int error = hashmap_get(sData->entries, (const char*) key,
+			(any_t*) &e);
+	if (error != MAP_OK) {
+		CASSERT(false, "cannot find campaign index entry");
+		return error;
+	}
+	if (!e->IsFound) {
+		return MAP_OK;
+	}
+	json_t *node = json_new_object();
+	AddStringPair(node, "Path", (const char*) key);
+	// Stamps may not fit in an int, so store them as strings
+	char buf[32];
+	sprintf(buf, "%lld", e->MTime);
+	AddStringPair(node, "MTime", buf);
+	sprintf(buf, "%lld", e->Size);
+	AddStringPair(node, "Size", buf);
+	AddIntPair(node, "Mode", (int) e->Mode);
+	AddBoolPair(node, "IsOK", e->IsOK);
+	if (e->IsOK) {
+		AddStringPair(node, "Title", e->Title);
+		AddIntPair(node, "NumMissions", e->NumMissions);
+	}
+	json_insert_child(sData->items, node);
+	return MAP_OK;
+}
+static void CampaignIndexEntryDestroy(any_t data) {
+	CampaignIndexEntry *e = (CampaignIndexEntry*) data;
+	CFREE(e->Title);
+	CFREE(e);
+}
+
 void UnloadAllCampaigns(custom_campaigns_t *campaigns) {
 	if (campaigns) {
 		CampaignListTerminate(&campaigns->campaignList);
@@ -137,8 +295,12 @@ static void LoadQuickPlayEntry(CampaignEntry *entry) {
 	entry->Mode = GAME_MODE_QUICK_PLAY;
 }
 
+static bool CampaignStamp(const char *path, const bool isArchive,
+		long long *mtime, long long *size);
+static bool TryLoadCampaignIndexed(CampaignEntry *entry, const char *path,
+		const bool isArchive, const GameMode mode, CampaignIndex *ci);
 static void LoadCampaignsFromFolder(campaign_list_t *list, const char *name,
-		const char *path, const GameMode mode) {
+		const char *path, const GameMode mode, CampaignIndex *ci) {
 	tinydir_dir dir;
 	int i;
 
@@ -166,11 +328,13 @@ static void LoadCampaignsFromFolder(campaign_list_t *list, const char *name,
 				&& strcmp(file.name, "..") != 0) {
 			campaign_list_t subFolder;
 			CampaignListInit(&subFolder);
-			LoadCampaignsFromFolder(&subFolder, file.name, file.path, mode);
+			LoadCampaignsFromFolder(&subFolder, file.name, file.path, mode,
+					ci);
 			CArrayPushBack(&list->subFolders, &subFolder);
 		} else if ((file.is_reg || isArchive) && file.name[0] != '~') {
 			CampaignEntry entry;
-			if (CampaignEntryTryLoad(&entry, file.path, mode)) {
+			if (TryLoadCampaignIndexed(&entry, file.path, isArchive, mode,
+					ci)) {
 				CArrayPushBack(&list->list, &entry);
 			}
 		}
@@ -178,6 +342,63 @@ static void LoadCampaignsFromFolder(campaign_list_t *list, const char *name,
 
 	tinydir_close(&dir);
 }
+static bool TryLoadCampaignIndexed(CampaignEntry *entry, const char *path,
+		const bool isArchive, const GameMode mode, CampaignIndex *ci) {
+	long long mtime, size;
+	if (!CampaignStamp(path, isArchive, &mtime, &size)) {
+		return CampaignEntryTryLoad(entry, path, mode);
+	}
+	CampaignIndexEntry *e;
+	if (hashmap_get(ci->entries, path, (any_t*) &e) == MAP_OK) {
+		if (e->MTime == mtime && e->Size == size && e->Mode == mode) {
+			e->IsFound = true;
+			if (e->IsOK) {
+				CampaignEntryInitScanned(entry, path, e->Title, mode,
+						e->NumMissions);
+			}
+			return e->IsOK;
+		}
+		// Stale; load it again below
+		CFREE(e->Title);
+		e->Title = NULL;
+	} else {
+		CCALLOC(e, sizeof *e);
+		if (hashmap_put(ci->entries, path, e) != MAP_OK) {
+			CFREE(e);
+			return CampaignEntryTryLoad(entry, path, mode);
+		}
+	}
+	LOG(LM_MAIN, LL_DEBUG, "Scanning new or changed campaign %s", path);
+	e->MTime = mtime;
+	e->Size = size;
+	e->Mode = mode;
+	e->IsFound = true;
+	e->IsOK = CampaignEntryTryLoad(entry, path, mode);
+	if (e->IsOK) {
+		CSTRDUP(e->Title, entry->Info);
+		e->NumMissions = entry->NumMissions;
+	}
+	ci->IsDirty = true;
+	return e->IsOK;
+}
+static bool CampaignStamp(const char *path, const bool isArchive,
+		long long *mtime, long long *size) {
+	// Archive dirs are stamped by their campaign file, since editing the
+	// files inside doesn't always update the dir's own mtime
+	char buf[CDOGS_PATH_MAX];
+	if (isArchive) {
+		sprintf(buf, "%s/campaign.json", path);
+	} else {
+		strcpy(buf, path);
+	}
+	struct stat st;
+	if (stat(buf, &st) != 0) {
+		return false;
+	}
+	*mtime = (long long) st.st_mtime;
+	*size = (long long) st.st_size;
+	return true;
+}
 
 Mission* CampaignGetCurrentMission(CampaignOptions *campaign) {
 	if (campaign->MissionIndex >= (int) campaign->Setting.Missions.size) {
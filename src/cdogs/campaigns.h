@@ -59,6 +59,8 @@ typedef struct {
 	CampaignEntry Entry;
 	int MissionIndex;
 	bool IsLoaded;
+	// Being loaded in the background; see CampaignLoadBegin
+	bool IsLoading;
 	// TODO: it may be possible to completely remove IsClient and rely on
 	// protocol definitions
 	bool IsClient;
@@ -50,6 +50,26 @@ typedef struct {
 	CharBot *bot;
 } Character;
 
+// Masked sprite sets for drawing a character
+// Looking these up requires formatting names and hashing them, so they are
+// stored here and only looked up again when the appearance changes
+typedef struct {
+	// The sprites below are only valid for this appearance
+	const CharacterClass *Class;
+	const char *Hair;
+	const char *GunSprites;
+	CharColors Colors;
+
+	// NULL if not yet looked up
+	const NamedSprites *HeadSprites;
+	const NamedSprites *HairSprites;
+	// Indexed by ActorAnimation and whether armed
+	const NamedSprites *BodySprites[2][2];
+	// Indexed by ActorAnimation
+	const NamedSprites *LegsSprites[2];
+	const NamedSprites *GunSpritesMasked;
+} CharacterSpritesCache;
+
 typedef struct {
 	CArray OtherChars;	// of Character, both normal baddies and special chars
 
@@ -28,6 +28,7 @@
  */
 #include "character_class.h"
 
+#include "asset_pack.h"
 #include "json_utils.h"
 #include "log.h"
 
@@ -378,7 +379,7 @@ void CharacterClassesInitialize(CharacterClasses *c, const char *filename) {
 
 	char buf[CDOGS_PATH_MAX];
 	GetDataFilePath(buf, filename);
-	FILE *f = fopen(buf, "r");
+	FILE *f = AssetFOpen(buf, "r");
 	json_t *root = NULL;
 	// TODO this goto should go
 	enum json_error e;
@@ -756,6 +756,11 @@ Config ConfigDefault(void) {
 	ConfigGroupAdd(&root, qp);
 
 	ConfigGroupAdd(&root, ConfigNewBool("StartServer", false));
+	// Tiles around a client's players outside which cosmetic events aren't
+	// sent to them; 0 to send everything. It is raised to cover the biggest
+	// view a client can have.
+	ConfigGroupAdd(&root,
+			ConfigNewInt("NetRelevanceRange", 24, 0, 100, 1, NULL, NULL));
 
 	return root;
 }
@@ -29,6 +29,7 @@
 
 #include <tinydir/tinydir.h>
 
+#include "asset_pack.h"
 #include "c_array.h"
 #include "log.h"
 #include "sys_config.h"
@@ -59,9 +60,17 @@ void CharSpriteClassesInit(CharSpriteClasses *c) {
 }
 
 static CharSprites* CharSpritesLoadJSON(const char *name, const char *path);
+static void CharSpriteClassAdd(map_t classes, const char *name,
+		const char *path);
+static void CharSpriteClassesLoadPack(map_t classes, const char *path);
 void CharSpriteClassesLoadDir(map_t classes, const char *path) {
 	char buf[CDOGS_PATH_MAX];
 	sprintf(buf, "%s/graphics/chars/bodies", path);
+	AssetPackDir pd;
+	if (AssetPackDirOpen(&pd, &gAssetPack, buf)) {
+		CharSpriteClassesLoadPack(classes, buf);
+		return;
+	}
 	tinydir_dir dir;
 	if (tinydir_open(&dir, buf) == -1) {
 		goto bail;
@@ -77,19 +86,46 @@ void CharSpriteClassesLoadDir(map_t classes, const char *path) {
 		if (!file.is_dir || file.name[0] == '.') {
 			continue;
 		}
-		CharSprites *c = CharSpritesLoadJSON(file.name, file.path);
-		if (c == NULL) {
+		CharSpriteClassAdd(classes, file.name, file.path);
+	}
+
+	bail: tinydir_close(&dir);
+}
+static void CharSpriteClassesLoadPack(map_t classes, const char *path) {
+	// The pack only lists files; each class is a dir of them, and the files
+	// of each dir are contiguous, so add a class whenever the dir changes
+	AssetPackDir pd;
+	AssetPackDirOpen(&pd, &gAssetPack, path);
+	char last[CDOGS_PATH_MAX] = "";
+	while (AssetPackDirNext(&pd)) {
+		const char *slash = strchr(pd.Name, '/');
+		if (slash == NULL) {
 			continue;
 		}
-		const int error = hashmap_put(classes, file.name, c);
-		if (error != MAP_OK) {
-			LOG(LM_MAIN, LL_ERROR, "failed to add char sprites %s: %d",
-					file.name, error);
+		char name[CDOGS_PATH_MAX];
+		const size_t len = slash - pd.Name;
+		strncpy(name, pd.Name, len);
+		name[len] = '\0';
+		if (name[0] == '.' || strcmp(name, last) == 0) {
 			continue;
 		}
+		strcpy(last, name);
+		char buf[CDOGS_PATH_MAX];
+		sprintf(buf, "%s/%s", path, name);
+		CharSpriteClassAdd(classes, name, buf);
+	}
+}
+static void CharSpriteClassAdd(map_t classes, const char *name,
+		const char *path) {
+	CharSprites *c = CharSpritesLoadJSON(name, path);
+	if (c == NULL) {
+		return;
+	}
+	const int error = hashmap_put(classes, name, c);
+	if (error != MAP_OK) {
+		LOG(LM_MAIN, LL_ERROR, "failed to add char sprites %s: %d", name,
+				error);
 	}
-
-	bail: tinydir_close(&dir);
 }
 static map_t LoadFrameOffsets(yajl_val node, const char *path);
 static void LoadDirOffsets(struct vec2 *offsets, yajl_val node,
@@ -97,12 +133,12 @@ static void LoadDirOffsets(struct vec2 *offsets, yajl_val node,
 static CharSprites* CharSpritesLoadJSON(const char *name, const char *path) {
 	CharSprites *c = NULL;
 	// Try to find a data.json in this dir
-	tinydir_file dataFile;
+	int64_t mtime, size;
 	yajl_val node = NULL; // TODO because of goto statment removed const
 	char buf[CDOGS_PATH_MAX];
 	sprintf(buf, "%s/data.json", path);
 	yajl_array order;
-	if (tinydir_file_open(&dataFile, buf) != 0) {
+	if (!AssetStat(buf, &mtime, &size)) {
 		goto bail;
 	}
 	node = YAJLReadFile(buf);
@@ -89,6 +89,26 @@ static struct vec2i GetActorDrawOffset(const Pic *pic, const BodyPart part,
 	return offset;
 }
 
+static void CharacterSpritesCacheCheck(CharacterSpritesCache *cache,
+		const Character *c, const char *gunSprites, const CharColors *colors);
+static const NamedSprites* GetHeadSprites(CharacterSpritesCache *cache);
+static const NamedSprites* GetHairSprites(CharacterSpritesCache *cache);
+static const NamedSprites* GetBodySprites(CharacterSpritesCache *cache,
+		const ActorAnimation anim, const bool isArmed);
+static const NamedSprites* GetLegsSprites(CharacterSpritesCache *cache,
+		const ActorAnimation anim);
+static const NamedSprites* GetGunSprites(CharacterSpritesCache *cache);
+static const Pic* HeadPicFromSprites(const NamedSprites *ns,
+		const direction_e dir, const gunstate_e gunState);
+static const Pic* BodyPicFromSprites(const NamedSprites *ns,
+		const direction_e dir, const ActorAnimation anim, const int frame);
+static const Pic* GunPicFromSprites(const NamedSprites *ns,
+		const direction_e dir, const gunstate_e gunState);
+static ActorPics GetCharacterPicsCached(CharacterSpritesCache *cache,
+		const Character *c, const direction_e dir, const direction_e legDir,
+		const ActorAnimation anim, const int frame, const char *gunSprites,
+		const gunstate_e gunState, const color_t shadowMask,
+		const color_t *mask, const CharColors *colors, const int deadPic);
 static Character* ActorGetCharacterMutable(TActor *a);
 static direction_e GetLegDirAndFrame(const TActor *a, const direction_e bodyDir,
 		int *frame);
@@ -133,24 +153,46 @@ ActorPics GetCharacterPicsFromActor(TActor *a) {
 	const direction_e dir = RadiansToDirection(a->DrawRadians);
 	int frame;
 	const direction_e legDir = GetLegDirAndFrame(a, dir, &frame);
-	return GetCharacterPics(c, dir, legDir, a->anim.Type, frame,
-			gun->Gun != NULL ? gun->Gun->Sprites : NULL, gun->state, shadowMask,
-			maskP, colors, a->dead);
+	return GetCharacterPicsCached(&a->spritesCache, c, dir, legDir,
+			a->anim.Type, frame, gun->Gun != NULL ? gun->Gun->Sprites : NULL,
+			gun->state, shadowMask, maskP, colors, a->dead);
+}
+void ActorLoadSprites(TActor *a) {
+	const Character *c = ActorGetCharacter(a);
+	if (c->Class == NULL) {
+		return;
+	}
+	const Weapon *gun = ACTOR_GET_WEAPON(a);
+	CharacterSpritesCache *cache = &a->spritesCache;
+	CharacterSpritesCacheCheck(cache, c,
+			gun->Gun != NULL ? gun->Gun->Sprites : NULL, &c->Colors);
+	GetHeadSprites(cache);
+	if (c->Class->HasHair) {
+		GetHairSprites(cache);
+	}
+	for (int anim = 0; anim < 2; anim++) {
+		GetBodySprites(cache, (ActorAnimation) anim, false);
+		GetBodySprites(cache, (ActorAnimation) anim, true);
+		GetLegsSprites(cache, (ActorAnimation) anim);
+	}
+	GetGunSprites(cache);
 }
-static const Pic* GetBodyPic(PicManager *pm, const CharSprites *cs,
-		const direction_e dir, const ActorAnimation anim, const int frame,
-		const bool isArmed, const CharColors *colors);
-static const Pic* GetLegsPic(PicManager *pm, const CharSprites *cs,
-		const direction_e dir, const ActorAnimation anim, const int frame,
-		const CharColors *colors);
-static const Pic* GetGunPic(PicManager *pm, const char *gunSprites,
-		const direction_e dir, const int gunState, const CharColors *colors);
 static const Pic* GetDeathPic(PicManager *pm, const int frame);
 ActorPics GetCharacterPics(const Character *c, const direction_e dir,
 		const direction_e legDir, const ActorAnimation anim, const int frame,
 		const char *gunSprites, const gunstate_e gunState,
 		const color_t shadowMask, const color_t *mask, const CharColors *colors,
 		const int deadPic) {
+	CharacterSpritesCache cache;
+	memset(&cache, 0, sizeof cache);
+	return GetCharacterPicsCached(&cache, c, dir, legDir, anim, frame,
+			gunSprites, gunState, shadowMask, mask, colors, deadPic);
+}
+static ActorPics GetCharacterPicsCached(CharacterSpritesCache *cache,
+		const Character *c, const direction_e dir, const direction_e legDir,
+		const ActorAnimation anim, const int frame, const char *gunSprites,
+		const gunstate_e gunState, const color_t shadowMask,
+		const color_t *mask, const CharColors *colors, const int deadPic) {
 	ActorPics pics;
 	memset(&pics, 0, sizeof pics);
 
@@ -184,6 +226,7 @@ ActorPics GetCharacterPics(const Character *c, const direction_e dir,
 	if (colors == NULL) {
 		colors = &c->Colors;
 	}
+	CharacterSpritesCacheCheck(cache, c, gunSprites, colors);
 
 	// Head
 	direction_e headDir = dir;
@@ -195,11 +238,12 @@ ActorPics GetCharacterPics(const Character *c, const direction_e dir,
 			headDir = static_cast<direction_e>((dir + 1) % 8);
 		}
 	}
-	pics.Head = GetHeadPic(c->Class, headDir, gunState, colors);
+	pics.Head = HeadPicFromSprites(GetHeadSprites(cache), headDir, gunState);
 	pics.HeadOffset = GetActorDrawOffset(pics.Head, BODY_PART_HEAD,
 			c->Class->Sprites, anim, frame, dir, gunState);
 	if (c->Class->HasHair) {
-		pics.Hair = GetHairPic(c->Hair, headDir, gunState, colors);
+		pics.Hair = HeadPicFromSprites(GetHairSprites(cache), headDir,
+				gunState);
 	}
 	pics.HairOffset = GetActorDrawOffset(pics.Hair, BODY_PART_HAIR,
 			c->Class->Sprites, anim, frame, dir, gunState);
@@ -207,7 +251,7 @@ ActorPics GetCharacterPics(const Character *c, const direction_e dir,
 	// Gun
 	pics.Gun = NULL;
 	if (gunSprites != NULL) {
-		pics.Gun = GetGunPic(&gPicManager, gunSprites, dir, gunState, colors);
+		pics.Gun = GunPicFromSprites(GetGunSprites(cache), dir, gunState);
 		if (pics.Gun != NULL) {
 			pics.GunOffset = GetActorDrawOffset(pics.Gun, BODY_PART_GUN,
 					c->Class->Sprites, anim, frame, dir, gunState);
@@ -216,14 +260,14 @@ ActorPics GetCharacterPics(const Character *c, const direction_e dir,
 	const bool isArmed = pics.Gun != NULL;
 
 	// Body
-	pics.Body = GetBodyPic(&gPicManager, c->Class->Sprites, dir, anim, frame,
-			isArmed, colors);
+	pics.Body = BodyPicFromSprites(GetBodySprites(cache, anim, isArmed), dir,
+			anim, frame);
 	pics.BodyOffset = GetActorDrawOffset(pics.Body, BODY_PART_BODY,
 			c->Class->Sprites, anim, frame, dir, gunState);
 
 	// Legs
-	pics.Legs = GetLegsPic(&gPicManager, c->Class->Sprites, legDir, anim, frame,
-			colors);
+	pics.Legs = BodyPicFromSprites(GetLegsSprites(cache, anim), legDir, anim,
+			frame);
 	pics.LegsOffset = GetActorDrawOffset(pics.Legs, BODY_PART_LEGS,
 			c->Class->Sprites, anim, frame, legDir, gunState);
 
@@ -354,71 +398,114 @@ static void DrawLaserSightSingle(const struct vec2i from, const float radians,
 	DrawLine(from, to, color);
 }
 
+static void CharacterSpritesCacheCheck(CharacterSpritesCache *cache,
+		const Character *c, const char *gunSprites, const CharColors *colors) {
+	if (cache->Class != c->Class || cache->Hair != c->Hair
+			|| memcmp(&cache->Colors, colors, sizeof *colors) != 0) {
+		memset(cache, 0, sizeof *cache);
+		cache->Class = c->Class;
+		cache->Hair = c->Hair;
+		cache->Colors = *colors;
+	}
+	// Guns change more often; only the gun sprites need to be looked up again
+	if (cache->GunSprites != gunSprites) {
+		cache->GunSprites = gunSprites;
+		cache->GunSpritesMasked = NULL;
+	}
+}
+static const NamedSprites* GetHeadSprites(CharacterSpritesCache *cache) {
+	if (cache->HeadSprites == NULL) {
+		cache->HeadSprites = PicManagerGetCharSprites(&gPicManager,
+				cache->Class->HeadSprites, &cache->Colors);
+	}
+	return cache->HeadSprites;
+}
+static const NamedSprites* GetHairSpritesByName(const char *hair,
+		const CharColors *colors);
+static const NamedSprites* GetHairSprites(CharacterSpritesCache *cache) {
+	if (cache->HairSprites == NULL) {
+		cache->HairSprites = GetHairSpritesByName(cache->Hair, &cache->Colors);
+	}
+	return cache->HairSprites;
+}
+static const NamedSprites* GetHairSpritesByName(const char *hair,
+		const CharColors *colors) {
+	if (hair == NULL) {
+		return NULL;
+	}
+	char buf[CDOGS_PATH_MAX];
+	sprintf(buf, "chars/hairs/%s", hair);
+	return PicManagerGetCharSprites(&gPicManager, buf, colors);
+}
+static const NamedSprites* GetBodySprites(CharacterSpritesCache *cache,
+		const ActorAnimation anim, const bool isArmed) {
+	const NamedSprites **ns = &cache->BodySprites[anim][isArmed ? 1 : 0];
+	if (*ns == NULL) {
+		char buf[CDOGS_PATH_MAX];
+		sprintf(buf, "chars/bodies/%s/upper_%s%s", cache->Class->Sprites->Name,
+				anim == ACTORANIMATION_IDLE ? "idle" : "run",
+				isArmed ? "_handgun" : ""); // TODO: other gun holding poses
+		*ns = PicManagerGetCharSprites(&gPicManager, buf, &cache->Colors);
+	}
+	return *ns;
+}
+static const NamedSprites* GetLegsSprites(CharacterSpritesCache *cache,
+		const ActorAnimation anim) {
+	const NamedSprites **ns = &cache->LegsSprites[anim];
+	if (*ns == NULL) {
+		char buf[CDOGS_PATH_MAX];
+		sprintf(buf, "chars/bodies/%s/legs_%s", cache->Class->Sprites->Name,
+				anim == ACTORANIMATION_IDLE ? "idle" : "run");
+		*ns = PicManagerGetCharSprites(&gPicManager, buf, &cache->Colors);
+	}
+	return *ns;
+}
+static const NamedSprites* GetGunSprites(CharacterSpritesCache *cache) {
+	if (cache->GunSpritesMasked == NULL && cache->GunSprites != NULL) {
+		cache->GunSpritesMasked = PicManagerGetCharSprites(&gPicManager,
+				cache->GunSprites, &cache->Colors);
+	}
+	return cache->GunSpritesMasked;
+}
+
 const Pic* GetHeadPic(const CharacterClass *c, const direction_e dir,
 		const gunstate_e gunState, const CharColors *colors) {
-	// If firing, draw the firing head pic
-	const int row =
-			(gunState == GUNSTATE_FIRING || gunState == GUNSTATE_RECOIL) ?
-					1 : 0;
-	const int idx = (int) dir + row * 8;
 	// Get or generate masked sprites
 	const NamedSprites *ns = PicManagerGetCharSprites(&gPicManager,
 			c->HeadSprites, colors);
-	return static_cast<const Pic*>(CArrayGet(&ns->pics, idx));
+	return HeadPicFromSprites(ns, dir, gunState);
 }
 const Pic* GetHairPic(const char *hair, const direction_e dir,
 		const gunstate_e gunState, const CharColors *colors) {
-	if (hair == NULL) {
+	return HeadPicFromSprites(GetHairSpritesByName(hair, colors), dir,
+			gunState);
+}
+static const Pic* HeadPicFromSprites(const NamedSprites *ns,
+		const direction_e dir, const gunstate_e gunState) {
+	if (ns == NULL) {
 		return NULL;
 	}
+	// If firing, draw the firing head pic
 	const int row =
 			(gunState == GUNSTATE_FIRING || gunState == GUNSTATE_RECOIL) ?
 					1 : 0;
 	const int idx = (int) dir + row * 8;
-	// Get or generate masked sprites
-	char buf[CDOGS_PATH_MAX];
-	sprintf(buf, "chars/hairs/%s", hair);
-	const NamedSprites *ns = PicManagerGetCharSprites(&gPicManager, buf,
-			colors);
 	return static_cast<const Pic*>(CArrayGet(&ns->pics, idx));
 }
-static const Pic* GetBodyPic(PicManager *pm, const CharSprites *cs,
-		const direction_e dir, const ActorAnimation anim, const int frame,
-		const bool isArmed, const CharColors *colors) {
+static const Pic* BodyPicFromSprites(const NamedSprites *ns,
+		const direction_e dir, const ActorAnimation anim, const int frame) {
 	const int stride = anim == ACTORANIMATION_IDLE ? 1 : 8;
 	const int col = frame % stride;
 	const int row = (int) dir;
 	const int idx = col + row * stride;
-	char buf[CDOGS_PATH_MAX];
-	sprintf(buf, "chars/bodies/%s/upper_%s%s", cs->Name,
-			anim == ACTORANIMATION_IDLE ? "idle" : "run",
-			isArmed ? "_handgun" : ""); // TODO: other gun holding poses
-	// Get or generate masked sprites
-	const NamedSprites *ns = PicManagerGetCharSprites(pm, buf, colors);
-	return static_cast<const Pic*>(CArrayGet(&ns->pics, idx));
-}
-static const Pic* GetLegsPic(PicManager *pm, const CharSprites *cs,
-		const direction_e dir, const ActorAnimation anim, const int frame,
-		const CharColors *colors) {
-	const int stride = anim == ACTORANIMATION_IDLE ? 1 : 8;
-	const int col = frame % stride;
-	const int row = (int) dir;
-	const int idx = col + row * stride;
-	char buf[CDOGS_PATH_MAX];
-	sprintf(buf, "chars/bodies/%s/legs_%s", cs->Name,
-			anim == ACTORANIMATION_IDLE ? "idle" : "run");
-	// Get or generate masked sprites
-	const NamedSprites *ns = PicManagerGetCharSprites(pm, buf, colors);
 	return static_cast<const Pic*>(CArrayGet(&ns->pics, idx));
 }
-static const Pic* GetGunPic(PicManager *pm, const char *gunSprites,
-		const direction_e dir, const int gunState, const CharColors *colors) {
-	const int idx = (gunState == GUNSTATE_READY ? 8 : 0) + dir;
-	// Get or generate masked sprites
-	const NamedSprites *ns = PicManagerGetCharSprites(pm, gunSprites, colors);
+static const Pic* GunPicFromSprites(const NamedSprites *ns,
+		const direction_e dir, const gunstate_e gunState) {
 	if (ns == NULL) {
 		return NULL;
 	}
+	const int idx = (gunState == GUNSTATE_READY ? 8 : 0) + dir;
 	return static_cast<const Pic*>(CArrayGet(&ns->pics, idx));
 }
 static const Pic* GetDeathPic(PicManager *pm, const int frame) {
@@ -89,6 +89,8 @@ ActorPics GetCharacterPics(const Character *c, const direction_e dir,
 		const color_t shadowMask, const color_t *mask, const CharColors *colors,
 		const int deadPic);
 ActorPics GetCharacterPicsFromActor(TActor *a);
+// Look up all the masked sprites the actor needs in advance
+void ActorLoadSprites(TActor *a);
 void DrawActorPics(const ActorPics *pics, const struct vec2i pos,
 		const Rect2i bounds);
 void DrawLaserSight(const ActorPics *pics, const TActor *a,
@@ -34,13 +34,17 @@
 #include <SDL2/SDL_image.h>
 #endif
 
+#include "asset_pack.h"
 #include "blit.h"
+#include "log.h"
 #include "pic.h"
 #include "sys_config.h"
 #include "utils.h"
 
 #define FIRST_CHAR 0
 #define LAST_CHAR 255
+// Must be a power of 2
+#define FONT_RUN_CACHE_SIZE 256
 
 Font gFont;
 
@@ -51,11 +55,15 @@ FontOpts FontOptsNew(void) {
 	return opts;
 }
 
+static void FontAtlasTerminate(Font *f);
+static void FontAtlasMake(Font *f, const struct vec2i spaceSize);
 void FontLoad(Font *f, const char *imgPath, const bool isProportional,
 		const struct vec2i spaceSize) {
+	// The font is reloaded when the renderer is recreated
+	FontAtlasTerminate(f);
 	char buf[CDOGS_PATH_MAX];
 	GetDataFilePath(buf, imgPath);
-	SDL_RWops *rwops = SDL_RWFromFile(buf, "rb");
+	SDL_RWops *rwops = AssetRWFromFile(buf);
 	CASSERT(IMG_isPNG(rwops), "Error: font file is not PNG");
 	SDL_Surface *image = IMG_Load_RW(rwops, 0);
 	rwops->close(rwops);
@@ -108,13 +116,53 @@ void FontLoad(Font *f, const char *imgPath, const bool isProportional,
 	}
 	SDL_UnlockSurface(image);
 
+	FontAtlasMake(f, spaceSize);
+
 	bail: SDL_FreeSurface(image);
 }
+static void FontAtlasMake(Font *f, const struct vec2i spaceSize) {
+	// Pack the chars into a grid, one cell per char
+	const struct vec2i cell = svec2i_max(f->Size, spaceSize);
+	const int rows = ((int) f->Chars.size + f->Stride - 1) / f->Stride;
+	memset(&f->Atlas, 0, sizeof f->Atlas);
+	f->Atlas.size = svec2i(cell.x * f->Stride, cell.y * rows);
+	CCALLOC(f->Atlas.Data,
+			f->Atlas.size.x * f->Atlas.size.y * sizeof *f->Atlas.Data);
+	CArrayInit(&f->Glyphs, sizeof(Rect2i));
+	CA_FOREACH(const Pic, p, f->Chars)
+		const Rect2i src = Rect2iNew(
+				svec2i(_ca_index % f->Stride * cell.x,
+						_ca_index / f->Stride * cell.y), p->size);
+		for (int y = 0; y < p->size.y; y++) {
+			memcpy(f->Atlas.Data + src.Pos.x
+					+ (src.Pos.y + y) * f->Atlas.size.x,
+					p->Data + y * p->size.x, p->size.x * sizeof *p->Data);
+		}
+		CArrayPushBack(&f->Glyphs, &src);
+	CA_FOREACH_END()
+	PicTryMakeTex(&f->Atlas);
+
+	CCALLOC(f->Runs, FONT_RUN_CACHE_SIZE * sizeof *f->Runs);
+}
+static void FontAtlasTerminate(Font *f) {
+	if (f->Runs == NULL) {
+		return;
+	}
+	for (int i = 0; i < FONT_RUN_CACHE_SIZE; i++) {
+		CFREE(f->Runs[i].Str);
+		CArrayTerminate(&f->Runs[i].Quads);
+	}
+	CFREE(f->Runs);
+	f->Runs = NULL;
+	CArrayTerminate(&f->Glyphs);
+	PicFree(&f->Atlas);
+}
 void FontTerminate(Font *f) {
 	CA_FOREACH(Pic, p, f->Chars)
 		PicFree(p);
 	CA_FOREACH_END()
 	CArrayTerminate(&f->Chars);
+	FontAtlasTerminate(f);
 }
 
 int FontW(const char c) {
@@ -178,8 +226,7 @@ int FontStrNumLines(const char *s) {
 struct vec2i FontCh(const char c, const struct vec2i pos) {
 	return FontChMask(c, pos, colorWhite);
 }
-struct vec2i FontChMask(const char c, const struct vec2i pos,
-		const color_t mask) {
+static int FontCharIndex(const char c) {
 	int idx = (int) c - FIRST_CHAR;
 	if (idx < 0) {
 		idx += 256;
@@ -188,12 +235,21 @@ struct vec2i FontChMask(const char c, const struct vec2i pos,
 		fprintf(stderr, "invalid char %d\n", idx);
 		idx = FIRST_CHAR;
 	}
-	const Pic *pic = static_cast<const Pic*>(CArrayGet(&gFont.Chars, idx));
+	return idx;
+}
+struct vec2i FontChMask(const char c, const struct vec2i pos,
+		const color_t mask) {
+	const Pic *pic = static_cast<const Pic*>(CArrayGet(&gFont.Chars,
+			FontCharIndex(c)));
 	PicRender(pic, gGraphicsDevice.gameWindow.renderer, pos, mask, 0,
 			svec2_one(), SDL_FLIP_NONE, Rect2iZero());
 	// Add gap between characters
 	return svec2i(pos.x + pic->size.x + gFont.Gap.x, pos.y);
 }
+static const FontRun* FontRunGet(const char *s, const FontOpts opts,
+		const int width);
+static void FontRunDraw(const FontRun *run, const struct vec2i pos,
+		const color_t mask);
 struct vec2i FontStr(const char *s, struct vec2i pos) {
 	return FontStrMask(s, pos, colorWhite);
 }
@@ -201,33 +257,136 @@ struct vec2i FontStrMask(const char *s, struct vec2i pos, const color_t mask) {
 	if (s == NULL) {
 		return pos;
 	}
-	int left = pos.x;
-	while (*s) {
-		if (*s == '\n') {
-			pos.x = left;
-			pos.y += FontH();
-		} else {
-			pos = FontChMask(*s, pos, mask);
-		}
-		s++;
-	}
-	return pos;
+	const FontRun *run = FontRunGet(s, FontOptsNew(), 0);
+	FontRunDraw(run, pos, mask);
+	return svec2i_add(pos, run->End);
 }
 struct vec2i FontStrMaskWrap(const char *s, struct vec2i pos, color_t mask,
 		const int width) {
-	char buf[1024];
-	CASSERT(strlen(s) < 1024, "string too long to wrap");
-	FontSplitLines(s, buf, width);
-	return FontStrMask(buf, pos, mask);
+	const FontRun *run = FontRunGet(s, FontOptsNew(), width);
+	FontRunDraw(run, pos, mask);
+	return svec2i_add(pos, run->End);
 }
-static struct vec2i GetStrPos(const char *s, struct vec2i pos,
-		const FontOpts opts);
 void FontStrOpt(const char *s, struct vec2i pos, const FontOpts opts) {
 	if (s == NULL) {
 		return;
 	}
-	pos = GetStrPos(s, pos, opts);
-	FontStrMask(s, pos, opts.Mask);
+	FontRunDraw(FontRunGet(s, opts, 0), pos, opts.Mask);
+}
+static uint32_t FontRunHash(const char *s, const FontOpts opts,
+		const int width);
+static bool FontRunIsMatch(const FontRun *run, const char *s,
+		const uint32_t hash, const FontOpts opts, const int width);
+static void FontRunLayout(FontRun *run, const char *s, const FontOpts opts);
+static struct vec2i GetStrPos(const char *s, struct vec2i pos,
+		const FontOpts opts);
+static const FontRun* FontRunGet(const char *s, const FontOpts opts,
+		const int width) {
+	// If the font failed to load there is nothing to lay out or draw
+	static const FontRun emptyRun = { 0 };
+	if (gFont.Runs == NULL) {
+		return &emptyRun;
+	}
+	const uint32_t hash = FontRunHash(s, opts, width);
+	FontRun *run = &gFont.Runs[hash & (FONT_RUN_CACHE_SIZE - 1)];
+	if (FontRunIsMatch(run, s, hash, opts, width)) {
+		return run;
+	}
+
+	// Miss; replace whatever was in this slot
+	CFREE(run->Str);
+	CSTRDUP(run->Str, s);
+	run->Hash = hash;
+	run->Width = width;
+	run->HAlign = opts.HAlign;
+	run->VAlign = opts.VAlign;
+	run->Area = opts.Area;
+	run->Pad = opts.Pad;
+	if (run->Quads.elemSize == 0) {
+		CArrayInit(&run->Quads, sizeof(FontGlyphQuad));
+	}
+	CArrayClear(&run->Quads);
+	if (width > 0) {
+		char buf[1024];
+		CASSERT(strlen(s) < 1024, "string too long to wrap");
+		FontSplitLines(s, buf, width);
+		FontRunLayout(run, buf, opts);
+	} else {
+		FontRunLayout(run, s, opts);
+	}
+	return run;
+}
+static uint32_t FontRunHash(const char *s, const FontOpts opts,
+		const int width) {
+	// FNV-1a
+	uint32_t hash = 2166136261u;
+	for (; *s; s++) {
+		hash = (hash ^ (uint8_t) *s) * 16777619u;
+	}
+	const int keys[] = { width, (int) opts.HAlign, (int) opts.VAlign,
+			opts.Area.x, opts.Area.y, opts.Pad.x, opts.Pad.y };
+	for (int i = 0; i < (int) (sizeof keys / sizeof keys[0]); i++) {
+		hash = (hash ^ (uint32_t) keys[i]) * 16777619u;
+	}
+	return hash;
+}
+static bool FontRunIsMatch(const FontRun *run, const char *s,
+		const uint32_t hash, const FontOpts opts, const int width) {
+	return run->Str != NULL && run->Hash == hash && run->Width == width
+			&& run->HAlign == opts.HAlign && run->VAlign == opts.VAlign
+			&& svec2i_is_equal(run->Area, opts.Area)
+			&& svec2i_is_equal(run->Pad, opts.Pad) && strcmp(run->Str, s) == 0;
+}
+static int FontCharIndex(const char c);
+static void FontRunLayout(FontRun *run, const char *s, const FontOpts opts) {
+	// Alignment only depends on the text size, so it is an offset from the
+	// draw position
+	const struct vec2i origin = GetStrPos(s, svec2i_zero(), opts);
+	struct vec2i pos = origin;
+	for (; *s; s++) {
+		if (*s == '\n') {
+			pos.x = origin.x;
+			pos.y += FontH();
+			continue;
+		}
+		const Rect2i *src = static_cast<const Rect2i*>(CArrayGet(&gFont.Glyphs,
+				FontCharIndex(*s)));
+		FontGlyphQuad q;
+		q.Src = *src;
+		q.Pos = pos;
+		CArrayPushBack(&run->Quads, &q);
+		// Add gap between characters
+		pos.x += src->Size.x + gFont.Gap.x;
+	}
+	run->End = pos;
+}
+static void FontRunDraw(const FontRun *run, const struct vec2i pos,
+		const color_t mask) {
+	SDL_Texture *t = gFont.Atlas.Tex;
+	if (t == NULL || run->Quads.size == 0) {
+		return;
+	}
+	// All the glyphs come from one texture with the same modulation, so the
+	// renderer can submit the string as a single batch
+	if (SDL_SetTextureColorMod(t, mask.r, mask.g, mask.b) != 0) {
+		LOG(LM_MAIN, LL_ERROR, "Failed to set texture mask: %s",
+				SDL_GetError());
+	}
+	if (SDL_SetTextureAlphaMod(t, mask.a) != 0) {
+		LOG(LM_MAIN, LL_ERROR, "Failed to set texture alpha: %s",
+				SDL_GetError());
+	}
+	SDL_Renderer *r = gGraphicsDevice.gameWindow.renderer;
+	CA_FOREACH(const FontGlyphQuad, q, run->Quads)
+		const SDL_Rect src = { q->Src.Pos.x, q->Src.Pos.y, q->Src.Size.x,
+				q->Src.Size.y };
+		const SDL_Rect dest = { pos.x + q->Pos.x, pos.y + q->Pos.y,
+				q->Src.Size.x, q->Src.Size.y };
+		if (SDL_RenderCopy(r, t, &src, &dest) != 0) {
+			LOG(LM_MAIN, LL_ERROR, "Failed to render texture: %s",
+					SDL_GetError());
+		}
+	CA_FOREACH_END()
 }
 static int GetAlign(const FontAlign align, const int pos, const int pad,
 		const int area, const int size);
@@ -28,10 +28,35 @@
 #include <SDL2/SDL_surface.h>
 
 #include "c_array.h"
+#include "pic.h"
 #include "vector.h"
 
 // Defines interfaces for bitmap fonts
 
+typedef enum {
+	ALIGN_START = 0, ALIGN_CENTER, ALIGN_END
+} FontAlign;
+
+typedef struct {
+	Rect2i Src;	// in the font atlas
+	struct vec2i Pos;	// relative to the run's origin
+} FontGlyphQuad;
+
+// A string that has been laid out into glyph quads, so that it can be drawn
+// in one pass over the font atlas without measuring or splitting it again
+typedef struct {
+	char *Str;
+	uint32_t Hash;
+	// Layout options; the colour mask is applied at draw time
+	int Width;	// wrap width, 0 for no wrapping
+	FontAlign HAlign;
+	FontAlign VAlign;
+	struct vec2i Area;
+	struct vec2i Pad;
+	struct vec2i End;	// cursor position after the last glyph
+	CArray Quads;	// of FontGlyphQuad
+} FontRun;
+
 typedef struct {
 	struct vec2i Size;
 	int Stride;
@@ -43,11 +68,12 @@ typedef struct {
 	} Padding;
 	struct vec2i Gap;
 	CArray Chars;	// of Pic
+	// All the chars packed into one texture, for drawing whole strings
+	Pic Atlas;
+	CArray Glyphs;	// of Rect2i, the atlas source of each char
+	FontRun *Runs;	// direct-mapped cache of recently drawn strings
 } Font;
 
-typedef enum {
-	ALIGN_START = 0, ALIGN_CENTER, ALIGN_END
-} FontAlign;
 typedef struct {
 	FontAlign HAlign;
 	FontAlign VAlign;
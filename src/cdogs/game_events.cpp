@@ -79,10 +79,13 @@ static GameEventEntry sGameEventEntries[] =
 
 				{ GAME_EVENT_ACTOR_ADD, true, false, true, true,
 						NActorAdd_fields }, { GAME_EVENT_ACTOR_MOVE, true, true,
-						true, true, NActorMove_fields }, {
+						true, true, NActorMove_fields,
+						DELIVERY_UNRELIABLE_SEQUENCED }, {
 						GAME_EVENT_ACTOR_STATE, true, true, true, true,
-						NActorState_fields }, { GAME_EVENT_ACTOR_DIR, true,
-						true, true, true, NActorDir_fields }, {
+						NActorState_fields }, {
+						GAME_EVENT_ACTOR_DIR, true, true, true, true,
+						NActorDir_fields,
+						DELIVERY_UNRELIABLE_SEQUENCED }, {
 						GAME_EVENT_ACTOR_SLIDE, true, true, true, true,
 						NActorSlide_fields }, { GAME_EVENT_ACTOR_IMPULSE, true,
 						false, true, true, NActorImpulse_fields }, {
@@ -128,7 +131,16 @@ static GameEventEntry sGameEventEntries[] =
 				{ GAME_EVENT_MISSION_INCOMPLETE, true, false, true, true, NULL },
 				{ GAME_EVENT_MISSION_PICKUP, true, false, true, true, NULL }, {
 						GAME_EVENT_MISSION_END, true, false, true, true,
-						NMissionEnd_fields } };
+						NMissionEnd_fields },
+
+				{ GAME_EVENT_SNAPSHOT, false, false, false, false,
+						NSnapshot_fields, DELIVERY_UNRELIABLE_SEQUENCED }, {
+						GAME_EVENT_SNAPSHOT_ACK, false, false, false, false,
+						NSnapshotAck_fields, DELIVERY_UNRELIABLE_SEQUENCED },
+
+				{ GAME_EVENT_JOIN_CHUNK, false, false, false, true,
+						NJoinChunk_fields },
+				{ GAME_EVENT_JOIN_STATE, false, false, true, true, NULL } };
 GameEventEntry GameEventGetEntry(const GameEventType e) {
 	return sGameEventEntries[(int) e];
 }
@@ -103,9 +103,29 @@ typedef enum {
 	GAME_EVENT_MISSION_INCOMPLETE,
 	// In pickup area
 	GAME_EVENT_MISSION_PICKUP,
-	GAME_EVENT_MISSION_END
+	GAME_EVENT_MISSION_END,
+
+	// Net world state snapshots
+	GAME_EVENT_SNAPSHOT,
+	GAME_EVENT_SNAPSHOT_ACK,
+
+	// Map and world state for clients joining mid-game
+	GAME_EVENT_JOIN_CHUNK,
+	// Join state fully received; applied in order with the other events,
+	// after the map has been built
+	GAME_EVENT_JOIN_STATE
 } GameEventType;
 
+// How game events are delivered over the network; each class is sent on its
+// own ENet channel, so that lost state updates don't stall other events
+typedef enum {
+	DELIVERY_RELIABLE,
+	// Resent every tick or corrected by the next snapshot, so late or lost
+	// ones are dropped rather than resent
+	DELIVERY_UNRELIABLE_SEQUENCED,
+	DELIVERY_COUNT
+} GameEventDelivery;
+
 // Which game events should be passed along to server or client
 typedef struct {
 	GameEventType Type;
@@ -118,6 +138,9 @@ typedef struct {
 	// Whether to broadcast these events only after game start
 	bool GameStart;
 	const pb_field_t *Fields;
+	// How the server sends this event; events that clients submit are
+	// always sent reliably as nothing corrects them if they are lost
+	GameEventDelivery Delivery;
 } GameEventEntry;
 GameEventEntry GameEventGetEntry(const GameEventType e);
 
@@ -54,6 +54,7 @@
 #include <string.h>
 #include <ctype.h>
 
+#include <SDL2/SDL_thread.h>
 #include <tinydir/tinydir.h>
 
 #include "actors.h"
@@ -61,8 +62,11 @@
 #include "defs.h"
 #include "keyboard.h"
 #include "log.h"
+#include "map_archive.h"
+#include "map_new.h"
 #include "music.h"
 #include "objs.h"
+#include "pic_manager.h"
 #include "pickup.h"
 #include "player_template.h"
 #include "quick_play.h"
@@ -76,13 +80,17 @@ struct MissionOptions gMission;
 struct SongDef *gGameSongs = NULL;
 struct SongDef *gMenuSongs = NULL;
 
-bool CampaignLoad(CampaignOptions *co, CampaignEntry *entry) {
-	CASSERT(!co->IsLoaded, "loading campaign without unloading last one");
+static void CampaignLoadInit(CampaignOptions *co, CampaignEntry *entry) {
+	CASSERT(!co->IsLoaded && !co->IsLoading,
+			"loading campaign without unloading last one");
 	// Note: use the mode already set by the menus
 	const GameMode mode = co->Entry.Mode;
 	CampaignEntryCopy(&co->Entry, entry);
 	co->Entry.Mode = mode;
 	CampaignSettingInit(&co->Setting);
+}
+bool CampaignLoad(CampaignOptions *co, CampaignEntry *entry) {
+	CampaignLoadInit(co, entry);
 	if (entry->Mode == GAME_MODE_QUICK_PLAY) {
 		SetupQuickPlayCampaign(&co->Setting);
 		co->IsLoaded = true;
@@ -103,6 +111,145 @@ bool CampaignLoad(CampaignOptions *co, CampaignEntry *entry) {
 	}
 	return co->IsLoaded;
 }
+
+// Only one campaign can be loaded at a time, so the background load state is
+// kept here. An archive's files are read, parsed and decoded on the loader
+// thread. Its custom assets are then added on the render thread a step at a
+// time, as the registries are in use there, followed by the deferred pic
+// textures a batch at a time, so that the loading screen keeps updating.
+// Missions are read on the loader thread too, once the classes they refer to
+// have been added.
+#define CAMPAIGN_LOAD_TEXTURES_PER_POLL 64
+// Share of the progress bar for loading files; the rest is for textures
+#define CAMPAIGN_LOAD_PARSE_PROGRESS 0.8f
+static struct {
+	SDL_Thread *Thread;
+	char Path[CDOGS_PATH_MAX];
+	MapArchiveLoader Loader;
+	SDL_atomic_t IsRead;
+	// Posted by the render thread when the loader can read the missions
+	SDL_sem *CanReadMissions;
+	bool IsMissionsPosted;
+	SDL_atomic_t IsMissionsRead;
+	int TexturesTotal;	// -1 until the assets are loaded
+} sCampaignLoader;
+static int CampaignLoaderRun(void *data);
+bool CampaignLoadBegin(CampaignOptions *co, CampaignEntry *entry) {
+	char buf[CDOGS_PATH_MAX];
+	GetDataFilePath(buf, entry->Path);
+	if (entry->Mode == GAME_MODE_QUICK_PLAY || !MapNewIsArchive(buf)) {
+		// Nothing to load from disk, or a single file without custom assets
+		return CampaignLoad(co, entry);
+	}
+	CampaignLoadInit(co, entry);
+	strcpy(sCampaignLoader.Path, buf);
+	SDL_AtomicSet(&sCampaignLoader.IsRead, 0);
+	sCampaignLoader.IsMissionsPosted = false;
+	SDL_AtomicSet(&sCampaignLoader.IsMissionsRead, 0);
+	sCampaignLoader.TexturesTotal = -1;
+	co->IsLoading = true;
+	gPicManager.deferTextures = true;
+	sCampaignLoader.Thread = NULL;
+	sCampaignLoader.CanReadMissions = SDL_CreateSemaphore(0);
+	if (sCampaignLoader.CanReadMissions != NULL) {
+		sCampaignLoader.Thread = SDL_CreateThread(CampaignLoaderRun,
+				"CampaignLoader", &co->Setting);
+	}
+	if (sCampaignLoader.Thread == NULL) {
+		LOG(LM_MAIN, LL_WARN, "Cannot create campaign loader thread: %s",
+				SDL_GetError());
+		// Read everything on this thread instead, when it is needed
+		MapArchiveLoaderRead(&sCampaignLoader.Loader, sCampaignLoader.Path,
+				&co->Setting);
+		SDL_AtomicSet(&sCampaignLoader.IsRead, 1);
+	}
+	return true;
+}
+static int CampaignLoaderRun(void *data) {
+	CampaignSetting *setting = static_cast<CampaignSetting*>(data);
+	MapArchiveLoader *l = &sCampaignLoader.Loader;
+	MapArchiveLoaderRead(l, sCampaignLoader.Path, setting);
+	SDL_AtomicSet(&sCampaignLoader.IsRead, 1);
+	SDL_SemWait(sCampaignLoader.CanReadMissions);
+	MapArchiveLoaderReadMissions(l);
+	SDL_AtomicSet(&sCampaignLoader.IsMissionsRead, 1);
+	return 0;
+}
+static bool CampaignLoaderReadMissions(MapArchiveLoader *l);
+bool CampaignLoadPoll(CampaignOptions *co, float *progress) {
+	CASSERT(co->IsLoading, "polling campaign that isn't loading");
+	MapArchiveLoader *l = &sCampaignLoader.Loader;
+	if (!SDL_AtomicGet(&sCampaignLoader.IsRead)) {
+		*progress = 0;
+		return false;
+	}
+	if (l->Step == MAP_ARCHIVE_LOAD_STEP_MISSIONS
+			&& !CampaignLoaderReadMissions(l)) {
+		*progress = CAMPAIGN_LOAD_PARSE_PROGRESS * (l->Step + 1)
+				/ (MAP_ARCHIVE_LOAD_STEPS + 1);
+		return false;
+	}
+	// Reading the files counts as the first step
+	if (!MapArchiveLoaderStep(l, &co->Setting)) {
+		*progress = CAMPAIGN_LOAD_PARSE_PROGRESS * (l->Step + 1)
+				/ (MAP_ARCHIVE_LOAD_STEPS + 1);
+		return false;
+	}
+	if (sCampaignLoader.TexturesTotal < 0) {
+		gPicManager.deferTextures = false;
+		sCampaignLoader.TexturesTotal =
+				(int) gPicManager.pendingTextures.size;
+	}
+	const int remaining = PicManagerMakeTextures(&gPicManager,
+			CAMPAIGN_LOAD_TEXTURES_PER_POLL);
+	if (remaining > 0) {
+		*progress = CAMPAIGN_LOAD_PARSE_PROGRESS
+				+ (1.0f - CAMPAIGN_LOAD_PARSE_PROGRESS)
+				* (sCampaignLoader.TexturesTotal - remaining)
+				/ sCampaignLoader.TexturesTotal;
+		return false;
+	}
+	*progress = 1.0f;
+	co->IsLoading = false;
+	// The loader thread may still be waiting if a step failed
+	CampaignLoaderReadMissions(l);
+	if (sCampaignLoader.Thread != NULL) {
+		SDL_WaitThread(sCampaignLoader.Thread, NULL);
+		sCampaignLoader.Thread = NULL;
+	}
+	if (sCampaignLoader.CanReadMissions != NULL) {
+		SDL_DestroySemaphore(sCampaignLoader.CanReadMissions);
+		sCampaignLoader.CanReadMissions = NULL;
+	}
+	const int err = l->Err;
+	MapArchiveLoaderTerminate(l);
+	if (err) {
+		LOG(LM_MAIN, LL_ERROR, "failed to load campaign %s!",
+				sCampaignLoader.Path);
+		CASSERT(false, "Failed to load campaign");
+	} else {
+		co->IsLoaded = true;
+		LOG(LM_MAIN, LL_INFO, "loaded campaign/dogfight");
+	}
+	return true;
+}
+// Let the loader read the missions, now that the classes they refer to have
+// been added; returns whether they have been read
+static bool CampaignLoaderReadMissions(MapArchiveLoader *l) {
+	if (SDL_AtomicGet(&sCampaignLoader.IsMissionsRead)) {
+		return true;
+	}
+	if (sCampaignLoader.Thread == NULL) {
+		MapArchiveLoaderReadMissions(l);
+		SDL_AtomicSet(&sCampaignLoader.IsMissionsRead, 1);
+		return true;
+	}
+	if (!sCampaignLoader.IsMissionsPosted) {
+		SDL_SemPost(sCampaignLoader.CanReadMissions);
+		sCampaignLoader.IsMissionsPosted = true;
+	}
+	return false;
+}
 void CampaignUnload(CampaignOptions *co) {
 	co->IsLoaded = false;
 	co->IsClient = false;	// TODO: select is client from menu
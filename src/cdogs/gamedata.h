@@ -66,6 +66,12 @@
 extern struct MissionOptions gMission;
 
 bool CampaignLoad(CampaignOptions *co, CampaignEntry *entry);
+// Start loading a campaign on a background thread, so that the UI can keep
+// running; call CampaignLoadPoll on the render thread until it's finished
+bool CampaignLoadBegin(CampaignOptions *co, CampaignEntry *entry);
+// Do any render thread work for a campaign being loaded, and get its progress
+// from 0 to 1. Returns true when finished; IsLoaded is set if successful.
+bool CampaignLoadPoll(CampaignOptions *co, float *progress);
 void CampaignUnload(CampaignOptions *co);
 
 void MissionOptionsInit(struct MissionOptions *mo);
@@ -76,6 +76,7 @@ GraphicsDevice gGraphicsDevice;
 
 void GraphicsInit(GraphicsDevice *device, Config *c) {
 	memset(device, 0, sizeof *device);
+	CArrayInit(&device->bufTextures, sizeof(BufTexture));
 	GraphicsConfigSetFromConfig(&device->cachedConfig, c);
 	device->cachedConfig.RestartFlags = RESTART_ALL;
 }
@@ -105,6 +106,11 @@ void GraphicsInitialize(GraphicsDevice *g) {
 			& (RESTART_WINDOW | RESTART_SCALE_MODE));
 	const bool initBrightness = !!(g->cachedConfig.RestartFlags
 			& (RESTART_WINDOW | RESTART_SCALE_MODE | RESTART_BRIGHTNESS));
+	// Every restart recreates some of the textures that buf is uploaded to,
+	// and new ones can reuse the addresses of old ones, so forget them all
+	if (initBrightness) {
+		CArrayClear(&g->bufTextures);
+	}
 
 	if (initWindow) {
 		LOG(LM_GFX, LL_INFO, "graphics mode(%dx%d %dx%s)", w, h,
@@ -184,6 +190,7 @@ void GraphicsInitialize(GraphicsDevice *g) {
 		if (g->buf == NULL && GraphicsGetMemSize(&g->cachedConfig) > 0) {
 			exit(1);
 		}
+		g->bufDirty = Rect2iZero();
 //		CCALLOC(g->buf, GraphicsGetMemSize(&g->cachedConfig));
 		g->bkgTgt = WindowContextCreateTexture(&g->gameWindow,
 				SDL_TEXTUREACCESS_TARGET, svec2i(w, h), SDL_BLENDMODE_NONE, 255,
@@ -274,6 +281,7 @@ void GraphicsTerminate(GraphicsDevice *g) {
 	SDL_FreeFormat(g->Format);
 	SDL_VideoQuit();
 	CFREE(g->buf);
+	CArrayTerminate(&g->bufTextures);
 }
 
 int GraphicsGetScreenSize(GraphicsConfig *config) {
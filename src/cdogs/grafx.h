@@ -74,6 +74,14 @@ typedef struct {
 	int RestartFlags;
 } GraphicsConfig;
 
+// A streaming texture that is updated from the software buffer
+typedef struct {
+	SDL_Texture *Tex;
+	// Region of the texture that may hold pixels uploaded from the buffer;
+	// the rest is known to be empty
+	Rect2i Dirty;
+} BufTexture;
+
 typedef struct {
 	int IsInitialized;
 	int IsWindowInitialized;
@@ -86,6 +94,9 @@ typedef struct {
 	SDL_PixelFormat *Format;
 	GraphicsConfig cachedConfig;
 	Uint32 *buf;
+	// Region of buf that may have been drawn to since it was last cleared
+	Rect2i bufDirty;
+	CArray bufTextures;	// of BufTexture
 	SDL_Texture *bkg;
 	SDL_Texture *bkg2;
 	SDL_Texture *bkgTgt;
@@ -35,6 +35,7 @@
 #include "game_events.h"
 #include "joystick.h"
 #include "log.h"
+#include "net_client.h"
 #include "net_server.h"
 #include "objs.h"
 #include "particle.h"
@@ -66,7 +67,7 @@ static void HandleGameEvent(const GameEvent e, Camera *camera,
 		break;
 	case GAME_EVENT_PLAYER_REMOVE:
 		PlayerRemove(e.u.PlayerRemove.UID);
-		if (gPlayerDatas.size == 0) {
+		if (gPlayerDatas.size == 0 && camera != NULL) {
 			// Waiting for players to join, follow the first one
 			camera->FollowNextPlayer = true;
 		}
@@ -145,6 +146,9 @@ static void HandleGameEvent(const GameEvent e, Camera *camera,
 		}
 		break;
 	case GAME_EVENT_SCREEN_SHAKE:
+		if (camera == NULL) {
+			break;
+		}
 		if (e.u.Shake.CameraSubjectOnly
 				&& e.u.Shake.ActorUID != camera->FollowActorUID) {
 			break;
@@ -157,8 +161,10 @@ static void HandleGameEvent(const GameEvent e, Camera *camera,
 		CA_FOREACH_END()
 		break;
 	case GAME_EVENT_SET_MESSAGE:
-		HUDDisplayMessage(&camera->HUD, e.u.SetMessage.Message,
-				e.u.SetMessage.Ticks);
+		if (camera != NULL) {
+			HUDDisplayMessage(&camera->HUD, e.u.SetMessage.Message,
+					e.u.SetMessage.Ticks);
+		}
 		break;
 	case GAME_EVENT_GAME_START:
 		gMission.HasStarted = true;
@@ -175,7 +181,7 @@ static void HandleGameEvent(const GameEvent e, Camera *camera,
 		break;
 	case GAME_EVENT_ACTOR_STATE: {
 		TActor *a = ActorGetByUID(e.u.ActorState.UID);
-		if (!a->isInUse)
+		if (a == NULL || !a->isInUse)
 			break;
 		a->anim = AnimationGetActorAnimation(
 				(ActorAnimation) e.u.ActorState.State);
@@ -183,7 +189,7 @@ static void HandleGameEvent(const GameEvent e, Camera *camera,
 		break;
 	case GAME_EVENT_ACTOR_DIR: {
 		TActor *a = ActorGetByUID(e.u.ActorDir.UID);
-		if (!a->isInUse)
+		if (a == NULL || !a->isInUse)
 			break;
 		a->direction = (direction_e) e.u.ActorDir.Dir;
 	}
@@ -352,6 +358,8 @@ static void HandleGameEvent(const GameEvent e, Camera *camera,
 	case GAME_EVENT_GUN_FIRE: {
 		const WeaponClass *wc = StrWeaponClass(e.u.GunFire.Gun);
 		const struct vec2 pos = NetToVec2(e.u.GunFire.MuzzlePos);
+		const float angle =
+				NetToRadians(e.u.GunFire.Angle, NET_ANGLE_BITS_GUN_FIRE);
 
 		// Add bullets
 		if (wc->Bullet && !gCampaign.IsClient) {
@@ -362,14 +370,15 @@ static void HandleGameEvent(const GameEvent e, Camera *camera,
 					- (wc->Spread.Count - 1) * wc->Spread.Width / 2;
 			for (int i = 0; i < wc->Spread.Count; i++) {
 				const float recoil = RAND_FLOAT(-0.5f, 0.5f) * wc->Recoil;
-				const float finalAngle = e.u.GunFire.Angle + spreadStartAngle
+				const float finalAngle = angle + spreadStartAngle
 						+ i * wc->Spread.Width + recoil;
 				GameEvent ab = GameEventNew(GAME_EVENT_ADD_BULLET);
 				ab.u.AddBullet.UID = MobObjsObjsGetNextUID();
 				strcpy(ab.u.AddBullet.BulletClass, wc->Bullet->Name);
 				ab.u.AddBullet.MuzzlePos = Vec2ToNet(pos);
 				ab.u.AddBullet.MuzzleHeight = e.u.GunFire.Z;
-				ab.u.AddBullet.Angle = finalAngle;
+				ab.u.AddBullet.Angle =
+						RadiansToNet(finalAngle, NET_ANGLE_BITS_BULLET);
 				ab.u.AddBullet.Elevation = RAND_INT(wc->ElevationLow,
 						wc->ElevationHigh);
 				ab.u.AddBullet.Flags = e.u.GunFire.Flags;
@@ -384,7 +393,7 @@ static void HandleGameEvent(const GameEvent e, Camera *camera,
 			ap.u.AddParticle.Class = wc->MuzzleFlash;
 			ap.u.AddParticle.Pos = pos;
 			ap.u.AddParticle.Z = (float) e.u.GunFire.Z;
-			ap.u.AddParticle.Angle = e.u.GunFire.Angle;
+			ap.u.AddParticle.Angle = angle;
 			GameEventsEnqueue(&gGameEvents, ap);
 		}
 		// Sound
@@ -402,7 +411,7 @@ static void HandleGameEvent(const GameEvent e, Camera *camera,
 		// Brass shells
 		// If we have a reload lead, defer the creation of shells until then
 		if (wc->Brass && wc->ReloadLead == 0) {
-			const direction_e d = RadiansToDirection(e.u.GunFire.Angle);
+			const direction_e d = RadiansToDirection(angle);
 			WeaponClassAddBrass(wc, d, pos);
 		}
 	}
@@ -420,7 +429,7 @@ static void HandleGameEvent(const GameEvent e, Camera *camera,
 		break;
 	case GAME_EVENT_GUN_STATE: {
 		TActor *a = ActorGetByUID(e.u.GunState.ActorUID);
-		if (!a->isInUse)
+		if (a == NULL || !a->isInUse)
 			break;
 		WeaponSetState(ACTOR_GET_WEAPON(a), (gunstate_e) e.u.GunState.State);
 	}
@@ -531,10 +540,13 @@ static void HandleGameEvent(const GameEvent e, Camera *camera,
 		break;
 	case GAME_EVENT_MISSION_END:
 		MissionDone(&gMission, e.u.MissionEnd);
-		if (e.u.MissionEnd.Msg[0] != '\0') {
+		if (e.u.MissionEnd.Msg[0] != '\0' && camera != NULL) {
 			HUDDisplayMessage(&camera->HUD, e.u.MissionEnd.Msg, -1);
 		}
 		break;
+	case GAME_EVENT_JOIN_STATE:
+		NetClientApplyJoinState(&gNetClient);
+		break;
 	default:
 		assert(0 && "unknown game event");
 		break;
@@ -0,0 +1,114 @@
+/*
+ C-Dogs SDL
+ A port of the legendary (and fun) action/arcade cdogs.
+
+ Copyright (c) 2020 Cong Xu
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "layer_csv.h"
+
+#include <limits.h>
+#include <stdio.h>
+
+#include "utils.h"
+
+bool LayerCSVLoadRow(CArray *layer, const int size, const char *s,
+		const size_t len) {
+	bool ok = true;
+	int n = 0;
+	bool isNegative = false;
+	bool hasDigits = false;
+	int value = 0;
+	bool isRun = false;
+	bool isMalformed = false;
+	for (size_t i = 0; i <= len; i++) {
+		if (i == len || s[i] == ',') {
+			if (isMalformed || (isRun && !hasDigits)) {
+				ok = false;
+			} else if (hasDigits) {
+				// Empty values are skipped, like strtok
+				int count = 1;
+				if (isRun) {
+					count = isNegative ? 0 : n;
+				} else {
+					value = isNegative ? -n : n;
+				}
+				// Never grow the layer past its size, however long the run
+				const int remaining = size - (int) layer->size;
+				if (count <= 0 || count > remaining) {
+					ok = false;
+					count = CLAMP(count, 0, remaining);
+				}
+				for (int j = 0; j < count; j++) {
+					CArrayPushBack(layer, &value);
+				}
+			}
+			n = 0;
+			isNegative = false;
+			hasDigits = false;
+			isRun = false;
+			isMalformed = false;
+		} else if (s[i] == '*') {
+			// Runs are exactly one value and one count
+			isMalformed = isMalformed || isRun || !hasDigits;
+			value = isNegative ? -n : n;
+			n = 0;
+			isNegative = false;
+			hasDigits = false;
+			isRun = true;
+		} else if (s[i] == '-') {
+			isNegative = true;
+		} else if (s[i] >= '0' && s[i] <= '9') {
+			// Saturate rather than overflow; such counts never fit anyway
+			n = n > (INT_MAX - 9) / 10 ? INT_MAX : n * 10 + (s[i] - '0');
+			hasDigits = true;
+		}
+	}
+	return ok;
+}
+
+void LayerCSVSaveRow(char *buf, const CArray *layer, const int width,
+		const int row) {
+	char *pBuf = buf;
+	*pBuf = '\0';
+	for (int j = 0; j < width;) {
+		const int v = *(int*) CArrayGet(layer, row * width + j);
+		int count = 1;
+		while (j + count < width
+				&& *(int*) CArrayGet(layer, row * width + j + count) == v) {
+			count++;
+		}
+		if (pBuf != buf) {
+			*pBuf++ = ',';
+		}
+		// Short runs are shorter written out
+		if (count > 2) {
+			pBuf += sprintf(pBuf, "%d*%d", v, count);
+		} else {
+			pBuf += sprintf(pBuf, "%d", v);
+			count = 1;
+		}
+		j += count;
+	}
+}
@@ -0,0 +1,46 @@
+/*
+ C-Dogs SDL
+ A port of the legendary (and fun) action/arcade cdogs.
+
+ Copyright (c) 2020 Cong Xu
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include "c_array.h"
+
+// Static map layers are saved as one CSV string per row. Since map version
+// 16, runs of the same value are written as value*count.
+
+// Each value and count takes up to 11 chars, plus a '*' and a comma
+#define LAYER_CSV_ROW_MAX(width) ((width) * 24 + 1)
+
+// Append a row's values to a layer of ints, up to size values in total.
+// Returns false if the row is malformed or doesn't fit; values that don't fit
+// are dropped.
+bool LayerCSVLoadRow(CArray *layer, const int size, const char *s,
+		const size_t len);
+// Write a row of a layer of ints to buf, of at least LAYER_CSV_ROW_MAX chars
+void LayerCSVSaveRow(char *buf, const CArray *layer, const int width,
+		const int row);
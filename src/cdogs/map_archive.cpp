@@ -34,7 +34,9 @@
 #include "files.h"
 #include "json_utils.h"
 #include "log.h"
+#include "map_compiled.h"
 #include "map_new.h"
+#include "mission_stream.h"
 #include "pickup.h"
 #include "player_template.h"
 
@@ -57,101 +59,208 @@ int MapNewScanArchive(const char *filename, char **title, int *numMissions) {
 	return err;
 }
 
-static void LoadArchiveSounds(SoundDevice *device, const char *archive,
-		const char *dirname);
-static void LoadArchivePics(PicManager *pm, map_t cc, const char *archive);
-int MapNewLoadArchive(const char *filename, CampaignSetting *c) {
+// Read and parse in MapArchiveLoaderRead; indexed by MapArchiveJSON
+static const char *sArchiveJSONFiles[MAP_ARCHIVE_JSON_COUNT] = {
+	"players.json", "particles.json", "character_classes.json",
+	"bullets.json", "ammo.json", "guns.json", "pickups.json",
+	"map_objects.json", "characters.json"
+};
+int MapArchiveLoaderRead(MapArchiveLoader *l, const char *filename,
+		CampaignSetting *c) {
 	LOG(LM_MAP, LL_DEBUG, "Loading archive map %s", filename);
-	int err = 0;
+	memset(l, 0, sizeof *l);
+	strcpy(l->Path, filename);
+	CArrayInit(&l->Missions, sizeof(Mission));
 	json_t *root = ReadArchiveJSON(filename, "campaign.json");
 	if (root == NULL) {
-		err = -1;
+		l->Err = -1;
 		goto bail;
 	}
-	int version;
-	LoadInt(&version, root, "Version");
-	if (version > MAP_VERSION || version <= 2) {
-		err = -1;
+	LoadInt(&l->Version, root, "Version");
+	if (l->Version > MAP_VERSION || l->Version <= 2) {
+		l->Err = -1;
 		goto bail;
 	}
 	MapNewLoadCampaignJSON(root, c);
-	json_free_value(&root);
-
-	// Load any custom data
-	LoadArchiveSounds(&gSoundDevice, filename, "sounds");
-
-	LoadArchivePics(&gPicManager, gCharSpriteClasses.customClasses, filename);
-
-	root = ReadArchiveJSON(filename, "players.json");
-	if (root != NULL) {
-		PlayerTemplatesLoadJSON(&gPlayerTemplates.CustomClasses, root);
-	}
-
-	root = ReadArchiveJSON(filename, "particles.json");
-	if (root != NULL) {
-		ParticleClassesLoadJSON(&gParticleClasses.CustomClasses, root);
-	}
-
-	root = ReadArchiveJSON(filename, "character_classes.json");
-	if (root != NULL) {
-		CharacterClassesLoadJSON(&gCharacterClasses.CustomClasses, root);
+	for (int i = 0; i < MAP_ARCHIVE_JSON_COUNT; i++) {
+		l->Roots[i] = ReadArchiveJSON(filename, sArchiveJSONFiles[i]);
 	}
+	char path[CDOGS_PATH_MAX];
+	sprintf(path, "%s/graphics", filename);
+	PicDecodedDirLoad(&l->Pics, path, NULL);
 
-	root = ReadArchiveJSON(filename, "bullets.json");
-	if (root != NULL) {
-		BulletLoadJSON(&gBulletClasses, &gBulletClasses.CustomClasses, root);
+	bail: json_free_value(&root);
+	return l->Err;
+}
+static bool LoadCompiledMissions(CArray *missions, const char *archive);
+void MapArchiveLoaderReadMissions(MapArchiveLoader *l) {
+	if (l->Err != 0) {
+		return;
 	}
-
-	root = ReadArchiveJSON(filename, "ammo.json");
-	if (root != NULL) {
-		AmmoLoadJSON(&gAmmo.CustomAmmo, root);
-		json_free_value(&root);
+	// Missions can be big, so stream them instead of parsing them whole
+	char path[CDOGS_PATH_MAX];
+	sprintf(path, "%s/missions.json", l->Path);
+	if (!MissionsLoadStream(&l->Missions, path, l->Version)
+			|| !LoadCompiledMissions(&l->Missions, l->Path)) {
+		l->Err = -1;
 	}
+}
 
-	root = ReadArchiveJSON(filename, "guns.json");
-	if (root != NULL) {
-		WeaponClassesLoadJSON(&gWeaponClasses, &gWeaponClasses.CustomGuns,
-				root);
-		json_free_value(&root);
+static void LoadArchiveSounds(SoundDevice *device, const char *archive,
+		const char *dirname);
+bool MapArchiveLoaderStep(MapArchiveLoader *l, CampaignSetting *c) {
+	if (l->Err != 0 || l->Step >= MAP_ARCHIVE_LOAD_STEPS) {
+		return true;
 	}
-
-	BulletLoadWeapons(&gBulletClasses);
-
-	root = ReadArchiveJSON(filename, "pickups.json");
-	if (root != NULL) {
-		PickupClassesLoadJSON(&gPickupClasses.CustomClasses, root);
+	json_t *root;
+	CArray missions;
+	switch (l->Step) {
+	case 0:
+		LoadArchiveSounds(&gSoundDevice, l->Path, "sounds");
+		break;
+	case 1:
+		PicManagerAddDecodedDir(&gPicManager, &l->Pics, gPicManager.customPics,
+				gPicManager.customSprites);
+		CharSpriteClassesLoadDir(gCharSpriteClasses.customClasses, l->Path);
+		break;
+	case 2:
+		root = l->Roots[MAP_ARCHIVE_JSON_PLAYERS];
+		if (root != NULL) {
+			PlayerTemplatesLoadJSON(&gPlayerTemplates.CustomClasses, root);
+		}
+		break;
+	case 3:
+		root = l->Roots[MAP_ARCHIVE_JSON_PARTICLES];
+		if (root != NULL) {
+			ParticleClassesLoadJSON(&gParticleClasses.CustomClasses, root);
+		}
+		break;
+	case 4:
+		root = l->Roots[MAP_ARCHIVE_JSON_CHARACTER_CLASSES];
+		if (root != NULL) {
+			CharacterClassesLoadJSON(&gCharacterClasses.CustomClasses, root);
+		}
+		break;
+	case 5:
+		root = l->Roots[MAP_ARCHIVE_JSON_BULLETS];
+		if (root != NULL) {
+			BulletLoadJSON(&gBulletClasses, &gBulletClasses.CustomClasses,
+					root);
+			// Bullets keep their root until weapons are loaded
+			l->Roots[MAP_ARCHIVE_JSON_BULLETS] = NULL;
+		}
+		break;
+	case 6:
+		root = l->Roots[MAP_ARCHIVE_JSON_AMMO];
+		if (root != NULL) {
+			AmmoLoadJSON(&gAmmo.CustomAmmo, root);
+		}
+		break;
+	case 7:
+		root = l->Roots[MAP_ARCHIVE_JSON_GUNS];
+		if (root != NULL) {
+			WeaponClassesLoadJSON(&gWeaponClasses,
+					&gWeaponClasses.CustomGuns, root);
+		}
+		BulletLoadWeapons(&gBulletClasses);
+		break;
+	case 8:
+		root = l->Roots[MAP_ARCHIVE_JSON_PICKUPS];
+		if (root != NULL) {
+			PickupClassesLoadJSON(&gPickupClasses.CustomClasses, root);
+		}
+		PickupClassesLoadAmmo(&gPickupClasses.CustomClasses,
+				&gAmmo.CustomAmmo);
+		PickupClassesLoadGuns(&gPickupClasses.CustomClasses,
+				&gWeaponClasses.CustomGuns);
+		PickupClassesLoadKeys(&gPickupClasses.KeyClasses);
+		break;
+	case 9:
+		// Reset custom map objects
+		MapObjectsClear(&gMapObjects.CustomClasses);
+		root = l->Roots[MAP_ARCHIVE_JSON_MAP_OBJECTS];
+		if (root != NULL) {
+			MapObjectsLoadJSON(&gMapObjects.CustomClasses, root);
+		}
+		MapObjectsLoadAmmoAndGunSpawners(&gMapObjects, &gAmmo,
+				&gWeaponClasses, true);
+		break;
+	case MAP_ARCHIVE_LOAD_STEP_MISSIONS:
+		// Swap in the missions read by MapArchiveLoaderReadMissions
+		missions = c->Missions;
+		c->Missions = l->Missions;
+		l->Missions = missions;
+		break;
+	case 11:
+		// Note: some campaigns don't have characters (e.g. dogfights)
+		root = l->Roots[MAP_ARCHIVE_JSON_CHARACTERS];
+		if (root != NULL) {
+			CharacterLoadJSON(&c->characters, root, l->Version);
+		}
+		break;
+	default:
+		CASSERT(false, "unknown archive load step");
+		break;
 	}
-	PickupClassesLoadAmmo(&gPickupClasses.CustomClasses, &gAmmo.CustomAmmo);
-	PickupClassesLoadGuns(&gPickupClasses.CustomClasses,
-			&gWeaponClasses.CustomGuns);
-	PickupClassesLoadKeys(&gPickupClasses.KeyClasses);
-
-	// Reset custom map objects
-	MapObjectsClear(&gMapObjects.CustomClasses);
-	root = ReadArchiveJSON(filename, "map_objects.json");
-	if (root != NULL) {
-		MapObjectsLoadJSON(&gMapObjects.CustomClasses, root);
+	l->Step++;
+	return l->Err != 0 || l->Step >= MAP_ARCHIVE_LOAD_STEPS;
+}
+void MapArchiveLoaderTerminate(MapArchiveLoader *l) {
+	for (int i = 0; i < MAP_ARCHIVE_JSON_COUNT; i++) {
+		json_free_value(&l->Roots[i]);
 	}
-	MapObjectsLoadAmmoAndGunSpawners(&gMapObjects, &gAmmo, &gWeaponClasses,
-			true);
+	PicDecodedDirTerminate(&l->Pics);
+	CA_FOREACH(Mission, m, l->Missions)
+		MissionTerminate(m);
+	CA_FOREACH_END()
+	CArrayTerminate(&l->Missions);
+}
 
-	root = ReadArchiveJSON(filename, "missions.json");
-	if (root == NULL) {
-		err = -1;
-		goto bail;
+int MapNewLoadArchive(const char *filename, CampaignSetting *c) {
+	MapArchiveLoader l;
+	if (MapArchiveLoaderRead(&l, filename, c) == 0) {
+		do {
+			if (l.Step == MAP_ARCHIVE_LOAD_STEP_MISSIONS) {
+				MapArchiveLoaderReadMissions(&l);
+			}
+		} while (!MapArchiveLoaderStep(&l, c));
 	}
-	LoadMissions(&c->Missions, json_find_first_label(root, "Missions")->child,
-			version);
-	json_free_value(&root);
+	MapArchiveLoaderTerminate(&l);
+	return l.Err;
+}
 
-	// Note: some campaigns don't have characters (e.g. dogfights)
-	root = ReadArchiveJSON(filename, "characters.json");
-	if (root != NULL) {
-		CharacterLoadJSON(&c->characters, root, version);
+static bool LoadCompiledMissions(CArray *missions, const char *archive) {
+	char path[CDOGS_PATH_MAX];
+	sprintf(path, "%s/%s", archive, MAP_COMPILED_FILE);
+	MapCompiled mc;
+	if (MapCompiledOpen(&mc, path)) {
+		for (uint32_t i = 0; i < mc.count; i++) {
+			const MapCompiledInfo info = MapCompiledGetInfo(&mc, i);
+			if (info.Index >= (int) missions->size) {
+				continue;
+			}
+			Mission *m = static_cast<Mission*>(CArrayGet(missions, info.Index));
+			// Layers in missions.json take precedence, as they are newer
+			if (m->Type != MAPTYPE_STATIC || m->u.Static.Tiles.size > 0) {
+				continue;
+			}
+			if (!svec2i_is_equal(m->Size, info.Size)) {
+				LOG(LM_MAP, LL_ERROR, "Compiled mission %d size mismatch",
+						info.Index);
+				continue;
+			}
+			MapCompiledLoadStatic(&mc, i, &m->u.Static);
+		}
+		MapCompiledClose(&mc);
 	}
-
-	bail: json_free_value(&root);
-	return err;
+	// Make sure no static missions are missing their layers
+	CA_FOREACH(const Mission, m, *missions)
+		if (m->Type == MAPTYPE_STATIC && m->u.Static.Tiles.size == 0) {
+			LOG(LM_MAP, LL_ERROR, "Static mission %d has no tiles", _ca_index);
+			return false;
+		}
+	CA_FOREACH_END()
+	return true;
 }
 
 static json_t* ReadArchiveJSON(const char *archive, const char *filename) {
@@ -182,12 +291,6 @@ static void LoadArchiveSounds(SoundDevice *device, const char *archive,
 	sprintf(path, "%s/%s", archive, dirname);
 	SoundLoadDir(device->customSounds, path, NULL);
 }
-static void LoadArchivePics(PicManager *pm, map_t cc, const char *archive) {
-	char path[CDOGS_PATH_MAX];
-	sprintf(path, "%s/graphics", archive);
-	PicManagerLoadDir(pm, path, NULL, pm->customPics, pm->customSprites);
-	CharSpriteClassesLoadDir(cc, archive);
-}
 
 static char* ReadFileIntoBuf(const char *path, const char *mode, long *len) {
 	char *buf = NULL;
@@ -269,6 +372,10 @@ int MapArchiveSave(const char *filename, CampaignSetting *c) {
 		goto bail;
 	}
 
+	// missions.json has all the layers, so any compiled file is out of date
+	sprintf(buf2, "%s/%s", buf, MAP_COMPILED_FILE);
+	remove(buf2);
+
 	if (!CharacterSave(&c->characters, buf)) {
 		res = 0;
 		goto bail;
@@ -278,6 +385,160 @@ int MapArchiveSave(const char *filename, CampaignSetting *c) {
 	return res;
 }
 
+static bool SaveArchiveVersion(const char *archive);
+static void MapCompiledSourcesTerminate(CArray *sources);
+bool MapArchiveCompile(const char *archive) {
+	bool ok = false;
+	CArray sources;
+	CArrayInit(&sources, sizeof(MapCompiledSource));
+	char path[CDOGS_PATH_MAX];
+	int version = 0;
+	json_t *missionsNode = NULL;
+	int i = 0;
+	json_t *root = ReadArchiveJSON(archive, "campaign.json");
+	if (root != NULL) {
+		LoadInt(&version, root, "Version");
+		json_free_value(&root);
+	}
+	if (version <= 14 || version > MAP_VERSION) {
+		LOG(LM_MAP, LL_ERROR,
+				"Cannot compile %s: unsupported version %d; resave it first",
+				archive, version);
+		goto bail;
+	}
+	root = ReadArchiveJSON(archive, "missions.json");
+	if (root == NULL || (missionsNode = json_find_first_label(root,
+			"Missions")) == NULL || missionsNode->child == NULL) {
+		LOG(LM_MAP, LL_ERROR, "Cannot compile %s: cannot read missions",
+				archive);
+		goto bail;
+	}
+	for (json_t *child = missionsNode->child->child; child;
+			child = child->next, i++) {
+		MapType type = MAPTYPE_CLASSIC;
+		JSON_UTILS_LOAD_ENUM(type, child, "Type", StrMapType);
+		if (type != MAPTYPE_STATIC
+				|| json_find_first_label(child, "Tiles") == NULL) {
+			continue;
+		}
+		MapCompiledSource s;
+		s.Index = i;
+		LoadInt(&s.Size.x, child, "Width");
+		LoadInt(&s.Size.y, child, "Height");
+		MissionStatic *ms;
+		CMALLOC(ms, sizeof *ms);
+		MissionStaticInit(ms);
+		const bool loaded = MissionStaticLoadTilesJSON(ms, child, s.Size);
+		s.Static = ms;
+		CArrayPushBack(&sources, &s);
+		if (!loaded) {
+			LOG(LM_MAP, LL_ERROR, "Cannot compile %s: bad layers in mission %d",
+					archive, i);
+			goto bail;
+		}
+		// These layers are now only in the compiled file
+		const char *labels[] = { "TileClasses", "Tiles", "Access" };
+		for (int j = 0; j < 3; j++) {
+			json_t *label = json_find_first_label(child, labels[j]);
+			json_free_value(&label);
+		}
+	}
+	if (sources.size == 0) {
+		LOG(LM_MAP, LL_INFO, "Nothing to compile in %s", archive);
+		ok = true;
+		goto bail;
+	}
+
+	sprintf(path, "%s/%s", archive, MAP_COMPILED_FILE);
+	if (!MapCompiledSave(path, &sources) || !SaveArchiveVersion(archive)) {
+		goto bail;
+	}
+	sprintf(path, "%s/missions.json", archive);
+	ok = TrySaveJSONFile(root, path);
+	if (ok) {
+		LOG(LM_MAP, LL_INFO, "Compiled %d missions in %s",
+				(int) sources.size, archive);
+	}
+
+bail:
+	json_free_value(&root);
+	MapCompiledSourcesTerminate(&sources);
+	return ok;
+}
+// Older builds would find missions without their layers, so only let newer
+// ones load the archive. Decompiled layers use the current row format too.
+static bool SaveArchiveVersion(const char *archive) {
+	json_t *root = ReadArchiveJSON(archive, "campaign.json");
+	if (root == NULL) {
+		return false;
+	}
+	json_t *version = json_find_first_label(root, "Version");
+	json_free_value(&version);
+	AddIntPair(root, "Version", MAP_VERSION);
+	char path[CDOGS_PATH_MAX];
+	sprintf(path, "%s/campaign.json", archive);
+	const bool ok = TrySaveJSONFile(root, path);
+	json_free_value(&root);
+	return ok;
+}
+static void MapCompiledSourcesTerminate(CArray *sources) {
+	CA_FOREACH(MapCompiledSource, s, *sources)
+		MissionStatic *ms = const_cast<MissionStatic*>(s->Static);
+		MissionStaticTerminate(ms);
+		CFREE(ms);
+	CA_FOREACH_END()
+	CArrayTerminate(sources);
+}
+bool MapArchiveDecompile(const char *archive) {
+	bool ok = false;
+	char path[CDOGS_PATH_MAX];
+	sprintf(path, "%s/%s", archive, MAP_COMPILED_FILE);
+	MapCompiled mc;
+	if (!MapCompiledOpen(&mc, path)) {
+		LOG(LM_MAP, LL_ERROR, "Cannot read compiled campaign %s", path);
+		return false;
+	}
+	json_t *missionsNode = NULL;
+	json_t *root = ReadArchiveJSON(archive, "missions.json");
+	if (root == NULL || (missionsNode = json_find_first_label(root,
+			"Missions")) == NULL || missionsNode->child == NULL) {
+		LOG(LM_MAP, LL_ERROR, "Cannot decompile %s: cannot read missions",
+				archive);
+		goto bail;
+	}
+	for (uint32_t i = 0; i < mc.count; i++) {
+		const MapCompiledInfo info = MapCompiledGetInfo(&mc, i);
+		json_t *child = missionsNode->child->child;
+		for (int j = 0; child != NULL && j < info.Index; j++) {
+			child = child->next;
+		}
+		if (child == NULL || json_find_first_label(child, "Tiles") != NULL) {
+			continue;
+		}
+		MissionStatic ms;
+		MissionStaticInit(&ms);
+		MapCompiledLoadStatic(&mc, i, &ms);
+		MissionStaticSaveTilesJSON(&ms, info.Size, child);
+		MissionStaticTerminate(&ms);
+	}
+	MapCompiledClose(&mc);
+
+	if (!SaveArchiveVersion(archive)) {
+		goto bail;
+	}
+	sprintf(path, "%s/missions.json", archive);
+	ok = TrySaveJSONFile(root, path);
+	if (ok) {
+		sprintf(path, "%s/%s", archive, MAP_COMPILED_FILE);
+		remove(path);
+	}
+
+bail:
+	MapCompiledClose(&mc);
+	json_free_value(&root);
+	return ok;
+}
+
 static json_t* SaveObjectives(CArray *a);
 static json_t* SaveWeapons(const CArray *weapons);
 static json_t* SaveMissionTileClasses(const MissionTileClasses *mtc);
@@ -27,12 +27,69 @@
  */
 #pragma once
 
+#include <json/json.h>
+
 #include "campaigns.h"
+#include "pic_manager.h"
+#include "sys_config.h"
+
+// Since version 17, static missions may have their layers compiled out of
+// missions.json, so older builds must reject such archives
+#define MAP_VERSION 17
+
+// JSON files read ahead by MapArchiveLoaderRead
+typedef enum {
+	MAP_ARCHIVE_JSON_PLAYERS,
+	MAP_ARCHIVE_JSON_PARTICLES,
+	MAP_ARCHIVE_JSON_CHARACTER_CLASSES,
+	MAP_ARCHIVE_JSON_BULLETS,
+	MAP_ARCHIVE_JSON_AMMO,
+	MAP_ARCHIVE_JSON_GUNS,
+	MAP_ARCHIVE_JSON_PICKUPS,
+	MAP_ARCHIVE_JSON_MAP_OBJECTS,
+	MAP_ARCHIVE_JSON_CHARACTERS,
+	MAP_ARCHIVE_JSON_COUNT
+} MapArchiveJSON;
+
+// Number of MapArchiveLoaderStep calls to load an archive
+#define MAP_ARCHIVE_LOAD_STEPS 12
+// The step that adds the missions, which must be read by then
+#define MAP_ARCHIVE_LOAD_STEP_MISSIONS 10
 
-#define MAP_VERSION 15
+// Loading an archive is split so that its files can be read, parsed and
+// decoded off the main thread, into the loader only. The custom sounds, pics
+// and classes are then added to the global registries on the main thread, a
+// step at a time, as the game reads those registries while it runs.
+// Missions refer to guns and map objects by name, so they are read once
+// those have been added.
+typedef struct {
+	char Path[CDOGS_PATH_MAX];
+	int Version;
+	json_t *Roots[MAP_ARCHIVE_JSON_COUNT];
+	PicDecodedDir Pics;
+	CArray Missions;	// of Mission
+	int Step;
+	int Err;
+} MapArchiveLoader;
 
 int MapNewScanArchive(const char *filename, char **title, int *numMissions);
 int MapNewLoadArchive(const char *filename, CampaignSetting *c);
+// Read an archive's files, and its campaign info into c; this doesn't touch
+// any global state, so it is safe to run on another thread
+int MapArchiveLoaderRead(MapArchiveLoader *l, const char *filename,
+		CampaignSetting *c);
+// Read the missions, once the steps before MAP_ARCHIVE_LOAD_STEP_MISSIONS are
+// done; this only reads the registries, so it is safe to run on another
+// thread while the main thread doesn't change them
+void MapArchiveLoaderReadMissions(MapArchiveLoader *l);
+// Do the next load step on the main thread
+// Returns true when finished; Err is set if loading failed
+bool MapArchiveLoaderStep(MapArchiveLoader *l, CampaignSetting *c);
+void MapArchiveLoaderTerminate(MapArchiveLoader *l);
 int MapArchiveSave(const char *filename, CampaignSetting *c);
+// Move the static map layers of an archive into a compiled file, or back
+// into missions.json; either way the archive is updated to MAP_VERSION
+bool MapArchiveCompile(const char *archive);
+bool MapArchiveDecompile(const char *archive);
 
 json_t* MissionSaveTileClass(const TileClass *tc);
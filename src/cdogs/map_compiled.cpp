@@ -0,0 +1,429 @@
+/*
+ C-Dogs SDL
+ A port of the legendary (and fun) action/arcade cdogs.
+
+ Copyright (c) 2020 Cong Xu
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "map_compiled.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <SDL2/SDL_endian.h>
+
+#include "asset_pack.h"
+#include "log.h"
+#include "utils.h"
+
+#define MAP_COMPILED_MAGIC "CDMC"
+#define MAP_COMPILED_VERSION 1
+#define MAP_COMPILED_NO_STRING UINT32_MAX
+
+// All values are little endian
+typedef struct {
+	char Magic[4];
+	uint32_t Version;
+	uint32_t Count;	// of missions
+	uint32_t StringsSize;
+	uint64_t StringsOffset;
+} MapCompiledHeader;
+
+// Followed by the mission table; all offsets are from the start of the file
+typedef struct {
+	uint32_t Index;
+	uint16_t Width;
+	uint16_t Height;
+	uint32_t NumTileClasses;
+	uint32_t Unused;
+	uint64_t TileClassesOffset;
+	uint64_t TilesOffset;	// Width * Height uint16s
+	uint64_t AccessOffset;	// Width * Height uint16s
+} MapCompiledMission;
+
+#define TILE_FLAG_CAN_WALK 1
+#define TILE_FLAG_IS_OPAQUE 2
+#define TILE_FLAG_SHOOTABLE 4
+#define TILE_FLAG_IS_ROOM 8
+typedef struct {
+	uint32_t Id;	// the tile id used in the tiles layer
+	uint32_t NameOffset;	// in the string pool, or MAP_COMPILED_NO_STRING
+	uint32_t StyleOffset;
+	uint8_t Type;
+	uint8_t Flags;
+	uint8_t Unused[2];
+	color_t Mask;
+	color_t MaskAlt;
+} MapCompiledTileClass;
+
+static const MapCompiledHeader* GetHeader(const MapCompiled *mc) {
+	return static_cast<const MapCompiledHeader*>(mc->data);
+}
+static const MapCompiledMission* GetMission(const MapCompiled *mc,
+		const uint32_t i) {
+	return reinterpret_cast<const MapCompiledMission*>(
+			static_cast<const uint8_t*>(mc->data) + sizeof(MapCompiledHeader))
+			+ i;
+}
+static const void* GetData(const MapCompiled *mc, const uint64_t offset) {
+	return static_cast<const uint8_t*>(mc->data) + offset;
+}
+
+static bool MapCompiledValidate(const MapCompiled *mc);
+bool MapCompiledOpen(MapCompiled *mc, const char *path) {
+	memset(mc, 0, sizeof *mc);
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+	UNUSED(path);
+	return false;
+#else
+	mc->data = AssetMapFile(path, &mc->size);
+	if (mc->data == NULL) {
+		return false;
+	}
+	if (!MapCompiledValidate(mc)) {
+		LOG(LM_MAP, LL_ERROR, "Compiled campaign file %s is invalid", path);
+		MapCompiledClose(mc);
+		return false;
+	}
+	mc->count = GetHeader(mc)->Count;
+	return true;
+#endif
+}
+static bool InBounds(const MapCompiled *mc, const uint64_t offset,
+		const uint64_t len) {
+	return offset <= mc->size && len <= mc->size - offset;
+}
+static bool StringValid(const MapCompiledHeader *h, const uint32_t offset) {
+	return offset == MAP_COMPILED_NO_STRING || offset < h->StringsSize;
+}
+static bool MapCompiledValidate(const MapCompiled *mc) {
+	if (mc->size < sizeof(MapCompiledHeader)) {
+		return false;
+	}
+	const MapCompiledHeader *h = GetHeader(mc);
+	if (memcmp(h->Magic, MAP_COMPILED_MAGIC, sizeof h->Magic) != 0
+			|| h->Version != MAP_COMPILED_VERSION
+			|| !InBounds(mc, sizeof *h,
+					(uint64_t) h->Count * sizeof(MapCompiledMission))
+			|| !InBounds(mc, h->StringsOffset, h->StringsSize)) {
+		return false;
+	}
+	// Strings must be terminated so that they can be used in place
+	const char *strings = static_cast<const char*>(
+			GetData(mc, h->StringsOffset));
+	if (h->StringsSize > 0 && strings[h->StringsSize - 1] != '\0') {
+		return false;
+	}
+	for (uint32_t i = 0; i < h->Count; i++) {
+		const MapCompiledMission *m = GetMission(mc, i);
+		const uint64_t layerSize = (uint64_t) m->Width * m->Height
+				* sizeof(uint16_t);
+		if (m->TileClassesOffset % sizeof(uint32_t) != 0
+				|| m->TilesOffset % sizeof(uint16_t) != 0
+				|| m->AccessOffset % sizeof(uint16_t) != 0
+				|| !InBounds(mc, m->TileClassesOffset,
+						(uint64_t) m->NumTileClasses
+								* sizeof(MapCompiledTileClass))
+				|| !InBounds(mc, m->TilesOffset, layerSize)
+				|| !InBounds(mc, m->AccessOffset, layerSize)) {
+			return false;
+		}
+		const MapCompiledTileClass *tcs =
+				static_cast<const MapCompiledTileClass*>(
+						GetData(mc, m->TileClassesOffset));
+		for (uint32_t j = 0; j < m->NumTileClasses; j++) {
+			if (!StringValid(h, tcs[j].NameOffset)
+					|| !StringValid(h, tcs[j].StyleOffset)
+					|| tcs[j].Type >= TILE_CLASS_COUNT) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void MapCompiledClose(MapCompiled *mc) {
+	AssetUnmapFile(mc->data, mc->size);
+	memset(mc, 0, sizeof *mc);
+}
+
+MapCompiledInfo MapCompiledGetInfo(const MapCompiled *mc, const uint32_t i) {
+	const MapCompiledMission *m = GetMission(mc, i);
+	MapCompiledInfo info;
+	info.Index = (int) m->Index;
+	info.Size = svec2i(m->Width, m->Height);
+	return info;
+}
+
+static char* CopyString(const MapCompiled *mc, const uint32_t offset);
+static void LoadLayer(CArray *layer, const uint16_t *values, const size_t n);
+void MapCompiledLoadStatic(const MapCompiled *mc, const uint32_t i,
+		MissionStatic *m) {
+	const MapCompiledMission *cm = GetMission(mc, i);
+	const MapCompiledTileClass *ctc =
+			static_cast<const MapCompiledTileClass*>(
+					GetData(mc, cm->TileClassesOffset));
+	for (uint32_t j = 0; j < cm->NumTileClasses; j++, ctc++) {
+		TileClass *tc;
+		CCALLOC(tc, sizeof *tc);
+		tc->Name = CopyString(mc, ctc->NameOffset);
+		tc->Style = CopyString(mc, ctc->StyleOffset);
+		tc->Type = (TileClassType) ctc->Type;
+		tc->Mask = ctc->Mask;
+		tc->MaskAlt = ctc->MaskAlt;
+		tc->canWalk = ctc->Flags & TILE_FLAG_CAN_WALK;
+		tc->isOpaque = ctc->Flags & TILE_FLAG_IS_OPAQUE;
+		tc->shootable = ctc->Flags & TILE_FLAG_SHOOTABLE;
+		tc->IsRoom = ctc->Flags & TILE_FLAG_IS_ROOM;
+		char keyBuf[12];
+		sprintf(keyBuf, "%u", ctc->Id);
+		if (hashmap_put(m->TileClasses, keyBuf, tc) != MAP_OK) {
+			CASSERT(false, "cannot add tile class");
+		}
+	}
+	const size_t n = (size_t) cm->Width * cm->Height;
+	LoadLayer(&m->Tiles,
+			static_cast<const uint16_t*>(GetData(mc, cm->TilesOffset)), n);
+	LoadLayer(&m->Access,
+			static_cast<const uint16_t*>(GetData(mc, cm->AccessOffset)), n);
+}
+static char* CopyString(const MapCompiled *mc, const uint32_t offset) {
+	if (offset == MAP_COMPILED_NO_STRING) {
+		return NULL;
+	}
+	const MapCompiledHeader *h = GetHeader(mc);
+	char *s;
+	CSTRDUP(s, static_cast<const char*>(
+			GetData(mc, h->StringsOffset + offset)));
+	return s;
+}
+static void LoadLayer(CArray *layer, const uint16_t *values, const size_t n) {
+	CArrayResize(layer, n, NULL);
+	int *out = static_cast<int*>(layer->data);
+	for (size_t i = 0; i < n; i++) {
+		out[i] = (int) values[i];
+	}
+}
+
+typedef struct {
+	CArray *body;	// of uint8_t
+	CArray *strings;	// of char
+	map_t tileClasses;
+	uint32_t count;
+	bool ok;
+} SaveTileClassData;
+static void AppendBytes(CArray *a, const void *data, const size_t n);
+static void AlignBytes(CArray *a, const size_t align);
+static int SaveTileClass(any_t data, any_t key);
+static bool SaveLayer(CArray *body, const CArray *layer, const size_t n);
+static bool WriteCompiled(FILE *f, const MapCompiledHeader *h,
+		const CArray *table, const CArray *body, const CArray *strings);
+bool MapCompiledSave(const char *path, const CArray *sources) {
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+	UNUSED(path);
+	UNUSED(sources);
+	LOG(LM_MAP, LL_ERROR, "Compiled campaigns are not supported");
+	return false;
+#else
+	bool ok = false;
+	CArray table;
+	CArrayInit(&table, sizeof(MapCompiledMission));
+	CArray body;
+	CArrayInit(&body, sizeof(uint8_t));
+	CArray strings;
+	CArrayInit(&strings, sizeof(char));
+	MapCompiledHeader h;
+	memset(&h, 0, sizeof h);
+	char tmpPath[CDOGS_PATH_MAX];
+	sprintf(tmpPath, "%s.tmp", path);
+	FILE *f = NULL;
+	// The body of per-mission tables and layers follows the mission table
+	const uint64_t bodyStart = sizeof h
+			+ (uint64_t) sources->size * sizeof(MapCompiledMission);
+
+	CA_FOREACH(const MapCompiledSource, s, *sources)
+		const size_t n = (size_t) s->Size.x * s->Size.y;
+		if (s->Size.x <= 0 || s->Size.y <= 0 || s->Size.x > UINT16_MAX
+				|| s->Size.y > UINT16_MAX || s->Static->Tiles.size != n
+				|| s->Static->Access.size != n) {
+			LOG(LM_MAP, LL_ERROR, "Cannot compile mission %d: bad size",
+					s->Index);
+			goto bail;
+		}
+		MapCompiledMission cm;
+		memset(&cm, 0, sizeof cm);
+		cm.Index = (uint32_t) s->Index;
+		cm.Width = (uint16_t) s->Size.x;
+		cm.Height = (uint16_t) s->Size.y;
+
+		AlignBytes(&body, sizeof(uint64_t));
+		cm.TileClassesOffset = bodyStart + body.size;
+		SaveTileClassData data = {
+			&body, &strings, s->Static->TileClasses, 0, true
+		};
+		if (hashmap_iterate_keys(s->Static->TileClasses, SaveTileClass,
+				&data) != MAP_OK || !data.ok) {
+			LOG(LM_MAP, LL_ERROR,
+					"Cannot compile mission %d: bad tile classes", s->Index);
+			goto bail;
+		}
+		cm.NumTileClasses = data.count;
+
+		cm.TilesOffset = bodyStart + body.size;
+		if (!SaveLayer(&body, &s->Static->Tiles, n)) {
+			LOG(LM_MAP, LL_ERROR, "Cannot compile mission %d: bad tiles",
+					s->Index);
+			goto bail;
+		}
+		cm.AccessOffset = bodyStart + body.size;
+		if (!SaveLayer(&body, &s->Static->Access, n)) {
+			LOG(LM_MAP, LL_ERROR, "Cannot compile mission %d: bad access",
+					s->Index);
+			goto bail;
+		}
+		CArrayPushBack(&table, &cm);
+	CA_FOREACH_END()
+	AlignBytes(&body, sizeof(uint64_t));
+
+	memcpy(h.Magic, MAP_COMPILED_MAGIC, sizeof h.Magic);
+	h.Version = MAP_COMPILED_VERSION;
+	h.Count = (uint32_t) table.size;
+	h.StringsSize = (uint32_t) strings.size;
+	h.StringsOffset = bodyStart + body.size;
+
+	f = fopen(tmpPath, "wb");
+	if (f == NULL) {
+		LOG(LM_MAP, LL_ERROR, "Cannot write compiled campaign %s: %s",
+				tmpPath, strerror(errno));
+		goto bail;
+	}
+	ok = WriteCompiled(f, &h, &table, &body, &strings);
+
+bail:
+	if (f != NULL && fclose(f) != 0) {
+		ok = false;
+	}
+	if (ok) {
+		remove(path);
+		if (rename(tmpPath, path) != 0) {
+			LOG(LM_MAP, LL_ERROR, "Cannot replace compiled campaign %s: %s",
+					path, strerror(errno));
+			ok = false;
+		}
+	}
+	if (!ok && f != NULL) {
+		remove(tmpPath);
+	}
+	CArrayTerminate(&table);
+	CArrayTerminate(&body);
+	CArrayTerminate(&strings);
+	return ok;
+#endif
+}
+static void AppendBytes(CArray *a, const void *data, const size_t n) {
+	const size_t size = a->size;
+	CArrayResize(a, size + n, NULL);
+	memcpy(static_cast<uint8_t*>(a->data) + size, data, n);
+}
+static void AlignBytes(CArray *a, const size_t align) {
+	const uint8_t zero = 0;
+	while (a->size % align != 0) {
+		CArrayPushBack(a, &zero);
+	}
+}
+static uint32_t AddString(CArray *strings, const char *s);
+static int SaveTileClass(any_t data, any_t key) {
+	SaveTileClassData *sData = static_cast<SaveTileClassData*>(data);
+	TileClass *tc;
+	const int error = hashmap_get(sData->tileClasses, (const char*) key,
+			(any_t*) &tc);
+	if (error != MAP_OK) {
+		CASSERT(false, "cannot find tile class");
+		return error;
+	}
+	// Tile class keys are tile ids
+	char *end;
+	const unsigned long id = strtoul((const char*) key, &end, 10);
+	if (*end != '\0' || id > UINT16_MAX) {
+		sData->ok = false;
+		return MAP_OK;
+	}
+	MapCompiledTileClass ctc;
+	memset(&ctc, 0, sizeof ctc);
+	ctc.Id = (uint32_t) id;
+	ctc.NameOffset = AddString(sData->strings, tc->Name);
+	ctc.StyleOffset = AddString(sData->strings, tc->Style);
+	ctc.Type = (uint8_t) tc->Type;
+	ctc.Flags = (tc->canWalk ? TILE_FLAG_CAN_WALK : 0)
+			| (tc->isOpaque ? TILE_FLAG_IS_OPAQUE : 0)
+			| (tc->shootable ? TILE_FLAG_SHOOTABLE : 0)
+			| (tc->IsRoom ? TILE_FLAG_IS_ROOM : 0);
+	ctc.Mask = tc->Mask;
+	ctc.MaskAlt = tc->MaskAlt;
+	AppendBytes(sData->body, &ctc, sizeof ctc);
+	sData->count++;
+	return MAP_OK;
+}
+static uint32_t AddString(CArray *strings, const char *s) {
+	if (s == NULL) {
+		return MAP_COMPILED_NO_STRING;
+	}
+	// Reuse an existing copy; there are only a few distinct names and styles
+	const char *pool = static_cast<const char*>(strings->data);
+	for (size_t i = 0; i < strings->size; i += strlen(pool + i) + 1) {
+		if (strcmp(pool + i, s) == 0) {
+			return (uint32_t) i;
+		}
+	}
+	const uint32_t offset = (uint32_t) strings->size;
+	AppendBytes(strings, s, strlen(s) + 1);
+	return offset;
+}
+static bool SaveLayer(CArray *body, const CArray *layer, const size_t n) {
+	for (size_t i = 0; i < n; i++) {
+		const int v = *static_cast<const int*>(CArrayGet(layer, i));
+		if (v < 0 || v > UINT16_MAX) {
+			return false;
+		}
+		const uint16_t v16 = (uint16_t) v;
+		AppendBytes(body, &v16, sizeof v16);
+	}
+	return true;
+}
+static bool WriteCompiled(FILE *f, const MapCompiledHeader *h,
+		const CArray *table, const CArray *body, const CArray *strings) {
+	if (fwrite(h, sizeof *h, 1, f) != 1) {
+		return false;
+	}
+	if (fwrite(table->data, table->elemSize, table->size, f) != table->size) {
+		return false;
+	}
+	if (fwrite(body->data, 1, body->size, f) != body->size) {
+		return false;
+	}
+	if (fwrite(strings->data, 1, strings->size, f) != strings->size) {
+		return false;
+	}
+	return true;
+}
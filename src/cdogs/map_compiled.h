@@ -0,0 +1,72 @@
+/*
+ C-Dogs SDL
+ A port of the legendary (and fun) action/arcade cdogs.
+
+ Copyright (c) 2020 Cong Xu
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "mission_static.h"
+
+// Compiled campaign data, for loading the big static map layers without
+// parsing them out of JSON.
+// The tile classes, tiles and access layers of each static mission are
+// stored in fixed-size binary tables, with the tiles as raw uint16 arrays and
+// the tile class names and styles in a string pool, and the file is
+// memory-mapped and copied out directly.
+// missions.json in a compiled campaign omits these layers; everything else
+// is still loaded from JSON.
+
+#define MAP_COMPILED_FILE "missions.bin"
+
+typedef struct {
+	void *data;
+	size_t size;
+	uint32_t count;
+} MapCompiled;
+
+typedef struct {
+	int Index;	// of the mission in missions.json
+	struct vec2i Size;
+} MapCompiledInfo;
+
+// Map and validate a compiled file; returns false if missing or invalid
+bool MapCompiledOpen(MapCompiled *mc, const char *path);
+void MapCompiledClose(MapCompiled *mc);
+MapCompiledInfo MapCompiledGetInfo(const MapCompiled *mc, const uint32_t i);
+// Load the i'th compiled mission's tile classes, tiles and access layers
+// into an initialised static mission
+void MapCompiledLoadStatic(const MapCompiled *mc, const uint32_t i,
+		MissionStatic *m);
+
+typedef struct {
+	int Index;	// of the mission in missions.json
+	struct vec2i Size;
+	const MissionStatic *Static;
+} MapCompiledSource;
+// Write the layers of the static missions in sources (of MapCompiledSource)
+bool MapCompiledSave(const char *path, const CArray *sources);
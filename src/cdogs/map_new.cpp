@@ -93,6 +93,10 @@ int MapNewScanJSON(json_t *root, char **title, int *numMissions) {
 	bail: return err;
 }
 
+bool MapNewIsArchive(const char *filename) {
+	return strcmp(StrGetFileExt(filename), "cdogscpn") == 0
+			|| strcmp(StrGetFileExt(filename), "CDOGSCPN") == 0;
+}
 int MapNewLoad(const char *filename, CampaignSetting *c) {
 	int err = 0;
 
@@ -108,8 +112,7 @@ int MapNewLoad(const char *filename, CampaignSetting *c) {
 		return err;
 	}
 
-	if (strcmp(StrGetFileExt(filename), "cdogscpn") == 0
-			|| strcmp(StrGetFileExt(filename), "CDOGSCPN") == 0) {
+	if (MapNewIsArchive(filename)) {
 		return MapNewLoadArchive(filename, c);
 	}
 
@@ -163,107 +166,112 @@ void LoadMissions(CArray *missions, json_t *missionsNode, int version) {
 	json_t *child;
 	for (child = missionsNode->child; child; child = child->next) {
 		Mission m;
-		MissionInit(&m);
-		m.Title = GetString(child, "Title");
-		m.Description = GetString(child, "Description");
-		JSON_UTILS_LOAD_ENUM(m.Type, child, "Type", StrMapType);
-		LoadInt(&m.Size.x, child, "Width");
-		LoadInt(&m.Size.y, child, "Height");
-		if (version <= 9) {
-			int style;
-			LoadInt(&style, child, "ExitStyle");
-			strcpy(m.ExitStyle, IntExitStyle(style));
-		} else {
-			char *tmp = GetString(child, "ExitStyle");
-			strcpy(m.ExitStyle, tmp);
-			CFREE(tmp);
+		if (MissionLoadJSON(&m, child, version)) {
+			CArrayPushBack(missions, &m);
 		}
-		if (version <= 8) {
-			int keyStyle;
-			LoadInt(&keyStyle, child, "KeyStyle");
-			strcpy(m.KeyStyle, IntKeyStyle(keyStyle));
-		} else {
-			char *tmp = GetString(child, "KeyStyle");
-			strcpy(m.KeyStyle, tmp);
-			CFREE(tmp);
+	}
+}
+bool MissionLoadJSON(Mission *m, json_t *node, const int version) {
+	MissionInit(m);
+	m->Title = GetString(node, "Title");
+	m->Description = GetString(node, "Description");
+	JSON_UTILS_LOAD_ENUM(m->Type, node, "Type", StrMapType);
+	LoadInt(&m->Size.x, node, "Width");
+	LoadInt(&m->Size.y, node, "Height");
+	if (version <= 9) {
+		int style;
+		LoadInt(&style, node, "ExitStyle");
+		strcpy(m->ExitStyle, IntExitStyle(style));
+	} else {
+		char *tmp = GetString(node, "ExitStyle");
+		strcpy(m->ExitStyle, tmp);
+		CFREE(tmp);
+	}
+	if (version <= 8) {
+		int keyStyle;
+		LoadInt(&keyStyle, node, "KeyStyle");
+		strcpy(m->KeyStyle, IntKeyStyle(keyStyle));
+	} else {
+		char *tmp = GetString(node, "KeyStyle");
+		strcpy(m->KeyStyle, tmp);
+		CFREE(tmp);
+	}
+	LoadMissionObjectives(&m->Objectives,
+			json_find_first_label(node, "Objectives")->child, version);
+	LoadIntArray(&m->Enemies, node, "Enemies");
+	LoadIntArray(&m->SpecialChars, node, "SpecialChars");
+	if (version <= 3) {
+		CArray items;
+		CArrayInit(&items, sizeof(int));
+		LoadIntArray(&items, node, "Items");
+		CArray densities;
+		CArrayInit(&densities, sizeof(int));
+		LoadIntArray(&densities, node, "ItemDensities");
+		for (int i = 0; i < (int) items.size; i++) {
+			MapObjectDensity mod;
+			mod.M = IntMapObject(*(int*) CArrayGet(&items, i));
+			mod.Density = *(int*) CArrayGet(&densities, i);
+			CArrayPushBack(&m->MapObjectDensities, &mod);
 		}
-		LoadMissionObjectives(&m.Objectives,
-				json_find_first_label(child, "Objectives")->child, version);
-		LoadIntArray(&m.Enemies, child, "Enemies");
-		LoadIntArray(&m.SpecialChars, child, "SpecialChars");
-		if (version <= 3) {
-			CArray items;
-			CArrayInit(&items, sizeof(int));
-			LoadIntArray(&items, child, "Items");
-			CArray densities;
-			CArrayInit(&densities, sizeof(int));
-			LoadIntArray(&densities, child, "ItemDensities");
-			for (int i = 0; i < (int) items.size; i++) {
+	} else {
+		json_t *modsNode = json_find_first_label(node,
+				"MapObjectDensities");
+		if (modsNode && modsNode->child) {
+			modsNode = modsNode->child;
+			for (json_t *modNode = modsNode->child; modNode; modNode =
+					modNode->next) {
 				MapObjectDensity mod;
-				mod.M = IntMapObject(*(int*) CArrayGet(&items, i));
-				mod.Density = *(int*) CArrayGet(&densities, i);
-				CArrayPushBack(&m.MapObjectDensities, &mod);
-			}
-		} else {
-			json_t *modsNode = json_find_first_label(child,
-					"MapObjectDensities");
-			if (modsNode && modsNode->child) {
-				modsNode = modsNode->child;
-				for (json_t *modNode = modsNode->child; modNode; modNode =
-						modNode->next) {
-					MapObjectDensity mod;
-					mod.M =
-							StrMapObject(
-									json_find_first_label(modNode, "MapObject")->child->text);
-					LoadInt(&mod.Density, modNode, "Density");
-					CArrayPushBack(&m.MapObjectDensities, &mod);
-				}
+				mod.M =
+						StrMapObject(
+								json_find_first_label(modNode, "MapObject")->child->text);
+				LoadInt(&mod.Density, modNode, "Density");
+				CArrayPushBack(&m->MapObjectDensities, &mod);
 			}
 		}
-		LoadInt(&m.EnemyDensity, child, "EnemyDensity");
-		LoadWeapons(&m.Weapons, json_find_first_label(child, "Weapons")->child);
-		strcpy(m.Song, json_find_first_label(child, "Song")->child->text);
-		switch (m.Type) {
-		case MAPTYPE_CLASSIC:
-			LoadMissionTileClasses(&m.u.Classic.TileClasses, child, version);
-			LoadInt(&m.u.Classic.Walls, child, "Walls");
-			LoadInt(&m.u.Classic.WallLength, child, "WallLength");
-			LoadInt(&m.u.Classic.CorridorWidth, child, "CorridorWidth");
-			LoadRooms(&m.u.Classic.Rooms,
-					json_find_first_label(child, "Rooms")->child);
-			LoadInt(&m.u.Classic.Squares, child, "Squares");
-			LoadClassicDoors(&m, child, "Doors");
-			LoadClassicPillars(&m, child, "Pillars");
-			break;
-		case MAPTYPE_STATIC:
-			if (!MissionStaticTryLoadJSON(&m.u.Static, child, version)) {
-				continue;
-			}
-			break;
-		case MAPTYPE_CAVE: {
-			LoadMissionTileClasses(&m.u.Cave.TileClasses, child, version);
-			LoadInt(&m.u.Cave.FillPercent, child, "FillPercent");
-			LoadInt(&m.u.Cave.Repeat, child, "Repeat");
-			LoadInt(&m.u.Cave.R1, child, "R1");
-			LoadInt(&m.u.Cave.R2, child, "R2");
-			json_t *roomsNode = json_find_first_label(child, "Rooms");
-			if (roomsNode != NULL && roomsNode->child != NULL) {
-				LoadRooms(&m.u.Cave.Rooms, roomsNode->child);
-			}
-			LoadInt(&m.u.Cave.Squares, child, "Squares");
-			if (version < 14) {
-				m.u.Cave.DoorsEnabled = true;
-			} else {
-				LoadBool(&m.u.Cave.DoorsEnabled, child, "DoorsEnabled");
-			}
+	}
+	LoadInt(&m->EnemyDensity, node, "EnemyDensity");
+	LoadWeapons(&m->Weapons, json_find_first_label(node, "Weapons")->child);
+	strcpy(m->Song, json_find_first_label(node, "Song")->child->text);
+	switch (m->Type) {
+	case MAPTYPE_CLASSIC:
+		LoadMissionTileClasses(&m->u.Classic.TileClasses, node, version);
+		LoadInt(&m->u.Classic.Walls, node, "Walls");
+		LoadInt(&m->u.Classic.WallLength, node, "WallLength");
+		LoadInt(&m->u.Classic.CorridorWidth, node, "CorridorWidth");
+		LoadRooms(&m->u.Classic.Rooms,
+				json_find_first_label(node, "Rooms")->child);
+		LoadInt(&m->u.Classic.Squares, node, "Squares");
+		LoadClassicDoors(m, node, "Doors");
+		LoadClassicPillars(m, node, "Pillars");
+		break;
+	case MAPTYPE_STATIC:
+		if (!MissionStaticTryLoadJSON(&m->u.Static, node, version, m->Size)) {
+			return false;
 		}
-			break;
-		default:
-			assert(0 && "unknown map type");
-			continue;
+		break;
+	case MAPTYPE_CAVE: {
+		LoadMissionTileClasses(&m->u.Cave.TileClasses, node, version);
+		LoadInt(&m->u.Cave.FillPercent, node, "FillPercent");
+		LoadInt(&m->u.Cave.Repeat, node, "Repeat");
+		LoadInt(&m->u.Cave.R1, node, "R1");
+		LoadInt(&m->u.Cave.R2, node, "R2");
+		json_t *roomsNode = json_find_first_label(node, "Rooms");
+		if (roomsNode != NULL && roomsNode->child != NULL) {
+			LoadRooms(&m->u.Cave.Rooms, roomsNode->child);
 		}
-		CArrayPushBack(missions, &m);
+		LoadInt(&m->u.Cave.Squares, node, "Squares");
+		if (version < 14) {
+			m->u.Cave.DoorsEnabled = true;
+		} else {
+			LoadBool(&m->u.Cave.DoorsEnabled, node, "DoorsEnabled");
+		}
+	}
+		break;
+	default:
+		assert(0 && "unknown map type");
+		return false;
 	}
+	return true;
 }
 
 void MissionLoadTileClass(TileClass *tc, json_t *node) {
@@ -335,13 +343,16 @@ void LoadMissionTileClasses(MissionTileClasses *mtc, json_t *node,
 			LoadColor(&roomMask, node, "RoomMask");
 			LoadColor(&altMask, node, "AltMask");
 		}
-		TileClassInit(&mtc->Wall, &gPicManager, &gTileWall, wallStyle,
+		// Don't make the pics yet, so that missions can be loaded off the
+		// render thread; like newer tile classes, they are made when the map
+		// is built
+		TileClassInit(&mtc->Wall, NULL, &gTileWall, wallStyle,
 				TileClassBaseStyleType(TILE_CLASS_WALL), wallMask, altMask);
-		TileClassInit(&mtc->Floor, &gPicManager, &gTileFloor, floorStyle,
+		TileClassInit(&mtc->Floor, NULL, &gTileFloor, floorStyle,
 				TileClassBaseStyleType(TILE_CLASS_FLOOR), floorMask, altMask);
-		TileClassInit(&mtc->Room, &gPicManager, &gTileRoom, roomStyle,
+		TileClassInit(&mtc->Room, NULL, &gTileRoom, roomStyle,
 				TileClassBaseStyleType(TILE_CLASS_FLOOR), roomMask, altMask);
-		TileClassInit(&mtc->Door, &gPicManager, &gTileDoor, doorStyle,
+		TileClassInit(&mtc->Door, NULL, &gTileDoor, doorStyle,
 				TileClassBaseStyleType(TILE_CLASS_DOOR), colorWhite,
 				colorWhite);
 	} else {
@@ -35,11 +35,14 @@
 // allocates title
 int MapNewScan(const char *filename, char **title, int *numMissions);
 int MapNewLoad(const char *filename, CampaignSetting *c);
+bool MapNewIsArchive(const char *filename);
 
 // Helper methods for loading JSON maps
 int MapNewScanJSON(json_t *root, char **title, int *numMissions);
 void MapNewLoadCampaignJSON(json_t *root, CampaignSetting *c);
 void LoadMissions(CArray *missions, json_t *missionsNode, int version);
+// Returns false if the mission cannot be loaded and should be skipped
+bool MissionLoadJSON(Mission *m, json_t *node, const int version);
 void MissionLoadTileClass(TileClass *tc, json_t *node);
 void LoadMissionTileClasses(MissionTileClasses *mtc, json_t *node,
 		const int version);
@@ -48,6 +48,7 @@
  */
 #include "map_object.h"
 
+#include "asset_pack.h"
 #include "json_utils.h"
 #include "log.h"
 #include "map.h"
@@ -192,7 +193,7 @@ void MapObjectsInit(MapObjects *classes, const char *filename,
 
 	char buf[CDOGS_PATH_MAX];
 	GetDataFilePath(buf, filename);
-	FILE *f = fopen(buf, "r");
+	FILE *f = AssetFOpen(buf, "r");
 	json_t *root = NULL;
 	enum json_error e;
 	if (f == NULL) {
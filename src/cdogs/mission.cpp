@@ -270,6 +270,40 @@ static void SetupWeapons(CArray *to, CArray *from) {
 	CArrayCopy(to, from);
 }
 
+static void PrefetchWeaponSounds(const WeaponClass *wc);
+static void PrefetchSounds(const struct MissionOptions *mo) {
+	// Decode the sounds of the weapons likely to be used in this mission,
+	// so they are ready by the time they are first played
+	CA_FOREACH(const WeaponClass *, wc, mo->Weapons)
+		PrefetchWeaponSounds(*wc);
+	CA_FOREACH_END()
+	const CharacterStore *s = &gCampaign.Setting.characters;
+	CA_FOREACH(const int, id, s->baddieIds)
+		const Character *c = static_cast<const Character*>(CArrayGet(
+				&s->OtherChars, *id));
+		PrefetchWeaponSounds(c->Gun);
+	CA_FOREACH_END()
+	CA_FOREACH(const int, id, s->specialIds)
+		const Character *c = static_cast<const Character*>(CArrayGet(
+				&s->OtherChars, *id));
+		PrefetchWeaponSounds(c->Gun);
+	CA_FOREACH_END()
+}
+static void PrefetchWeaponSounds(const WeaponClass *wc) {
+	if (wc == NULL) {
+		return;
+	}
+	SoundPrefetch(&gSoundDevice, wc->Sound);
+	SoundPrefetch(&gSoundDevice, wc->ReloadSound);
+	SoundPrefetch(&gSoundDevice, wc->SwitchSound);
+	if (wc->Bullet != NULL) {
+		const HitSounds *h = &wc->Bullet->HitSound;
+		SoundPrefetchStr(&gSoundDevice, h->Object);
+		SoundPrefetchStr(&gSoundDevice, h->Flesh);
+		SoundPrefetchStr(&gSoundDevice, h->Wall);
+	}
+}
+
 void SetupMission(Mission *m, struct MissionOptions *mo, int missionIndex) {
 	MissionOptionsInit(mo);
 	mo->index = missionIndex;
@@ -284,6 +318,7 @@ void SetupMission(Mission *m, struct MissionOptions *mo, int missionIndex) {
 	SetupObjectives(m);
 	SetupBadguysForMission(m);
 	SetupWeapons(&mo->Weapons, &m->Weapons);
+	PrefetchSounds(mo);
 }
 void MissionSetupTileClasses(PicManager *pm, const MissionTileClasses *mtc) {
 	SetupWallTileClasses(pm, &mtc->Wall);
@@ -394,6 +429,7 @@ void MissionBegin(struct MissionOptions *m, const NGameBegin gb) {
 	m->state = MISSION_STATE_PLAY;
 	MusicPlay(&gSoundDevice, MUSIC_GAME, gCampaign.Entry.Path,
 			m->missionData->Song);
+	MusicPrefetch(&gSoundDevice, MUSIC_BRIEFING);
 	const char *musicErrorMsg = MusicGetErrorMessage(&gSoundDevice);
 	if (strlen(musicErrorMsg) > 0) {
 		// Display music error message for 2 seconds
@@ -510,6 +546,54 @@ static bool MoreRescuesNeeded(const struct MissionOptions *mo) {
 	return false;
 }
 
+void MissionCheckCompletion(const struct MissionOptions *mo) {
+	// Check if we need to update explore objectives
+	CA_FOREACH(const Objective, o, mo->missionData->Objectives)
+		if (o->Type != OBJECTIVE_INVESTIGATE)
+			continue;
+		const int update = MapGetExploredPercentage(&gMap) - o->done;
+		if (update > 0 && !gCampaign.IsClient) {
+			GameEvent e = GameEventNew(GAME_EVENT_OBJECTIVE_UPDATE);
+			e.u.ObjectiveUpdate.ObjectiveId = _ca_index;
+			e.u.ObjectiveUpdate.Count = update;
+			GameEventsEnqueue(&gGameEvents, e);
+		}CA_FOREACH_END()
+
+	const bool isMissionComplete = GetNumPlayers(PLAYER_ALIVE_OR_DYING, false,
+			false) > 0 && IsMissionComplete(mo);
+	if (mo->state == MISSION_STATE_PLAY && isMissionComplete) {
+		GameEvent e = GameEventNew(GAME_EVENT_MISSION_PICKUP);
+		GameEventsEnqueue(&gGameEvents, e);
+	}
+	if (mo->state == MISSION_STATE_PICKUP && !isMissionComplete) {
+		GameEvent e = GameEventNew(GAME_EVENT_MISSION_INCOMPLETE);
+		GameEventsEnqueue(&gGameEvents, e);
+	}
+	if (mo->state == MISSION_STATE_PICKUP
+			&& mo->pickupTime + PICKUP_LIMIT <= mo->time) {
+		GameEvent e = GameEventNew(GAME_EVENT_MISSION_END);
+		GameEventsEnqueue(&gGameEvents, e);
+	}
+
+	// Check that all players have been destroyed
+	// If the server has no players at all, wait for a player to join
+	if (gPlayerDatas.size > 0) {
+		// Note: there's a period of time where players are dying
+		// Wait until after this period before ending the game
+		bool allPlayersDestroyed = true;
+		CA_FOREACH(const PlayerData, p, gPlayerDatas)
+			if (p->ActorUID != -1) {
+				allPlayersDestroyed = false;
+				break;
+			}CA_FOREACH_END()
+		if (allPlayersDestroyed && AreAllPlayersDeadAndNoLives()) {
+			GameEvent e = GameEventNew(GAME_EVENT_MISSION_END);
+			e.u.MissionEnd.Delay = GAME_OVER_DELAY;
+			GameEventsEnqueue(&gGameEvents, e);
+		}
+	}
+}
+
 void MissionDone(struct MissionOptions *mo, const NMissionEnd end) {
 	mo->isDone = true;
 	mo->DoneCounter = end.Delay;
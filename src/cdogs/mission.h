@@ -219,6 +219,9 @@ bool MissionAllObjectivesComplete(const struct MissionOptions *mo);
 bool IsMissionComplete(const struct MissionOptions *options);
 bool MissionNeedsMoreRescuesInExit(const struct MissionOptions *mo);
 bool MissionHasRequiredObjectives(const struct MissionOptions *mo);
+// Send objective and mission state updates, and end the mission if all the
+// players are dead; only for the server
+void MissionCheckCompletion(const struct MissionOptions *mo);
 void MissionDone(struct MissionOptions *mo, const NMissionEnd end);
 
 // Count the number of keys in the flags
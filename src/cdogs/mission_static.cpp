@@ -29,6 +29,7 @@
 
 #include "algorithms.h"
 #include "json_utils.h"
+#include "layer_csv.h"
 #include "log.h"
 #include "map.h"
 #include "map_archive.h"
@@ -36,7 +37,7 @@
 #include "mission.h"
 #include "utils.h"
 
-static void MissionStaticInit(MissionStatic *m) {
+void MissionStaticInit(MissionStatic *m) {
 	memset(m, 0, sizeof *m);
 	m->TileClasses = hashmap_new();
 	CArrayInit(&m->Tiles, sizeof(int));
@@ -49,7 +50,6 @@ static void MissionStaticInit(MissionStatic *m) {
 
 static void LoadTileClasses(map_t tileClasses, const json_t *node);
 static void LoadOldStaticTileCSV(CArray *tiles, char *tileCSV);
-static void LoadStaticTileCSV(CArray *tiles, char *tileCSV);
 static void ConvertOldTile(MissionStatic *m, const uint16_t t,
 		const TileClass *base);
 static void LoadStaticItems(MissionStatic *m, json_t *node, const char *name,
@@ -61,7 +61,7 @@ static void LoadStaticObjectives(MissionStatic *m, json_t *node, char *name);
 static void LoadStaticKeys(MissionStatic *m, json_t *node, char *name);
 static void LoadStaticExit(MissionStatic *m, json_t *node, char *name);
 bool MissionStaticTryLoadJSON(MissionStatic *m, json_t *node,
-		const int version) {
+		const int version, const struct vec2i size) {
 	MissionStaticInit(m);
 	if (version <= 14) {
 		MissionTileClasses mtc;
@@ -112,19 +112,10 @@ bool MissionStaticTryLoadJSON(MissionStatic *m, json_t *node,
 		CArrayTerminate(&oldTiles);
 		MissionTileClassesTerminate(&mtc);
 	} else {
-		// Tile class definitions
-		LoadTileClasses(m->TileClasses, node);
-
-		// CSV string per row
-		const json_t *tile = json_find_first_label(node, "Tiles")->child->child;
-		while (tile) {
-			LoadStaticTileCSV(&m->Tiles, tile->text);
-			tile = tile->next;
-		}
-		const json_t *a = json_find_first_label(node, "Access")->child->child;
-		while (a) {
-			LoadStaticTileCSV(&m->Access, a->text);
-			a = a->next;
+		// Layers that are missing here are loaded separately, from a compiled
+		// campaign file or streamed out of the JSON
+		if (!MissionStaticLoadTilesJSON(m, node, size)) {
+			return false;
 		}
 	}
 
@@ -141,6 +132,39 @@ bool MissionStaticTryLoadJSON(MissionStatic *m, json_t *node,
 
 	return true;
 }
+static bool LoadStaticLayer(CArray *layer, const json_t *node,
+		const char *name, const struct vec2i size);
+bool MissionStaticLoadTilesJSON(MissionStatic *m, json_t *node,
+		const struct vec2i size) {
+	// Tile class definitions
+	if (json_find_first_label(node, "TileClasses") != NULL) {
+		LoadTileClasses(m->TileClasses, node);
+	}
+
+	return LoadStaticLayer(&m->Tiles, node, "Tiles", size)
+			&& LoadStaticLayer(&m->Access, node, "Access", size);
+}
+static bool LoadStaticLayer(CArray *layer, const json_t *node,
+		const char *name, const struct vec2i size) {
+	const json_t *rows = json_find_first_label(node, name);
+	if (rows == NULL || rows->child == NULL) {
+		return true;
+	}
+	// CSV string per row
+	const int area = size.x * size.y;
+	for (const json_t *row = rows->child->child; row; row = row->next) {
+		if (!LayerCSVLoadRow(layer, area, row->text, strlen(row->text))) {
+			break;
+		}
+	}
+	if ((int) layer->size != area) {
+		LOG(LM_MAP, LL_ERROR, "Static layer %s is not %dx%d", name, size.x,
+				size.y);
+		CArrayClear(layer);
+		return false;
+	}
+	return true;
+}
 static void LoadTileClasses(map_t tileClasses, const json_t *node) {
 	const json_t *class_json = json_find_first_label(node, "TileClasses");
 	if (!class_json || !class_json->child || !class_json->child->child) {
@@ -170,14 +194,6 @@ static void LoadOldStaticTileCSV(CArray *tiles, char *tileCSV) {
 		pch = strtok(NULL, ",");
 	}
 }
-static void LoadStaticTileCSV(CArray *tiles, char *tileCSV) {
-	char *pch = strtok(tileCSV, ",");
-	while (pch != NULL) {
-		const int n = atoi(pch);
-		CArrayPushBack(tiles, &n);
-		pch = strtok(NULL, ",");
-	}
-}
 static void ConvertOldTile(MissionStatic *m, const uint16_t t,
 		const TileClass *base) {
 	char keyBuf[6];
@@ -453,10 +469,7 @@ static json_t* SaveStaticKeys(const MissionStatic *m);
 static json_t* SaveVec2i(struct vec2i v);
 void MissionStaticSaveJSON(const MissionStatic *m, const struct vec2i size,
 		json_t *node) {
-	json_insert_pair_into_object(node, "TileClasses", SaveStaticTileClasses(m));
-	json_insert_pair_into_object(node, "Tiles", SaveStaticCSV(&m->Tiles, size));
-	json_insert_pair_into_object(node, "Access",
-			SaveStaticCSV(&m->Access, size));
+	MissionStaticSaveTilesJSON(m, size, node);
 	json_insert_pair_into_object(node, "StaticItems", SaveStaticItems(m));
 	json_insert_pair_into_object(node, "StaticCharacters",
 			SaveStaticCharacters(m));
@@ -470,6 +483,13 @@ void MissionStaticSaveJSON(const MissionStatic *m, const struct vec2i size,
 	json_insert_pair_into_object(exitNode, "End", SaveVec2i(m->Exit.End));
 	json_insert_pair_into_object(node, "Exit", exitNode);
 }
+void MissionStaticSaveTilesJSON(const MissionStatic *m,
+		const struct vec2i size, json_t *node) {
+	json_insert_pair_into_object(node, "TileClasses", SaveStaticTileClasses(m));
+	json_insert_pair_into_object(node, "Tiles", SaveStaticCSV(&m->Tiles, size));
+	json_insert_pair_into_object(node, "Access",
+			SaveStaticCSV(&m->Access, size));
+}
 typedef struct {
 	json_t *items;
 	map_t tileClasses;
@@ -500,27 +520,10 @@ static int SaveStaticTileClass(any_t data, any_t key) {
 static json_t* SaveStaticCSV(const CArray *values, const struct vec2i size) {
 	// Write out each row of tiles individually as a single CSV
 	json_t *rows = json_new_array();
-	// Create a text buffer for CSV
-	// The buffer will contain n*5 chars (tiles, allow 5 chars each),
-	// and n - 1 commas, so 6n total
 	char *rowBuf;
-	rowBuf = static_cast<char*>(malloc(size.x * 6));
-	if (rowBuf == NULL && size.x * 6 > 0) {
-		exit(1);
-	}
-//	CMALLOC(rowBuf, size.x * 6);
+	CMALLOC(rowBuf, LAYER_CSV_ROW_MAX(size.x));
 	for (int i = 0; i < size.y; i++) {
-		char *pBuf = rowBuf;
-		*pBuf = '\0';
-		for (int j = 0; j < size.x; j++) {
-			char buf[6];
-			snprintf(buf, 6, "%d", *(int*) CArrayGet(values, i * size.x + j));
-			strcpy(pBuf, buf);
-			pBuf += strlen(buf);
-			if (j < size.x - 1) {
-				*pBuf++ = ',';
-			}
-		}
+		LayerCSVSaveRow(rowBuf, values, size.x, i);
 		json_insert_child(rows, json_new_string(rowBuf));
 	}
 	CFREE(rowBuf);
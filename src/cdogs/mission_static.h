@@ -50,8 +50,15 @@ typedef struct {
 	} Exit;
 } MissionStatic;
 
+void MissionStaticInit(MissionStatic *m);
 bool MissionStaticTryLoadJSON(MissionStatic *m, json_t *node,
-		const int version);
+		const int version, const struct vec2i size);
+// Load/save just the tile classes, tiles and access layers
+// Returns false if a layer isn't the size of the mission
+bool MissionStaticLoadTilesJSON(MissionStatic *m, json_t *node,
+		const struct vec2i size);
+void MissionStaticSaveTilesJSON(const MissionStatic *m,
+		const struct vec2i size, json_t *node);
 void MissionStaticFromMap(MissionStatic *m, const Map *map);
 void MissionStaticTerminate(MissionStatic *m);
 void MissionStaticSaveJSON(const MissionStatic *m, const struct vec2i size,
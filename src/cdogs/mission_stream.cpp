@@ -0,0 +1,350 @@
+/*
+ C-Dogs SDL
+ A port of the legendary (and fun) action/arcade cdogs.
+
+ Copyright (c) 2020 Cong Xu
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "mission_stream.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <json/json.h>
+
+#include "json_utils.h"
+#include "layer_csv.h"
+#include "log.h"
+#include "map_new.h"
+#include "utils.h"
+#include "yajl/api/yajl_parse.h"
+
+#define STREAM_BUF_SIZE 65536
+
+typedef struct {
+	CArray values;	// of int
+	// Rows as CSV strings, kept if the layer comes before the mission size
+	CArray rows;	// of char *
+} StreamLayer;
+static void StreamLayerInit(StreamLayer *l) {
+	CArrayInit(&l->values, sizeof(int));
+	CArrayInit(&l->rows, sizeof(char*));
+}
+static void StreamLayerClear(StreamLayer *l) {
+	CArrayClear(&l->values);
+	CA_FOREACH(char *, row, l->rows)
+		CFREE(*row);
+	CA_FOREACH_END()
+	CArrayClear(&l->rows);
+}
+static void StreamLayerTerminate(StreamLayer *l) {
+	StreamLayerClear(l);
+	CArrayTerminate(&l->values);
+	CArrayTerminate(&l->rows);
+}
+
+typedef struct {
+	CArray *missions;
+	int version;
+	int depth;	// of maps and arrays, including the root map
+	bool isMissionsKey;	// the last root key was "Missions"
+	bool inMissions;
+	// DOM of the mission being loaded, and the node values are added to
+	json_t *mission;
+	json_t *node;
+	char *key;	// escaped key for the next value in an object
+	// Static tile layers are parsed directly into these
+	StreamLayer *nextLayer;	// set if the next value is a layer
+	StreamLayer *layer;	// the layer being loaded
+	int layerSize;	// of the mission, or 0 if not known yet
+	StreamLayer tiles;
+	StreamLayer access;
+} MissionStream;
+
+static char* CopyText(const unsigned char *s, const size_t len) {
+	char *text;
+	CMALLOC(text, len + 1);
+	memcpy(text, s, len);
+	text[len] = '\0';
+	return text;
+}
+static bool InMission(const MissionStream *ms) {
+	return ms->mission != NULL && ms->layer == NULL;
+}
+static void AddValue(MissionStream *ms, json_t *value) {
+	ms->nextLayer = NULL;
+	if (ms->node->type == JSON_OBJECT) {
+		json_t *label = json_new_string(ms->key);
+		json_insert_child(label, value);
+		json_insert_child(ms->node, label);
+		CFREE(ms->key);
+		ms->key = NULL;
+	} else {
+		json_insert_child(ms->node, value);
+	}
+}
+
+static int OnNull(void *ctx) {
+	MissionStream *ms = static_cast<MissionStream*>(ctx);
+	if (InMission(ms)) {
+		AddValue(ms, json_new_null());
+	}
+	return 1;
+}
+static int OnBoolean(void *ctx, int boolVal) {
+	MissionStream *ms = static_cast<MissionStream*>(ctx);
+	if (InMission(ms)) {
+		AddValue(ms, boolVal ? json_new_true() : json_new_false());
+	}
+	return 1;
+}
+static int OnNumber(void *ctx, const char *numberVal, size_t numberLen) {
+	MissionStream *ms = static_cast<MissionStream*>(ctx);
+	if (InMission(ms)) {
+		char *text = CopyText(
+				reinterpret_cast<const unsigned char*>(numberVal), numberLen);
+		AddValue(ms, json_new_number(text));
+		CFREE(text);
+	}
+	return 1;
+}
+static int OnString(void *ctx, const unsigned char *stringVal,
+		size_t stringLen) {
+	MissionStream *ms = static_cast<MissionStream*>(ctx);
+	if (ms->layer != NULL && ms->layerSize == 0) {
+		// Parsed once the mission size is known
+		char *row = CopyText(stringVal, stringLen);
+		CArrayPushBack(&ms->layer->rows, &row);
+	} else if (ms->layer != NULL) {
+		// A row of the layer, as CSV
+		if (!LayerCSVLoadRow(&ms->layer->values, ms->layerSize,
+				reinterpret_cast<const char*>(stringVal), stringLen)) {
+			LOG(LM_MAP, LL_ERROR, "Static layer is not %d tiles",
+					ms->layerSize);
+			return 0;
+		}
+	} else if (InMission(ms)) {
+		// The DOM holds strings escaped, as they are in the file
+		char *text = CopyText(stringVal, stringLen);
+		char *escaped = json_escape(text);
+		AddValue(ms, json_new_string(escaped));
+		CFREE(escaped);
+		CFREE(text);
+	}
+	return 1;
+}
+static int OnStartContainer(MissionStream *ms, const bool isMap) {
+	if (InMission(ms)) {
+		json_t *value = isMap ? json_new_object() : json_new_array();
+		AddValue(ms, value);
+		ms->node = value;
+	}
+	ms->depth++;
+	return 1;
+}
+static int OnStartMap(void *ctx) {
+	MissionStream *ms = static_cast<MissionStream*>(ctx);
+	if (ms->inMissions && ms->depth == 2) {
+		ms->mission = json_new_object();
+		ms->node = ms->mission;
+		ms->depth++;
+		return 1;
+	}
+	return OnStartContainer(ms, true);
+}
+static int OnMapKey(void *ctx, const unsigned char *key, size_t stringLen) {
+	MissionStream *ms = static_cast<MissionStream*>(ctx);
+	char *text = CopyText(key, stringLen);
+	if (ms->depth == 1) {
+		ms->isMissionsKey = strcmp(text, "Missions") == 0;
+	} else if (InMission(ms)) {
+		if (ms->depth == 3 && ms->version >= 15) {
+			if (strcmp(text, "Tiles") == 0) {
+				ms->nextLayer = &ms->tiles;
+			} else if (strcmp(text, "Access") == 0) {
+				ms->nextLayer = &ms->access;
+			}
+		}
+		CFREE(ms->key);
+		ms->key = json_escape(text);
+	}
+	CFREE(text);
+	return 1;
+}
+static bool FinishMission(MissionStream *ms);
+static int OnEndContainer(void *ctx) {
+	MissionStream *ms = static_cast<MissionStream*>(ctx);
+	ms->depth--;
+	if (ms->layer != NULL) {
+		ms->layer = NULL;
+		CFREE(ms->key);
+		ms->key = NULL;
+	} else if (ms->mission != NULL && ms->depth == 2) {
+		return FinishMission(ms);
+	} else if (ms->mission != NULL) {
+		// Go up to the parent container, past the label if in an object
+		json_t *parent = ms->node->parent;
+		if (parent->type == JSON_STRING) {
+			parent = parent->parent;
+		}
+		ms->node = parent;
+	} else if (ms->inMissions && ms->depth == 1) {
+		ms->inMissions = false;
+	}
+	return 1;
+}
+static int OnStartArray(void *ctx) {
+	MissionStream *ms = static_cast<MissionStream*>(ctx);
+	if (ms->depth == 1 && ms->isMissionsKey) {
+		ms->inMissions = true;
+		ms->depth++;
+		return 1;
+	}
+	if (InMission(ms) && ms->nextLayer != NULL) {
+		// Runs can't make the layer bigger than the mission; the editor saves
+		// the mission size before its layers, but if it isn't known yet the
+		// rows are kept until the mission ends
+		struct vec2i size = svec2i_zero();
+		LoadInt(&size.x, ms->mission, "Width");
+		LoadInt(&size.y, ms->mission, "Height");
+		ms->layerSize = size.x > 0 && size.y > 0 ? size.x * size.y : 0;
+		ms->layer = ms->nextLayer;
+		ms->nextLayer = NULL;
+		ms->depth++;
+		return 1;
+	}
+	return OnStartContainer(ms, false);
+}
+static void MoveLayer(CArray *dst, CArray *src);
+static bool IsLayerComplete(StreamLayer *layer, const struct vec2i size);
+static bool FinishMission(MissionStream *ms) {
+	bool ok = true;
+	Mission m;
+	if (MissionLoadJSON(&m, ms->mission, ms->version)) {
+		if (m.Type == MAPTYPE_STATIC) {
+			ok = IsLayerComplete(&ms->tiles, m.Size)
+					&& IsLayerComplete(&ms->access, m.Size);
+			MoveLayer(&m.u.Static.Tiles, &ms->tiles.values);
+			MoveLayer(&m.u.Static.Access, &ms->access.values);
+		}
+		if (ok) {
+			CArrayPushBack(ms->missions, &m);
+		} else {
+			LOG(LM_MAP, LL_ERROR, "Static layers are not %dx%d", m.Size.x,
+					m.Size.y);
+			MissionTerminate(&m);
+		}
+	}
+	json_free_value(&ms->mission);
+	ms->node = NULL;
+	StreamLayerClear(&ms->tiles);
+	StreamLayerClear(&ms->access);
+	return ok;
+}
+static bool IsLayerComplete(StreamLayer *layer, const struct vec2i size) {
+	const int area = size.x * size.y;
+	CA_FOREACH(const char *, row, layer->rows)
+		if (!LayerCSVLoadRow(&layer->values, area, *row, strlen(*row))) {
+			return false;
+		}
+	CA_FOREACH_END()
+	// Missing layers are loaded from the compiled campaign file instead
+	return layer->values.size == 0 || (int) layer->values.size == area;
+}
+static void MoveLayer(CArray *dst, CArray *src) {
+	if (src->size == 0) {
+		return;
+	}
+	CArrayTerminate(dst);
+	*dst = *src;
+	CArrayInit(src, sizeof(int));
+}
+
+static const yajl_callbacks sCallbacks = {
+	OnNull,
+	OnBoolean,
+	NULL,
+	NULL,
+	OnNumber,
+	OnString,
+	OnStartMap,
+	OnMapKey,
+	OnEndContainer,
+	OnStartArray,
+	OnEndContainer
+};
+
+bool MissionsLoadStream(CArray *missions, const char *path,
+		const int version) {
+	bool ok = false;
+	MissionStream ms;
+	memset(&ms, 0, sizeof ms);
+	ms.missions = missions;
+	ms.version = version;
+	StreamLayerInit(&ms.tiles);
+	StreamLayerInit(&ms.access);
+	yajl_handle h = NULL;
+	unsigned char *buf = NULL;
+	FILE *f = fopen(path, "rb");
+	if (f == NULL) {
+		LOG(LM_MAP, LL_ERROR, "Cannot open %s: %s", path, strerror(errno));
+		goto bail;
+	}
+	h = yajl_alloc(&sCallbacks, NULL, &ms);
+	CMALLOC(buf, STREAM_BUF_SIZE);
+	for (;;) {
+		const size_t n = fread(buf, 1, STREAM_BUF_SIZE, f);
+		if (n == 0 && ferror(f)) {
+			LOG(LM_MAP, LL_ERROR, "Cannot read %s: %s", path,
+					strerror(errno));
+			goto bail;
+		}
+		const yajl_status status =
+				n > 0 ? yajl_parse(h, buf, n) : yajl_complete_parse(h);
+		if (status != yajl_status_ok) {
+			unsigned char *err = yajl_get_error(h, 1, buf, n);
+			LOG(LM_MAP, LL_ERROR, "Invalid JSON in %s: %s", path, err);
+			yajl_free_error(h, err);
+			goto bail;
+		}
+		if (n == 0) {
+			break;
+		}
+	}
+	ok = true;
+
+bail:
+	json_free_value(&ms.mission);
+	CFREE(ms.key);
+	StreamLayerTerminate(&ms.tiles);
+	StreamLayerTerminate(&ms.access);
+	if (h != NULL) {
+		yajl_free(h);
+	}
+	CFREE(buf);
+	if (f != NULL) {
+		fclose(f);
+	}
+	return ok;
+}
@@ -42,15 +42,18 @@
 #include "log.h"
 #include "sounds.h"
 
-Mix_Music* MusicLoad(const char *path) {
+bool MusicIsSupported(const char *path) {
 	// Only load music from known extensions
 	const char *ext = strrchr(path, '.');
-	if (ext == NULL
-			|| !(strcmp(ext, ".it") == 0 || strcmp(ext, ".IT") == 0
+	return ext != NULL
+			&& (strcmp(ext, ".it") == 0 || strcmp(ext, ".IT") == 0
 					|| strcmp(ext, ".mod") == 0 || strcmp(ext, ".MOD") == 0
 					|| strcmp(ext, ".ogg") == 0 || strcmp(ext, ".OGG") == 0
 					|| strcmp(ext, ".s3m") == 0 || strcmp(ext, ".S3M") == 0
-					|| strcmp(ext, ".xm") == 0 || strcmp(ext, ".XM") == 0)) {
+					|| strcmp(ext, ".xm") == 0 || strcmp(ext, ".XM") == 0);
+}
+Mix_Music* MusicLoad(const char *path) {
+	if (!MusicIsSupported(path)) {
 		return NULL;
 	}
 	LOG(LM_MAIN, LL_TRACE, "loading music file %s", path);
@@ -88,13 +91,13 @@ static bool Play(SoundDevice *device, const char *path) {
 	return PlayMusic(device);
 }
 
+static Mix_Music* TakePrefetched(SoundDevice *device, const char *path);
 void MusicPlay(SoundDevice *device, const MusicType type,
 		const char *missionPath, const char *music) {
 	// Play a tune
 	// Start by trying to play a mission specific song,
 	// otherwise pick one from the general collection...
 	MusicStop(device);
-	device->musicIsDynamic = false;
 	bool played = false;
 	if (music != NULL && strlen(music) != 0) {
 		char buf[CDOGS_PATH_MAX];
@@ -111,32 +114,80 @@ void MusicPlay(SoundDevice *device, const MusicType type,
 			strcat(buf, music);
 			played = Play(device, buf);
 		}
-		if (played) {
-			device->musicIsDynamic = true;
-		}
 	}
 	if (!played) {
 		CArray *tracks = &device->musicTracks[type];
 		if (tracks->size == 0) {
 			return;
 		}
-		device->music = *(Mix_Music**) CArrayGet(tracks, 0);
-		// Shuffle tracks
+		const char *path = *(char**) CArrayGet(tracks, 0);
+		// Shuffle tracks, so that the next track of this type is different
 		if (tracks->size > 1) {
-			while (device->music == *(Mix_Music**) CArrayGet(tracks, 0)) {
+			while (path == *(char**) CArrayGet(tracks, 0)) {
 				CArrayShuffle(tracks);
 			}
 		}
+		if (!device->isInitialised) {
+			return;
+		}
+		device->music = TakePrefetched(device, path);
+		if (device->music == NULL) {
+			device->music = MusicLoad(path);
+		}
 		PlayMusic(device);
 	}
 }
+static Mix_Music* TakePrefetched(SoundDevice *device, const char *path) {
+	if (device->musicNext.Path != path) {
+		return NULL;
+	}
+	SDL_WaitThread(device->musicNext.Thread, NULL);
+	Mix_Music *m = device->musicNext.Music;
+	memset(&device->musicNext, 0, sizeof device->musicNext);
+	return m;
+}
+
+static int PrefetchThread(void *data);
+void MusicPrefetch(SoundDevice *device, const MusicType type) {
+	const CArray *tracks = &device->musicTracks[type];
+	if (!device->isInitialised || tracks->size == 0) {
+		return;
+	}
+	// The next track is at the front
+	const char *path = *(char**) CArrayGet(tracks, 0);
+	if (device->musicNext.Path == path) {
+		return;
+	}
+	MusicPrefetchClear(device);
+	device->musicNext.Path = path;
+	// Loading only reads and decodes the file, without touching the mixer
+	device->musicNext.Thread = SDL_CreateThread(PrefetchThread,
+			"MusicPrefetch", device);
+	if (device->musicNext.Thread == NULL) {
+		LOG(LM_SOUND, LL_WARN, "Cannot create music prefetch thread: %s",
+				SDL_GetError());
+		device->musicNext.Path = NULL;
+	}
+}
+static int PrefetchThread(void *data) {
+	SoundDevice *device = static_cast<SoundDevice*>(data);
+	device->musicNext.Music = MusicLoad(device->musicNext.Path);
+	return 0;
+}
+void MusicPrefetchClear(SoundDevice *device) {
+	if (device->musicNext.Path == NULL) {
+		return;
+	}
+	Mix_Music *m = TakePrefetched(device, device->musicNext.Path);
+	if (m != NULL) {
+		Mix_FreeMusic(m);
+	}
+}
 
 void MusicStop(SoundDevice *device) {
 	if (device->music != NULL) {
 		Mix_HaltMusic();
-		if (device->musicIsDynamic) {
-			Mix_FreeMusic(device->music);
-		}
+		Mix_FreeMusic(device->music);
 		device->music = NULL;
 	}
 }
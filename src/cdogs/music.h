@@ -50,9 +50,14 @@
 
 #include "sounds.h"
 
+bool MusicIsSupported(const char *path);
 Mix_Music* MusicLoad(const char *path);
 void MusicPlay(SoundDevice *device, const MusicType type,
 		const char *missionPath, const char *music);
+// Load the next track of a type in the background, so that playing it later
+// doesn't stall; only one track is prefetched at a time
+void MusicPrefetch(SoundDevice *device, const MusicType type);
+void MusicPrefetchClear(SoundDevice *device);
 void MusicStop(SoundDevice *device);
 void MusicPause(SoundDevice *s);
 void MusicResume(SoundDevice *device);
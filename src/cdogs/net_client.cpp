@@ -29,6 +29,8 @@
 #include "net_client.h"
 
 #include <errno.h>
+#include <math.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "proto/nanopb/pb_decode.h"
@@ -37,6 +39,7 @@
 #include "game_events.h"
 #include "gamedata.h"
 #include "log.h"
+#include "net_join.h"
 #include "net_server.h"
 #include "player.h"
 #include "utils.h"
@@ -51,12 +54,18 @@ void NetClientInit(NetClient *n) {
 	memset(n, 0, sizeof *n);
 	n->ClientId = -1;	// -1 is unset
 	n->scanner = ENET_SOCKET_NULL;
-	n->client = enet_host_create(NULL, 1, 2,
+	n->client = enet_host_create(NULL, 1, DELIVERY_COUNT,
 			57600 / 8 /* 56K modem with 56 Kbps downstream bandwidth */,
 			14400 / 8 /* 56K modem with 14 Kbps upstream bandwidth */);
 	if (n->client == NULL) {
 		LOG(LM_NET, LL_ERROR, "cannot create ENet client host");
 	}
+	for (int i = 0; i < DELIVERY_COUNT; i++) {
+		NetBatchInit(&n->batches[i], (GameEventDelivery) i);
+	}
+	NetSnapshotsInit(&n->Snapshots);
+	CArrayInit(&n->snapshot.Actors, sizeof(NetSnapshotActor));
+	CArrayInit(&n->joinState, sizeof(uint8_t));
 	CArrayInit(&n->ScannedAddrs, sizeof(ScanInfo));
 	CArrayInit(&n->scannedAddrBuf, sizeof(ScanInfo));
 }
@@ -74,6 +83,12 @@ void NetClientTerminate(NetClient *n) {
 		enet_socket_destroy(n->scanner);
 		n->scanner = ENET_SOCKET_NULL;
 	}
+	for (int i = 0; i < DELIVERY_COUNT; i++) {
+		NetBatchTerminate(&n->batches[i]);
+	}
+	NetSnapshotsTerminate(&n->Snapshots);
+	CArrayTerminate(&n->snapshot.Actors);
+	CArrayTerminate(&n->joinState);
 	CArrayTerminate(&n->ScannedAddrs);
 	CArrayTerminate(&n->scannedAddrBuf);
 }
@@ -143,8 +158,8 @@ bool NetClientTryConnect(NetClient *n, const ENetAddress addr) {
 	enet_address_get_host_ip(&addr, buf, sizeof buf);
 	LOG(LM_NET, LL_INFO, "Connecting client to %s:%u...", buf, addr.port);
 
-	/* Initiate the connection, allocating the two channels 0 and 1. */
-	n->peer = enet_host_connect(n->client, &addr, 2, 0);
+	/* Initiate the connection, allocating a channel per delivery class. */
+	n->peer = enet_host_connect(n->client, &addr, DELIVERY_COUNT, 0);
 	if (n->peer == NULL) {
 		LOG(LM_NET, LL_WARN, "No server connection found");
 		goto bail;
@@ -168,6 +183,7 @@ bool NetClientTryConnect(NetClient *n, const ENetAddress addr) {
 
 	// Tell the server that this is a proper connection request
 	NetClientSendMsg(n, GAME_EVENT_CLIENT_CONNECT, NULL);
+	NetClientFlush(n);
 
 	return NetClientIsConnected(n);
 
@@ -236,10 +252,19 @@ void NetClientDisconnect(NetClient *n) {
 		enet_peer_disconnect_now(n->peer, 0);
 		n->peer = NULL;
 	}
+	for (int i = 0; i < DELIVERY_COUNT; i++) {
+		NetBatchClear(&n->batches[i]);
+	}
 	// Reset IDs so that when we start a server, we use our own IDs
 	n->ClientId = -1;
 	n->FirstPlayerUID = 0;
 	n->Ready = false;
+	NetSnapshotsReset(&n->Snapshots);
+	n->snapshot.Seq = 0;
+	CArrayClear(&n->snapshot.Actors);
+	n->snapshotLastSeq = 0;
+	n->SnapshotJitter = 0;
+	CArrayClear(&n->joinState);
 	// Also reset the scanned address buffer
 	CArrayClear(&n->ScannedAddrs);
 	CArrayClear(&n->scannedAddrBuf);
@@ -322,10 +347,20 @@ static void Scanning(NetClient *n) {
 		}
 	}
 }
+static void OnReceiveMsg(NetClient *n, const NetMsg *msg);
+static void OnSnapshot(NetClient *n, const NSnapshot *ns);
+static void OnJoinChunk(NetClient *n, const NJoinChunk *jc);
 static void OnReceive(NetClient *n, ENetEvent event) {
-	const GameEventType msg = (GameEventType) *(uint32_t*) event.packet->data;
-	LOG(LM_NET, LL_TRACE, "recv msg(%u)", msg);
-	const GameEventEntry gee = GameEventGetEntry(msg);
+	size_t offset = 0;
+	NetMsg msg;
+	while (NetBatchNext(event.packet, &offset, &msg)) {
+		OnReceiveMsg(n, &msg);
+	}
+	enet_packet_destroy(event.packet);
+}
+static void OnReceiveMsg(NetClient *n, const NetMsg *msg) {
+	LOG(LM_NET, LL_TRACE, "recv msg(%u)", msg->Type);
+	const GameEventEntry gee = GameEventGetEntry(msg->Type);
 	if (gee.Enqueue) {
 		if (gee.GameStart && !gMission.HasStarted) {
 			LOG(LM_NET, LL_TRACE, "ignore game start gameEvent(%d)",
@@ -335,7 +370,7 @@ static void OnReceive(NetClient *n, ENetEvent event) {
 			LOG(LM_NET, LL_TRACE, "recv gameEvent(%d)", (int )gee.Type);
 			GameEvent e = GameEventNew(gee.Type);
 			if (gee.Fields != NULL) {
-				NetDecode(event.packet, &e.u, gee.Fields);
+				NetDecode(msg, &e.u, gee.Fields);
 			}
 
 			// For actor events, check if UID is not for local player
@@ -400,7 +435,7 @@ static void OnReceive(NetClient *n, ENetEvent event) {
 			CASSERT(n->ClientId == -1,
 					"unexpected client ID message, already set");
 			NClientId cid;
-			NetDecode(event.packet, &cid, NClientId_fields);
+			NetDecode(msg, &cid, NClientId_fields);
 			LOG(LM_NET, LL_DEBUG, "recv clientId(%u) uid(%u)", cid.Id,
 					cid.FirstPlayerUID);
 			n->ClientId = (int) cid.Id;
@@ -415,7 +450,7 @@ static void OnReceive(NetClient *n, ENetEvent event) {
 				LOG(LM_NET, LL_DEBUG,
 						"NetClient: received campaign def, loading...");
 				NCampaignDef def;
-				NetDecode(event.packet, &def, NCampaignDef_fields);
+				NetDecode(msg, &def, NCampaignDef_fields);
 				gCampaign.Entry.Mode = (GameMode) def.GameMode;
 				// Normalise the path
 				char buf[CDOGS_PATH_MAX];
@@ -440,18 +475,159 @@ static void OnReceive(NetClient *n, ENetEvent event) {
 				gMission.HasStarted = true;
 			}
 			break;
+		case GAME_EVENT_SNAPSHOT: {
+			NSnapshot ns;
+			NetDecode(msg, &ns, NSnapshot_fields);
+			OnSnapshot(n, &ns);
+		}
+			break;
+		case GAME_EVENT_JOIN_CHUNK: {
+			NJoinChunk jc;
+			NetDecode(msg, &jc, NJoinChunk_fields);
+			OnJoinChunk(n, &jc);
+		}
+			break;
 		default:
 			CASSERT(false, "unexpected message type")
 			;
 			break;
 		}
 	}
-	enet_packet_destroy(event.packet);
+}
+static void OnJoinChunk(NetClient *n, const NJoinChunk *jc) {
+	// Ignored unless we've started, like the events the chunks replace
+	if (!gMission.HasStarted) {
+		return;
+	}
+	// Chunks arrive in order; start again on the first chunk
+	if (jc->Offset == 0) {
+		CArrayClear(&n->joinState);
+	}
+	if (jc->Offset != n->joinState.size
+			|| jc->Offset + jc->Data.size > jc->Total) {
+		LOG(LM_NET, LL_ERROR, "unexpected join chunk offset(%u) total(%u)",
+				jc->Offset, jc->Total);
+		return;
+	}
+	CArrayResize(&n->joinState, jc->Offset + jc->Data.size, NULL);
+	memcpy(CArrayGet(&n->joinState, jc->Offset), jc->Data.bytes,
+			jc->Data.size);
+	LOG(LM_NET, LL_DEBUG, "recv join state %d/%d bytes",
+			(int )n->joinState.size, (int )jc->Total);
+	if (n->joinState.size < jc->Total) {
+		return;
+	}
+	// Keep the payload until the game loop gets to it; the map may not have
+	// been built yet
+	GameEventsEnqueue(&gGameEvents, GameEventNew(GAME_EVENT_JOIN_STATE));
+}
+void NetClientApplyJoinState(NetClient *n) {
+	// May have been cleared by a disconnect
+	if (n->joinState.size == 0) {
+		return;
+	}
+	NetJoinApply(&n->joinState);
+	CArrayClear(&n->joinState);
+}
+static void ApplySnapshotActor(const NetSnapshotActor *sa,
+		const NActorSnapshot *d);
+static void UpdateSnapshotJitter(NetClient *n, const uint32_t seq);
+static void OnSnapshot(NetClient *n, const NSnapshot *ns) {
+	if (!gMission.HasStarted) {
+		return;
+	}
+	if (ns->Seq != n->snapshot.Seq) {
+		// Parts of older snapshots can't be completed any more
+		if (ns->Seq < n->snapshot.Seq) {
+			return;
+		}
+		// Start assembling a new snapshot; we need its base to decode it
+		if (ns->BaseSeq != 0
+				&& NetSnapshotsGet(&n->Snapshots, ns->BaseSeq) == NULL) {
+			LOG(LM_NET, LL_DEBUG, "missing snapshot base(%u) for seq(%u)",
+					ns->BaseSeq, ns->Seq);
+			return;
+		}
+		UpdateSnapshotJitter(n, ns->Seq);
+		n->snapshot.Seq = ns->Seq;
+		n->snapshotParts = 0;
+		CArrayClear(&n->snapshot.Actors);
+	}
+	const NetSnapshot *base = NetSnapshotsGet(&n->Snapshots, ns->BaseSeq);
+	for (int i = 0; i < (int) ns->Actors_count; i++) {
+		const NActorSnapshot *d = &ns->Actors[i];
+		const NetSnapshotActor *sb = base != NULL ?
+				NetSnapshotFindActor(base, (int) d->UID,
+						(int) n->snapshot.Actors.size) : NULL;
+		const NetSnapshotActor sa = NetSnapshotActorApply(d, sb);
+		CArrayPushBack(&n->snapshot.Actors, &sa);
+		ApplySnapshotActor(&sa, d);
+	}
+	n->snapshotParts++;
+	if (n->snapshotParts < (int) ns->Parts) {
+		return;
+	}
+
+	// Snapshot complete; keep it as a base for future deltas and ack it
+	NetSnapshot *s = NetSnapshotsNew(&n->Snapshots, ns->Seq);
+	const CArray temp = s->Actors;
+	s->Actors = n->snapshot.Actors;
+	n->snapshot.Actors = temp;
+	CArrayClear(&n->snapshot.Actors);
+	NSnapshotAck ack;
+	ack.Seq = ns->Seq;
+	NetClientSendMsg(n, GAME_EVENT_SNAPSHOT_ACK, &ack);
+}
+static void UpdateSnapshotJitter(NetClient *n, const uint32_t seq) {
+	// Compare the time between snapshots with the time the server took to
+	// send them, and keep a moving average of the difference
+	if (n->snapshotLastSeq != 0 && seq > n->snapshotLastSeq) {
+		const int expected =
+				NET_SNAPSHOT_INTERVAL * (int) (seq - n->snapshotLastSeq);
+		const int actual = gMission.time - n->snapshotTicks;
+		const float jitter = (float) abs(actual - expected);
+		n->SnapshotJitter = n->SnapshotJitter * 0.9f + jitter * 0.1f;
+	}
+	n->snapshotLastSeq = seq;
+	n->snapshotTicks = gMission.time;
+}
+static void ApplySnapshotActor(const NetSnapshotActor *sa,
+		const NActorSnapshot *d) {
+	TActor *a = ActorGetByUID(sa->UID);
+	if (a == NULL || !a->isInUse) {
+		return;
+	}
+	// Local players are predicted by us; only correct them if we were wrong
+	if (ActorIsLocalPlayer(a->uid)) {
+		if (d->has_InputSeq) {
+			ActorReconcile(a, sa->InputSeq, sa->Pos);
+		}
+		return;
+	}
+	// Only correct what has changed, via the same events as the server sends
+	if (d->has_Pos || d->has_MoveVel) {
+		GameEvent e = GameEventNew(GAME_EVENT_ACTOR_MOVE);
+		e.u.ActorMove.UID = sa->UID;
+		e.u.ActorMove.Pos = Vec2ToNet(sa->Pos);
+		e.u.ActorMove.MoveVel = Vec2ToNet(sa->MoveVel);
+		GameEventsEnqueue(&gGameEvents, e);
+	}
+	if (d->has_Dir) {
+		GameEvent e = GameEventNew(GAME_EVENT_ACTOR_DIR);
+		e.u.ActorDir.UID = sa->UID;
+		e.u.ActorDir.Dir = sa->Dir;
+		GameEventsEnqueue(&gGameEvents, e);
+	}
 }
 
 void NetClientFlush(NetClient *n) {
 	if (n->client == NULL)
 		return;
+	for (int i = 0; n->peer != NULL && i < DELIVERY_COUNT; i++) {
+		if (!NetBatchIsEmpty(&n->batches[i])) {
+			NetBatchFlush(&n->batches[i], n->peer);
+		}
+	}
 	enet_host_flush(n->client);
 }
 
@@ -461,7 +637,16 @@ void NetClientSendMsg(NetClient *n, const GameEventType e, const void *data) {
 	}
 
 	LOG(LM_NET, LL_TRACE, "NetClient: send msg type %d", (int )e);
-	enet_peer_send(n->peer, 0, NetEncode(e, data));
+	const GameEventEntry entry = GameEventGetEntry(e);
+	NetBatchEncode(
+			&n->batches[entry.Submit ? DELIVERY_RELIABLE : entry.Delivery], e,
+			data);
+}
+
+int NetClientGetInterpDelay(const NetClient *n) {
+	const int delay =
+			NET_SNAPSHOT_INTERVAL + (int) ceilf(n->SnapshotJitter * 2);
+	return MIN(delay, NET_SNAPSHOT_INTERVAL * 4);
 }
 
 bool NetClientIsConnected(const NetClient *n) {
@@ -30,6 +30,7 @@
 
 #include <time.h>
 
+#include "net_snapshot.h"
 #include "net_util.h"
 
 // Stored information about game servers scanned
@@ -42,9 +43,22 @@ typedef struct {
 typedef struct {
 	ENetHost *client;
 	ENetPeer *peer;
+	// Messages to send on the next flush, by GameEventDelivery
+	NetBatch batches[DELIVERY_COUNT];
 	int ClientId;
 	int FirstPlayerUID;
 	bool Ready;
+	// Snapshots received from the server, used as delta bases
+	NetSnapshots Snapshots;
+	// Snapshot being assembled from its parts
+	NetSnapshot snapshot;
+	int snapshotParts;
+	// Arrival of snapshots, for adapting the remote actor interpolation delay
+	int snapshotTicks;
+	uint32_t snapshotLastSeq;
+	float SnapshotJitter;
+	// Join state being received in chunks (of uint8_t)
+	CArray joinState;
 	// Socket used to scan for LAN servers
 	ENetSocket scanner;
 	// Only scan for a period; if > 0 then we are scanning
@@ -70,7 +84,12 @@ bool NetClientTryScanAndConnect(NetClient *n, const enet_uint32 host);
 void NetClientDisconnect(NetClient *n);
 void NetClientPoll(NetClient *n);
 void NetClientFlush(NetClient *n);
+// Apply the received join state, once the map is built
+void NetClientApplyJoinState(NetClient *n);
 // Send a command to the server
 void NetClientSendMsg(NetClient *n, const GameEventType e, const void *data);
 
 bool NetClientIsConnected(const NetClient *n);
+// How far in the past, in ticks, to show remote actors so that there are
+// updates to interpolate between
+int NetClientGetInterpDelay(const NetClient *n);
@@ -0,0 +1,96 @@
+/*
+ C-Dogs SDL
+ A port of the legendary (and fun) action/arcade cdogs.
+
+ Copyright (c) 2020 Cong Xu
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "net_interp.h"
+
+#include <string.h>
+
+#include "utils.h"
+
+void NetInterpReset(NetInterp *ni) {
+	memset(ni, 0, sizeof *ni);
+}
+
+static const NetInterpSample* GetSample(const NetInterp *ni, const int i);
+void NetInterpAdd(NetInterp *ni, const int ticks, const struct vec2 pos,
+		const struct vec2 vel) {
+	// If time has gone backwards, e.g. a new mission, start again
+	if (ni->Count > 0 && ticks < GetSample(ni, ni->Count - 1)->Ticks) {
+		NetInterpReset(ni);
+	}
+	NetInterpSample *s;
+	if (ni->Count > 0 && ticks == GetSample(ni, ni->Count - 1)->Ticks) {
+		// Several updates in the same tick; keep the latest
+		s = &ni->Samples[(ni->Head + ni->Count - 1) % NET_INTERP_SAMPLES];
+	} else if (ni->Count < NET_INTERP_SAMPLES) {
+		s = &ni->Samples[(ni->Head + ni->Count) % NET_INTERP_SAMPLES];
+		ni->Count++;
+	} else {
+		// Overwrite the oldest
+		s = &ni->Samples[ni->Head];
+		ni->Head = (ni->Head + 1) % NET_INTERP_SAMPLES;
+	}
+	s->Ticks = ticks;
+	s->Pos = pos;
+	s->Vel = vel;
+}
+static const NetInterpSample* GetSample(const NetInterp *ni, const int i) {
+	return &ni->Samples[(ni->Head + i) % NET_INTERP_SAMPLES];
+}
+
+bool NetInterpTryGet(const NetInterp *ni, const int ticks, struct vec2 *pos) {
+	if (ni->Count == 0) {
+		return false;
+	}
+	const NetInterpSample *first = GetSample(ni, 0);
+	if (ticks <= first->Ticks) {
+		*pos = first->Pos;
+		return true;
+	}
+	for (int i = 0; i + 1 < ni->Count; i++) {
+		const NetInterpSample *a = GetSample(ni, i);
+		const NetInterpSample *b = GetSample(ni, i + 1);
+		if (ticks >= b->Ticks) {
+			continue;
+		}
+		// Follow both samples' velocities and blend between them, so that
+		// we arrive at b when it was received without changing speed
+		const float dtA = (float) (ticks - a->Ticks);
+		const float dtB = (float) (b->Ticks - ticks);
+		const struct vec2 fromA = svec2_add(a->Pos, svec2_scale(a->Vel, dtA));
+		const struct vec2 fromB =
+				svec2_subtract(b->Pos, svec2_scale(b->Vel, dtB));
+		*pos = svec2_lerp(fromA, fromB, dtA / (dtA + dtB));
+		return true;
+	}
+	// Past the last sample; extrapolate, but not too far
+	const NetInterpSample *last = GetSample(ni, ni->Count - 1);
+	const int dt = MIN(ticks - last->Ticks, NET_INTERP_MAX_EXTRAPOLATE);
+	*pos = svec2_add(last->Pos, svec2_scale(last->Vel, (float) dt));
+	return true;
+}
@@ -0,0 +1,63 @@
+/*
+ C-Dogs SDL
+ A port of the legendary (and fun) action/arcade cdogs.
+
+ Copyright (c) 2020 Cong Xu
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <stdbool.h>
+
+#include "mathc/mathc.h"
+
+// Smoothing of remote actors on clients.
+// Positions received from the server are buffered with the tick they
+// arrived, and actors are drawn a short delay in the past, interpolating
+// between buffered positions. If updates stop arriving, the last known
+// velocity is extrapolated for a limited time.
+
+#define NET_INTERP_SAMPLES 8
+// Limit on how far past the last update to extrapolate, in ticks
+#define NET_INTERP_MAX_EXTRAPOLATE 15
+
+typedef struct {
+	int Ticks;
+	struct vec2 Pos;
+	struct vec2 Vel;
+} NetInterpSample;
+
+// Zero-initialised is empty
+typedef struct {
+	// Ring buffer, oldest first starting at Head
+	NetInterpSample Samples[NET_INTERP_SAMPLES];
+	int Head;
+	int Count;
+} NetInterp;
+
+void NetInterpReset(NetInterp *ni);
+void NetInterpAdd(NetInterp *ni, const int ticks, const struct vec2 pos,
+		const struct vec2 vel);
+// Get the position at a time; returns false if there are no samples
+bool NetInterpTryGet(const NetInterp *ni, const int ticks, struct vec2 *pos);
@@ -0,0 +1,317 @@
+/*
+ C-Dogs SDL
+ A port of the legendary (and fun) action/arcade cdogs.
+
+ Copyright (c) 2020 Cong Xu
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "net_join.h"
+
+#include "proto/nanopb/pb_decode.h"
+#include "proto/nanopb/pb_encode.h"
+#include "actors.h"
+#include "game_events.h"
+#include "log.h"
+#include "map.h"
+#include "net_util.h"
+#include "objs.h"
+#include "pickup.h"
+
+static bool WriteBuf(pb_ostream_t *stream, const uint8_t *buf, size_t count);
+static void WriteTiles(pb_ostream_t *s);
+static void WriteExplored(pb_ostream_t *s);
+static void WriteEntities(pb_ostream_t *s);
+void NetJoinWrite(CArray *buf) {
+	CArrayClear(buf);
+	pb_ostream_t s = { WriteBuf, buf, SIZE_MAX, 0 };
+	pb_encode_varint(&s, gMap.Size.x);
+	pb_encode_varint(&s, gMap.Size.y);
+	WriteTiles(&s);
+	WriteExplored(&s);
+	WriteEntities(&s);
+	LOG(LM_NET, LL_DEBUG, "join state size(%d) for map(%dx%d)",
+			(int )buf->size, gMap.Size.x, gMap.Size.y);
+}
+static bool WriteBuf(pb_ostream_t *stream, const uint8_t *buf, size_t count) {
+	if (count == 0) {
+		return true;
+	}
+	CArray *a = (CArray*) stream->state;
+	const size_t size = a->size;
+	CArrayResize(a, size + count, NULL);
+	memcpy(CArrayGet(a, size), buf, count);
+	return true;
+}
+static int GetTileClassIndex(CArray *classes, const TileClass *tc);
+static void WriteTiles(pb_ostream_t *s) {
+	// Tile classes are sent as a table of names, and tiles as runs of
+	// indices into it; index 0 is no class
+	CArray classes;
+	CArrayInit(&classes, sizeof(const TileClass*));
+	const TileClass *none = NULL;
+	CArrayPushBack(&classes, &none);
+	struct vec2i pos;
+	for (pos.y = 0; pos.y < gMap.Size.y; pos.y++) {
+		for (pos.x = 0; pos.x < gMap.Size.x; pos.x++) {
+			GetTileClassIndex(&classes, MapGetTile(&gMap, pos)->Class);
+		}
+	}
+	pb_encode_varint(s, classes.size);
+	CA_FOREACH(const TileClass*, tc, classes)
+		const char *name = *tc != NULL && (*tc)->Name ? (*tc)->Name : "";
+		pb_encode_string(s, (const uint8_t*) name, strlen(name));
+	CA_FOREACH_END()
+
+	// Runs of (class index, length)
+	int runClass = -1;
+	int runLength = 0;
+	for (pos.y = 0; pos.y < gMap.Size.y; pos.y++) {
+		for (pos.x = 0; pos.x < gMap.Size.x; pos.x++) {
+			const int idx = GetTileClassIndex(&classes,
+					MapGetTile(&gMap, pos)->Class);
+			if (idx == runClass) {
+				runLength++;
+				continue;
+			}
+			if (runLength > 0) {
+				pb_encode_varint(s, runClass);
+				pb_encode_varint(s, runLength);
+			}
+			runClass = idx;
+			runLength = 1;
+		}
+	}
+	if (runLength > 0) {
+		pb_encode_varint(s, runClass);
+		pb_encode_varint(s, runLength);
+	}
+	CArrayTerminate(&classes);
+}
+static int GetTileClassIndex(CArray *classes, const TileClass *tc) {
+	CA_FOREACH(const TileClass*, c, *classes)
+		if (*c == tc) {
+			return _ca_index;
+		}
+	CA_FOREACH_END()
+	CArrayPushBack(classes, &tc);
+	return (int) classes->size - 1;
+}
+static void WriteExplored(pb_ostream_t *s) {
+	// Lengths of alternating runs of unexplored and explored tiles
+	bool explored = false;
+	int runLength = 0;
+	struct vec2i pos;
+	for (pos.y = 0; pos.y < gMap.Size.y; pos.y++) {
+		for (pos.x = 0; pos.x < gMap.Size.x; pos.x++) {
+			if (MapGetTile(&gMap, pos)->isVisited != explored) {
+				pb_encode_varint(s, runLength);
+				explored = !explored;
+				runLength = 0;
+			}
+			runLength++;
+		}
+	}
+	pb_encode_varint(s, runLength);
+}
+static void WriteEntities(pb_ostream_t *s) {
+	// Each table is a count followed by length-delimited messages
+	int count = 0;
+	CA_FOREACH(const TActor, a, gActors)
+		count += a->isInUse ? 1 : 0;
+	CA_FOREACH_END()
+	pb_encode_varint(s, count);
+	CA_FOREACH(const TActor, a, gActors)
+		if (!a->isInUse) {
+			continue;
+		}
+		NActorAdd aa = NActorAdd_init_default;
+		aa.UID = a->uid;
+		aa.CharId = a->charId;
+		aa.Health = a->health;
+		aa.Direction = (int32_t) a->direction;
+		aa.PlayerUID = a->PlayerUID;
+		aa.ThingFlags = a->thing.flags;
+		aa.Pos = Vec2ToNet(a->Pos);
+		pb_encode_delimited(s, NActorAdd_fields, &aa);
+	CA_FOREACH_END()
+
+	count = 0;
+	CA_FOREACH(const Pickup, p, gPickups)
+		count += p->isInUse ? 1 : 0;
+	CA_FOREACH_END()
+	pb_encode_varint(s, count);
+	CA_FOREACH(const Pickup, p, gPickups)
+		if (!p->isInUse) {
+			continue;
+		}
+		NAddPickup api = NAddPickup_init_default;
+		api.UID = p->UID;
+		strcpy(api.PickupClass, p->pickupClass->Name);
+		api.IsRandomSpawned = p->IsRandomSpawned;
+		api.SpawnerUID = p->SpawnerUID;
+		api.ThingFlags = p->thing.flags;
+		api.Pos = Vec2ToNet(p->thing.Pos);
+		pb_encode_delimited(s, NAddPickup_fields, &api);
+	CA_FOREACH_END()
+
+	count = 0;
+	CA_FOREACH(const TObject, o, gObjs)
+		count += o->isInUse ? 1 : 0;
+	CA_FOREACH_END()
+	pb_encode_varint(s, count);
+	CA_FOREACH(const TObject, o, gObjs)
+		if (!o->isInUse) {
+			continue;
+		}
+		NMapObjectAdd amo = NMapObjectAdd_init_default;
+		amo.UID = o->uid;
+		strcpy(amo.MapObjectClass, o->Class->Name);
+		amo.Pos = Vec2ToNet(o->thing.Pos);
+		amo.ThingFlags = o->thing.flags;
+		amo.Health = o->Health;
+		pb_encode_delimited(s, NMapObjectAdd_fields, &amo);
+	CA_FOREACH_END()
+}
+
+static bool ReadInt(pb_istream_t *s, int *value, const int max);
+static bool ReadTiles(pb_istream_t *s);
+static bool ReadExplored(pb_istream_t *s);
+static bool ReadEntities(pb_istream_t *s, const GameEventType type,
+		const pb_field_t *fields);
+bool NetJoinApply(const CArray *buf) {
+	pb_istream_t s = pb_istream_from_buffer((uint8_t*) buf->data, buf->size);
+	struct vec2i size;
+	if (!ReadInt(&s, &size.x, gMap.Size.x) || !ReadInt(&s, &size.y, gMap.Size.y)
+			|| !svec2i_is_equal(size, gMap.Size)) {
+		LOG(LM_NET, LL_ERROR, "join state map size mismatch");
+		return false;
+	}
+	if (!ReadTiles(&s) || !ReadExplored(&s)
+			|| !ReadEntities(&s, GAME_EVENT_ACTOR_ADD, NActorAdd_fields)
+			|| !ReadEntities(&s, GAME_EVENT_ADD_PICKUP, NAddPickup_fields)
+			|| !ReadEntities(&s, GAME_EVENT_MAP_OBJECT_ADD,
+					NMapObjectAdd_fields)) {
+		LOG(LM_NET, LL_ERROR, "failed to read join state: %s",
+				PB_GET_ERROR(&s));
+		return false;
+	}
+	return true;
+}
+static bool ReadInt(pb_istream_t *s, int *value, const int max) {
+	uint64_t v;
+	if (!pb_decode_varint(s, &v)) {
+		return false;
+	}
+	if (v > (uint64_t) max) {
+		PB_RETURN_ERROR(s, "value out of range");
+	}
+	*value = (int) v;
+	return true;
+}
+static bool ReadTiles(pb_istream_t *s) {
+	int numClasses;
+	if (!ReadInt(s, &numClasses, INT16_MAX)) {
+		return false;
+	}
+	const int numTiles = gMap.Size.x * gMap.Size.y;
+	// Every tile is an index into the classes, so there must be some
+	if (numClasses == 0 && numTiles > 0) {
+		PB_RETURN_ERROR(s, "no tile classes");
+	}
+	CArray classes;
+	CArrayInit(&classes, sizeof(const TileClass*));
+	bool ok = true;
+	for (int i = 0; i < numClasses && ok; i++) {
+		char name[128];
+		pb_istream_t sub;
+		ok = pb_make_string_substream(s, &sub)
+				&& sub.bytes_left < sizeof name;
+		if (ok) {
+			const size_t len = sub.bytes_left;
+			ok = pb_read(&sub, (uint8_t*) name, len);
+			name[len] = '\0';
+			pb_close_string_substream(s, &sub);
+		}
+		if (ok) {
+			const TileClass *tc = StrTileClass(name);
+			CArrayPushBack(&classes, &tc);
+		}
+	}
+
+	const TileClass *tileClassAlt = StrTileClass("");
+	int i = 0;
+	while (ok && i < numTiles) {
+		int idx, runLength;
+		ok = ReadInt(s, &idx, numClasses - 1)
+				&& ReadInt(s, &runLength, numTiles - i);
+		if (!ok) {
+			break;
+		}
+		const TileClass *tc = *(const TileClass**) CArrayGet(&classes, idx);
+		for (const int end = i + runLength; i < end; i++) {
+			Tile *t = MapGetTile(&gMap, svec2i(i % gMap.Size.x,
+					i / gMap.Size.x));
+			t->Class = tc;
+			t->ClassAlt = tileClassAlt;
+		}
+	}
+	CArrayTerminate(&classes);
+	return ok;
+}
+static bool ReadExplored(pb_istream_t *s) {
+	const int numTiles = gMap.Size.x * gMap.Size.y;
+	bool explored = false;
+	int i = 0;
+	while (i < numTiles) {
+		int runLength;
+		if (!ReadInt(s, &runLength, numTiles - i)) {
+			return false;
+		}
+		if (explored) {
+			for (const int end = i + runLength; i < end; i++) {
+				MapMarkAsVisited(&gMap, svec2i(i % gMap.Size.x,
+						i / gMap.Size.x));
+			}
+		} else {
+			i += runLength;
+		}
+		explored = !explored;
+	}
+	return true;
+}
+static bool ReadEntities(pb_istream_t *s, const GameEventType type,
+		const pb_field_t *fields) {
+	int count;
+	if (!ReadInt(s, &count, INT16_MAX)) {
+		return false;
+	}
+	for (int i = 0; i < count; i++) {
+		GameEvent e = GameEventNew(type);
+		if (!pb_decode_delimited(s, fields, &e.u)) {
+			return false;
+		}
+		GameEventsEnqueue(&gGameEvents, e);
+	}
+	return true;
+}
@@ -0,0 +1,66 @@
+/*
+ C-Dogs SDL
+ A port of the legendary (and fun) action/arcade cdogs.
+
+ Copyright (c) 2020 Cong Xu
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mathc/mathc.h"
+
+// Prediction of local players' movement on clients.
+// Each movement update is recorded with a sequence number, which is sent to
+// the server with the player's moves. The server reports the last input it
+// applied along with the resulting position; if that disagrees with what
+// we predicted, the player is moved to the server's position and the inputs
+// since then are replayed.
+
+// Inputs kept for replaying, about 1s worth
+#define NET_PREDICT_INPUTS 64
+// Prediction errors smaller than this are ignored
+#define NET_PREDICT_TOLERANCE 4.0f
+
+typedef struct {
+	uint32_t Seq;
+	struct vec2 MoveVel;
+	// Position after applying this input
+	struct vec2 Pos;
+} NetPredictInput;
+
+// Zero-initialised is empty
+typedef struct {
+	NetPredictInput Inputs[NET_PREDICT_INPUTS];
+	// Sequence number of the last input; on the server, the last input
+	// applied for the owning client
+	uint32_t Seq;
+} NetPredict;
+
+void NetPredictAdd(
+		NetPredict *np, const struct vec2 moveVel, const struct vec2 pos);
+// Returns NULL if the input is no longer kept
+NetPredictInput* NetPredictGet(NetPredict *np, const uint32_t seq);
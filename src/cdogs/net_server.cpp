@@ -40,7 +40,7 @@
 #include "gamedata.h"
 #include "handle_game_events.h"
 #include "log.h"
-#include "los.h"
+#include "net_join.h"
 #include "pickup.h"
 #include "player.h"
 #include "sys_config.h"
@@ -48,11 +48,18 @@
 
 NetServer gNetServer;
 
+// Size of the interest grid cells, in tiles
+#define INTEREST_CELL_TILES 4
+
 void NetServerInit(NetServer *n) {
 	memset(n, 0, sizeof *n);
+	NetSnapshotsInit(&n->Snapshots);
+	CArrayInit(&n->msgBuf, sizeof(uint8_t));
 }
 void NetServerTerminate(NetServer *n) {
 	NetServerClose(n);
+	NetSnapshotsTerminate(&n->Snapshots);
+	CArrayTerminate(&n->msgBuf);
 }
 void NetServerReset(NetServer *n) {
 	n->PrevCmd = n->Cmd = 0;
@@ -87,8 +94,8 @@ static ENetHost* HostOpen(void) {
 	ENetAddress address;
 	address.host = ENET_HOST_ANY;
 	address.port = ENET_PORT_ANY;
-	ENetHost *host = enet_host_create(&address, NET_SERVER_MAX_CLIENTS, 2, 0,
-			0);
+	ENetHost *host = enet_host_create(&address, NET_SERVER_MAX_CLIENTS,
+			DELIVERY_COUNT, 0, 0);
 	if (host == NULL) {
 		LOG(LM_NET, LL_ERROR, "cannot create server host");
 		return NULL;
@@ -125,11 +132,22 @@ static bool ListenSocketTryOpen(ENetSocket *listen) {
 	return true;
 }
 
+static void PeerDataTerminate(NetPeerData *data) {
+	for (int i = 0; i < DELIVERY_COUNT; i++) {
+		NetBatchTerminate(&data->Batches[i]);
+	}
+	CArrayTerminate(&data->Interest);
+}
 void NetServerClose(NetServer *n) {
 	if (n->server) {
 		for (int i = 0; i < (int) n->server->peerCount; i++) {
 			ENetPeer *peer = n->server->peers + i;
 			enet_peer_disconnect_now(peer, 0);
+			if (peer->data != NULL) {
+				PeerDataTerminate((NetPeerData*) peer->data);
+				CFREE(peer->data);
+				peer->data = NULL;
+			}
 		}
 		enet_host_destroy(n->server);
 	}
@@ -139,6 +157,7 @@ void NetServerClose(NetServer *n) {
 static void PollListener(NetServer *n);
 static void OnReceive(NetServer *n, ENetEvent event);
 static void OnDisconnect(const ENetEvent event);
+static void UpdateInterest(NetServer *n);
 void NetServerPoll(NetServer *n) {
 	if (!n->server) {
 		return;
@@ -181,8 +200,92 @@ void NetServerPoll(NetServer *n) {
 		}
 	} while (check > 0);
 
+	UpdateInterest(n);
+
 	NetServerFlush(n);
 }
+static int MaxViewRange(void);
+static void UpdatePeerInterest(NetPeerData *data, const int range);
+static void UpdateInterest(NetServer *n) {
+	if (n->server == NULL) {
+		return;
+	}
+	int range = ConfigGetInt(&gConfig, "NetRelevanceRange");
+	// Never cull what players could otherwise see
+	if (range > 0) {
+		range = MAX(range, ConfigGetInt(&gConfig, "Game.SightRange"));
+		range = MAX(range, MaxViewRange());
+	}
+	for (int i = 0; i < (int) n->server->peerCount; i++) {
+		const ENetPeer *peer = n->server->peers + i;
+		if (peer->data != NULL) {
+			UpdatePeerInterest((NetPeerData*) peer->data, range);
+		}
+	}
+}
+// Tiles from a player to the edge of the biggest view a client can have,
+// which is the largest window at the smallest scale
+static int MaxViewRange(void) {
+	const Config *w = ConfigGet(&gConfig, "Graphics.WindowWidth");
+	const Config *h = ConfigGet(&gConfig, "Graphics.WindowHeight");
+	const int scale = ConfigGet(&gConfig, "Graphics.ScaleFactor")->u.Int.Min;
+	const int halfW = w->u.Int.Max / scale / 2;
+	const int halfH = h->u.Int.Max / scale / 2;
+	return MAX((halfW + TILE_WIDTH - 1) / TILE_WIDTH,
+			(halfH + TILE_HEIGHT - 1) / TILE_HEIGHT);
+}
+static void MarkInterest(NetPeerData *data, const struct vec2i tile,
+		const int range);
+static void UpdatePeerInterest(NetPeerData *data, const int range) {
+	data->HasInterest = false;
+	if (range <= 0 || !gMission.HasStarted || svec2i_is_zero(gMap.Size)) {
+		return;
+	}
+	data->InterestSize = svec2i(
+			(gMap.Size.x + INTEREST_CELL_TILES - 1) / INTEREST_CELL_TILES,
+			(gMap.Size.y + INTEREST_CELL_TILES - 1) / INTEREST_CELL_TILES);
+	CArrayResize(&data->Interest,
+			data->InterestSize.x * data->InterestSize.y, NULL);
+	CArrayFillZero(&data->Interest);
+	for (int i = 0; i < MAX_LOCAL_PLAYERS; i++) {
+		const int uid = (data->Id + 1) * MAX_LOCAL_PLAYERS + i;
+		const PlayerData *p = PlayerDataGetByUID(uid);
+		if (p == NULL || !IsPlayerAlive(p)) {
+			continue;
+		}
+		const TActor *a = ActorGetByUID(p->ActorUID);
+		if (a == NULL || !a->isInUse) {
+			continue;
+		}
+		MarkInterest(data, Vec2ToTile(a->Pos), range);
+		data->HasInterest = true;
+	}
+}
+static void MarkInterest(NetPeerData *data, const struct vec2i tile,
+		const int range) {
+	const struct vec2i cellMin = svec2i_max(svec2i_zero(), svec2i_scale_divide(
+			svec2i_subtract(tile, svec2i(range, range)), INTEREST_CELL_TILES));
+	const struct vec2i cellMax = svec2i_min(
+			svec2i_subtract(data->InterestSize, svec2i_one()),
+			svec2i_scale_divide(svec2i_add(tile, svec2i(range, range)),
+					INTEREST_CELL_TILES));
+	struct vec2i cell;
+	for (cell.y = cellMin.y; cell.y <= cellMax.y; cell.y++) {
+		for (cell.x = cellMin.x; cell.x <= cellMax.x; cell.x++) {
+			// Use the tile in the cell closest to the player
+			const struct vec2i start = svec2i_scale(cell, INTEREST_CELL_TILES);
+			const struct vec2i closest = svec2i_clamp(tile, start,
+					svec2i_add(start, svec2i(
+							INTEREST_CELL_TILES - 1, INTEREST_CELL_TILES - 1)));
+			if (svec2i_distance_squared(tile, closest) <= range * range) {
+				const bool relevant = true;
+				CArraySet(&data->Interest,
+						cell.y * data->InterestSize.x + cell.x, &relevant);
+			}
+		}
+	}
+}
+
 static void PollListener(NetServer *n) {
 	// Check for data to recv
 	ENetSocketSet set;
@@ -230,27 +333,35 @@ static void PollListener(NetServer *n) {
 		LOG(LM_NET, LL_ERROR, "Failed to reply to scanner");
 	}
 }
-static void OnConnect(NetServer *n, ENetEvent event);
+static void OnReceiveMsg(NetServer *n, ENetPeer *peer, const NetMsg *msg);
 static void OnReceive(NetServer *n, ENetEvent event) {
-	const GameEventType msg = (GameEventType) *(uint32_t*) event.packet->data;
+	size_t offset = 0;
+	NetMsg msg;
+	while (NetBatchNext(event.packet, &offset, &msg)) {
+		OnReceiveMsg(n, event.peer, &msg);
+	}
+	enet_packet_destroy(event.packet);
+}
+static void OnConnect(NetServer *n, ENetPeer *peer);
+static void OnReceiveMsg(NetServer *n, ENetPeer *peer, const NetMsg *msg) {
 	int peerId = -1;
-	if (event.peer->data != NULL) {
+	if (peer->data != NULL) {
 		// We may not have assigned peer ID
-		peerId = ((NetPeerData*) event.peer->data)->Id;
+		peerId = ((NetPeerData*) peer->data)->Id;
 		LOG(LM_NET, LL_TRACE, "recv message from peerId(%d) msg(%d)", peerId,
-				(int )msg);
+				(int )msg->Type);
 	}
-	const GameEventEntry gee = GameEventGetEntry(msg);
+	const GameEventEntry gee = GameEventGetEntry(msg->Type);
 	if (gee.Enqueue) {
 		// Game event message; decode and add to event queue
 		LOG(LM_NET, LL_TRACE, "recv gameEvent(%d)", (int )gee.Type);
 		GameEvent e = GameEventNew(gee.Type);
-		NetDecode(event.packet, &e.u, gee.Fields);
+		NetDecode(msg, &e.u, gee.Fields);
 		GameEventsEnqueue(&gGameEvents, e);
 	} else {
 		switch (gee.Type) {
 		case GAME_EVENT_CLIENT_CONNECT:
-			OnConnect(n, event);
+			OnConnect(n, peer);
 			break;
 		case GAME_EVENT_CLIENT_READY:
 			CASSERT(peerId >= 0, "peer id unset")
@@ -299,23 +410,40 @@ static void OnReceive(NetServer *n, ENetEvent event) {
 
 			NetServerFlush(n);
 			break;
+		case GAME_EVENT_SNAPSHOT_ACK:
+			if (peer->data != NULL) {
+				NSnapshotAck ack;
+				NetDecode(msg, &ack, NSnapshotAck_fields);
+				NetPeerData *data = (NetPeerData*) peer->data;
+				if (ack.Seq > data->SnapshotAck) {
+					data->SnapshotAck = ack.Seq;
+				}
+			}
+			break;
 		default:
 			CASSERT(false, "unexpected message type")
 			;
 			break;
 		}
 	}
-	enet_packet_destroy(event.packet);
 }
-static void OnConnect(NetServer *n, ENetEvent event) {
+static void OnConnect(NetServer *n, ENetPeer *peer) {
 	char buf[256];
-	enet_address_get_host_ip(&event.peer->address, buf, sizeof buf);
+	enet_address_get_host_ip(&peer->address, buf, sizeof buf);
 	LOG(LM_NET, LL_INFO, "new client connected from %s:%u", buf,
-			event.peer->address.port);
+			peer->address.port);
 	/* Store any relevant client information here. */
-	CMALLOC(event.peer->data, sizeof(NetPeerData));
+	NetPeerData *data;
+	CMALLOC(data, sizeof *data);
 	const int peerId = n->peerId;
-	((NetPeerData*) event.peer->data)->Id = peerId;
+	data->Id = peerId;
+	for (int i = 0; i < DELIVERY_COUNT; i++) {
+		NetBatchInit(&data->Batches[i], (GameEventDelivery) i);
+	}
+	data->SnapshotAck = 0;
+	data->HasInterest = false;
+	CArrayInit(&data->Interest, sizeof(bool));
+	peer->data = data;
 	n->peerId++;
 
 	// Send the client ID
@@ -339,6 +467,7 @@ static void OnDisconnect(const ENetEvent event) {
 	int peerId = -1;
 	if (event.peer->data != NULL) {
 		peerId = ((NetPeerData*) event.peer->data)->Id;
+		PeerDataTerminate((NetPeerData*) event.peer->data);
 		CFREE(event.peer->data);
 		event.peer->data = NULL;
 	}
@@ -358,12 +487,32 @@ static void OnDisconnect(const ENetEvent event) {
 void NetServerFlush(NetServer *n) {
 	if (n->server == NULL)
 		return;
+	for (int i = 0; i < (int) n->server->peerCount; i++) {
+		ENetPeer *peer = n->server->peers + i;
+		if (peer->data == NULL) {
+			continue;
+		}
+		NetPeerData *data = (NetPeerData*) peer->data;
+		for (int j = 0; j < DELIVERY_COUNT; j++) {
+			if (!NetBatchIsEmpty(&data->Batches[j])) {
+				NetBatchFlush(&data->Batches[j], peer);
+			}
+		}
+	}
 	enet_host_flush(n->server);
 }
 
 static void SendConfig(Config *config, const char *name, NetServer *n,
 		const int peerId);
+static void SendJoinState(NetServer *n, const int peerId);
+static void ResetSnapshotAcks(NetServer *n, const int peerId);
 void NetServerSendGameStartMessages(NetServer *n, const int peerId) {
+	// Snapshots from before the game started are no use as delta bases
+	if (peerId == NET_SERVER_BCAST) {
+		NetSnapshotsReset(&n->Snapshots);
+	}
+	ResetSnapshotAcks(n, peerId);
+
 	// Send details of all current players
 	CA_FOREACH(const PlayerData, pOther, gPlayerDatas)
 		NPlayerData pd = NMakePlayerData(pOther);
@@ -381,23 +530,8 @@ void NetServerSendGameStartMessages(NetServer *n, const int peerId) {
 
 	NetServerSendMsg(n, peerId, GAME_EVENT_NET_GAME_START, NULL);
 
-	// Send all actors
-	CA_FOREACH(const TActor, a, gActors)
-		if (!a->isInUse) {
-			continue;
-		}
-		NActorAdd aa = NActorAdd_init_default;
-		aa.UID = a->uid;
-		aa.CharId = a->charId;
-		aa.Health = a->health;
-		aa.Direction = (int32_t) a->direction;
-		aa.PlayerUID = a->PlayerUID;
-		aa.ThingFlags = a->thing.flags;
-		aa.Pos = Vec2ToNet(a->Pos);
-		LOG(LM_NET, LL_DEBUG, "send add actor UID(%d) playerUID(%d)",
-				(int )aa.UID, (int )aa.PlayerUID);
-		NetServerSendMsg(n, peerId, GAME_EVENT_ACTOR_ADD, &aa);
-	CA_FOREACH_END()
+	// Send the map and world state in bulk
+	SendJoinState(n, peerId);
 
 	// Send key state
 	NAddKeys ak = NAddKeys_init_default;
@@ -412,91 +546,39 @@ void NetServerSendGameStartMessages(NetServer *n, const int peerId) {
 		NetServerSendMsg(n, peerId, GAME_EVENT_OBJECTIVE_UPDATE, &ou);
 	CA_FOREACH_END()
 
-	// Send all tiles, RLE
-	const Tile *tLast = NULL;
-	NTileSet ts = NTileSet_init_default;
-	struct vec2i pos;
-	for (pos.y = 0; pos.y < gMap.Size.y; pos.y++) {
-		for (pos.x = 0; pos.x < gMap.Size.x; pos.x++) {
-			const Tile *t = MapGetTile(&gMap, pos);
-			// Use RLE, so check if the current tile is the same as the last
-			if (tLast != NULL && t->Class == tLast->Class) {
-				ts.RunLength++;
-			} else {
-				// Send the last run
-				if (tLast != NULL) {
-					NetServerSendMsg(n, peerId, GAME_EVENT_TILE_SET, &ts);
-				}
-				// Begin the next run
-				memset(&ts, 0, sizeof ts);
-				ts.Pos = Vec2i2Net(pos);
-				if (t->Class != NULL && t->Class->Name) {
-					strcpy(ts.ClassName, t->Class->Name);
-				}
-				ts.RunLength = 0;
-			}
-			tLast = t;
-		}
-	}
-	NetServerSendMsg(n, peerId, GAME_EVENT_TILE_SET, &ts);
-
-	// Send all the tiles visited so far
-	NExploreTiles et = NExploreTiles_init_default;
-	et.Runs_count = 0;
-	et.Runs[0].Run = 0;
-	bool run = false;
-	for (pos.y = 0; pos.y < gMap.Size.y; pos.y++) {
-		for (pos.x = 0; pos.x < gMap.Size.x; pos.x++) {
-			const Tile *t = MapGetTile(&gMap, pos);
-			if (LOSAddRun(&et, &run, pos, t->isVisited)) {
-				NetServerSendMsg(n, peerId, GAME_EVENT_EXPLORE_TILES, &et);
-				et.Runs_count = 0;
-				et.Runs[0].Run = 0;
-				run = false;
-			}
-		}
-	}
-	if (et.Runs_count > 0) {
-		NetServerSendMsg(n, peerId, GAME_EVENT_EXPLORE_TILES, &et);
-	}
-
-	// Send all pickups
-	CA_FOREACH(const Pickup, p, gPickups)
-		if (!p->isInUse)
-			continue;
-		NAddPickup api = NAddPickup_init_default;
-		api.UID = p->UID;
-		strcpy(api.PickupClass, p->pickupClass->Name);
-		api.IsRandomSpawned = p->IsRandomSpawned;
-		api.SpawnerUID = p->SpawnerUID;
-		api.ThingFlags = p->thing.flags;
-		api.Pos = Vec2ToNet(p->thing.Pos);
-		NetServerSendMsg(n, peerId, GAME_EVENT_ADD_PICKUP, &api);
-	CA_FOREACH_END()
-
-	// Send all map objects
-	CA_FOREACH(const TObject, o, gObjs)
-		if (!o->isInUse)
-			continue;
-		NMapObjectAdd amo = NMapObjectAdd_init_default;
-		amo.UID = o->uid;
-		strcpy(amo.MapObjectClass, o->Class->Name);
-		amo.Pos = Vec2ToNet(o->thing.Pos);
-		amo.ThingFlags = o->thing.flags;
-		amo.Health = o->Health;
-		LOG(LM_NET, LL_DEBUG,
-				"send add map object UID(%d) pos(%d, %d) flags(%x) health(%d)",
-				(int )amo.UID, amo.Pos.x, amo.Pos.y, amo.ThingFlags,
-				amo.Health);
-		NetServerSendMsg(n, peerId, GAME_EVENT_MAP_OBJECT_ADD, &amo);
-	CA_FOREACH_END()
-
 	// If mission complete already, send message
 	if (CanCompleteMission(&gMission)) {
 		NMissionComplete mc = NMakeMissionComplete(&gMission, &gMap);
 		NetServerSendMsg(n, peerId, GAME_EVENT_MISSION_COMPLETE, &mc);
 	}
 }
+static void SendJoinState(NetServer *n, const int peerId) {
+	CArray buf;
+	CArrayInit(&buf, sizeof(uint8_t));
+	NetJoinWrite(&buf);
+	NJoinChunk jc = NJoinChunk_init_default;
+	jc.Total = (uint32_t) buf.size;
+	for (size_t i = 0; i < buf.size; i += NET_JOIN_CHUNK_SIZE) {
+		jc.Offset = (uint32_t) i;
+		jc.Data.size = (pb_size_t) MIN(buf.size - i, NET_JOIN_CHUNK_SIZE);
+		memcpy(jc.Data.bytes, CArrayGet(&buf, i), jc.Data.size);
+		NetServerSendMsg(n, peerId, GAME_EVENT_JOIN_CHUNK, &jc);
+	}
+	CArrayTerminate(&buf);
+}
+static void ResetSnapshotAcks(NetServer *n, const int peerId) {
+	if (n->server == NULL) {
+		return;
+	}
+	for (int i = 0; i < (int) n->server->peerCount; i++) {
+		const ENetPeer *peer = n->server->peers + i;
+		NetPeerData *data = (NetPeerData*) peer->data;
+		if (data != NULL && (peerId == NET_SERVER_BCAST || data->Id == peerId)) {
+			// Send full snapshots until one from this game is acked
+			data->SnapshotAck = 0;
+		}
+	}
+}
 static void SendConfig(Config *config, const char *name, NetServer *n,
 		const int peerId) {
 	NConfig msg = NConfig_init_default;
@@ -531,20 +613,135 @@ static void SendConfig(Config *config, const char *name, NetServer *n,
 	NetServerSendMsg(n, peerId, GAME_EVENT_CONFIG, &msg);
 }
 
+static void SendSnapshot(NetServer *n, const int peerId,
+		const NetSnapshot *s, const NetSnapshot *base);
+void NetServerSendSnapshot(NetServer *n) {
+	if (n->server == NULL || n->server->connectedPeers == 0) {
+		return;
+	}
+	n->snapshotCounter++;
+	if (n->snapshotCounter < NET_SNAPSHOT_INTERVAL) {
+		return;
+	}
+	n->snapshotCounter = 0;
+
+	n->SnapshotSeq++;
+	NetSnapshot *s = NetSnapshotsNew(&n->Snapshots, n->SnapshotSeq);
+	NetSnapshotCapture(s);
+	for (int i = 0; i < (int) n->server->peerCount; i++) {
+		const ENetPeer *peer = n->server->peers + i;
+		if (peer->data == NULL) {
+			continue;
+		}
+		const NetPeerData *data = (const NetPeerData*) peer->data;
+		// Send a full snapshot if the peer's last ack is too old
+		const NetSnapshot *base = NetSnapshotsGet(
+				&n->Snapshots, data->SnapshotAck);
+		SendSnapshot(n, data->Id, s, base);
+	}
+}
+static void SendSnapshot(NetServer *n, const int peerId,
+		const NetSnapshot *s, const NetSnapshot *base) {
+	// Always send at least one part, so that empty snapshots are acked too
+	const int perPart = (int) pb_arraysize(NSnapshot, Actors);
+	const int parts = MAX(1, ((int) s->Actors.size + perPart - 1) / perPart);
+	NSnapshot ns = NSnapshot_init_default;
+	ns.Seq = s->Seq;
+	ns.BaseSeq = base != NULL ? base->Seq : 0;
+	ns.Parts = parts;
+	for (int part = 0; part < parts; part++) {
+		ns.Part = part;
+		ns.Actors_count = 0;
+		for (int i = part * perPart;
+				i < (int) s->Actors.size && i < (part + 1) * perPart; i++) {
+			const NetSnapshotActor *sa = static_cast<const NetSnapshotActor*>(
+					CArrayGet(&s->Actors, i));
+			const NetSnapshotActor *sb = base != NULL ?
+					NetSnapshotFindActor(base, sa->UID, i) : NULL;
+			ns.Actors[ns.Actors_count] = NetSnapshotActorDelta(sa, sb);
+			ns.Actors_count++;
+		}
+		NetServerSendMsg(n, peerId, GAME_EVENT_SNAPSHOT, &ns);
+	}
+}
+
+static bool TryGetCosmeticEventPos(
+		const GameEventType e, const void *data, struct vec2 *pos);
+static bool IsRelevant(const NetPeerData *pData, const GameEventType e,
+		const void *data) {
+	struct vec2 pos;
+	if (!pData->HasInterest || !TryGetCosmeticEventPos(e, data, &pos)) {
+		return true;
+	}
+	const struct vec2i cell = svec2i_scale_divide(
+			Vec2ToTile(pos), INTEREST_CELL_TILES);
+	if (cell.x < 0 || cell.y < 0 || cell.x >= pData->InterestSize.x
+			|| cell.y >= pData->InterestSize.y) {
+		return true;
+	}
+	return *(const bool*) CArrayGet(&pData->Interest,
+			cell.y * pData->InterestSize.x + cell.x);
+}
+// Events that only affect what a client sees or hears near a position, and
+// can be culled if far from its players. Actor moves and directions are
+// included as they are corrected by snapshots when the actor comes back into
+// range; animation and gun state are not in snapshots, so they are never
+// culled. Nor are shots from guns that shake every client's screen.
+static bool TryGetActorPos(const int uid, struct vec2 *pos);
+static bool TryGetCosmeticEventPos(
+		const GameEventType e, const void *data, struct vec2 *pos) {
+	switch (e) {
+	case GAME_EVENT_SOUND_AT:
+		*pos = NetToVec2(((const NSound*) data)->Pos);
+		return true;
+	case GAME_EVENT_GUN_FIRE: {
+		const NGunFire *gf = (const NGunFire*) data;
+		const WeaponClass *wc = StrWeaponClass(gf->Gun);
+		if (wc == NULL
+				|| (wc->Shake.Amount > 0 && !wc->Shake.CameraSubjectOnly)) {
+			return false;
+		}
+		*pos = NetToVec2(gf->MuzzlePos);
+		return true;
+	}
+	case GAME_EVENT_GUN_RELOAD:
+		*pos = NetToVec2(((const NGunReload*) data)->Pos);
+		return true;
+	case GAME_EVENT_ACTOR_MOVE:
+		*pos = NetToVec2(((const NActorMove*) data)->Pos);
+		return true;
+	case GAME_EVENT_ACTOR_DIR:
+		return TryGetActorPos(((const NActorDir*) data)->UID, pos);
+	default:
+		return false;
+	}
+}
+static bool TryGetActorPos(const int uid, struct vec2 *pos) {
+	const TActor *a = ActorGetByUID(uid);
+	if (a == NULL || !a->isInUse) {
+		return false;
+	}
+	*pos = a->Pos;
+	return true;
+}
+
 void NetServerSendMsg(NetServer *n, const int peerId, const GameEventType e,
 		const void *data) {
 	if (!n->server)
 		return;
 
+	const GameEventDelivery delivery = GameEventGetEntry(e).Delivery;
 	if (peerId >= 0) {
 		LOG(LM_NET, LL_TRACE, "send msg(%d) to peers(%d)", (int )e,
 				(int )n->server->connectedPeers);
-		// Find the peer and send
+		// Find the peer and batch
 		for (int i = 0; i < (int) n->server->peerCount; i++) {
 			ENetPeer *peer = n->server->peers + i;
 			if (peer->data != NULL
 					&& ((NetPeerData*) peer->data)->Id == peerId) {
-				enet_peer_send(peer, 0, NetEncode(e, data));
+				NetBatchEncode(
+						&((NetPeerData*) peer->data)->Batches[delivery], e,
+						data);
 				return;
 			}
 		}
@@ -552,6 +749,22 @@ void NetServerSendMsg(NetServer *n, const int peerId, const GameEventType e,
 	} else {
 		LOG(LM_NET, LL_TRACE, "bcast msg(%d) to peers(%d)", (int )e,
 				(int )n->server->connectedPeers);
-		enet_host_broadcast(n->server, 0, NetEncode(e, data));
+		// Encode once, and only if any peer will get it
+		size_t len = 0;
+		// Batch for every peer that has completed connecting, and that
+		// the event is relevant to
+		for (int i = 0; i < (int) n->server->peerCount; i++) {
+			ENetPeer *peer = n->server->peers + i;
+			if (peer->data != NULL
+					&& IsRelevant((const NetPeerData*) peer->data, e, data)) {
+				if (len == 0) {
+					len = NetEncodeSize(e, data);
+					CArrayResize(&n->msgBuf, len, NULL);
+					NetEncode((uint8_t*) n->msgBuf.data, len, e, data);
+				}
+				NetBatchAdd(&((NetPeerData*) peer->data)->Batches[delivery],
+						(const uint8_t*) n->msgBuf.data, len);
+			}
+		}
 	}
 }
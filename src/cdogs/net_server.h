@@ -31,6 +31,7 @@
 #include <stdbool.h>
 
 #include "c_array.h"
+#include "net_snapshot.h"
 #include "net_util.h"
 
 #define NET_SERVER_MAX_CLIENTS 32
@@ -45,12 +46,25 @@ typedef struct {
 	int PrevCmd;
 	int Cmd;
 	int peerId;	// auto-incrementing id for the next connected peer
+	NetSnapshots Snapshots;
+	uint32_t SnapshotSeq;
+	int snapshotCounter;
+	// of uint8_t, broadcasts are encoded here once and copied to each peer
+	CArray msgBuf;
 } NetServer;
 
 extern NetServer gNetServer;
 
 typedef struct {
 	int Id;
+	// Messages to send on the next flush, by GameEventDelivery
+	NetBatch Batches[DELIVERY_COUNT];
+	uint32_t SnapshotAck;	// last snapshot the peer received, 0 if none
+	// Coarse grid over the map of cells near the peer's players;
+	// if the peer has no players alive, everything is relevant
+	bool HasInterest;
+	struct vec2i InterestSize;
+	CArray Interest;	// of bool
 } NetPeerData;
 
 void NetServerInit(NetServer *n);
@@ -69,3 +83,5 @@ void NetServerSendMsg(NetServer *n, const int peerId, const GameEventType e,
 		const void *data);
 
 void NetServerSendGameStartMessages(NetServer *n, const int peerId);
+// Send world state snapshots to peers, every NET_SNAPSHOT_INTERVAL ticks
+void NetServerSendSnapshot(NetServer *n);
@@ -0,0 +1,143 @@
+/*
+ C-Dogs SDL
+ A port of the legendary (and fun) action/arcade cdogs.
+
+ Copyright (c) 2020 Cong Xu
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "net_snapshot.h"
+
+#include "actors.h"
+#include "net_util.h"
+
+void NetSnapshotsInit(NetSnapshots *s) {
+	for (int i = 0; i < NET_SNAPSHOT_HISTORY; i++) {
+		s->Snapshots[i].Seq = 0;
+		CArrayInit(&s->Snapshots[i].Actors, sizeof(NetSnapshotActor));
+	}
+}
+void NetSnapshotsTerminate(NetSnapshots *s) {
+	for (int i = 0; i < NET_SNAPSHOT_HISTORY; i++) {
+		CArrayTerminate(&s->Snapshots[i].Actors);
+	}
+}
+void NetSnapshotsReset(NetSnapshots *s) {
+	for (int i = 0; i < NET_SNAPSHOT_HISTORY; i++) {
+		s->Snapshots[i].Seq = 0;
+		CArrayClear(&s->Snapshots[i].Actors);
+	}
+}
+
+const NetSnapshot* NetSnapshotsGet(const NetSnapshots *s, const uint32_t seq) {
+	if (seq == 0) {
+		return NULL;
+	}
+	const NetSnapshot *snap = &s->Snapshots[seq % NET_SNAPSHOT_HISTORY];
+	return snap->Seq == seq ? snap : NULL;
+}
+NetSnapshot* NetSnapshotsNew(NetSnapshots *s, const uint32_t seq) {
+	NetSnapshot *snap = &s->Snapshots[seq % NET_SNAPSHOT_HISTORY];
+	snap->Seq = seq;
+	CArrayClear(&snap->Actors);
+	return snap;
+}
+
+void NetSnapshotCapture(NetSnapshot *s) {
+	CArrayClear(&s->Actors);
+	CA_FOREACH(const TActor, a, gActors)
+		if (!a->isInUse) {
+			continue;
+		}
+		NetSnapshotActor sa;
+		sa.UID = a->uid;
+		sa.Pos = a->Pos;
+		sa.MoveVel = a->MoveVel;
+		sa.Dir = (int) a->direction;
+		sa.InputSeq = a->predict.Seq;
+		CArrayPushBack(&s->Actors, &sa);
+	CA_FOREACH_END()
+}
+
+const NetSnapshotActor* NetSnapshotFindActor(const NetSnapshot *s,
+		const int uid, const int hint) {
+	if (hint >= 0 && hint < (int) s->Actors.size) {
+		const NetSnapshotActor *sa = static_cast<const NetSnapshotActor*>(
+				CArrayGet(&s->Actors, hint));
+		if (sa->UID == uid) {
+			return sa;
+		}
+	}
+	CA_FOREACH(const NetSnapshotActor, sa, s->Actors)
+		if (sa->UID == uid) {
+			return sa;
+		}
+	CA_FOREACH_END()
+	return NULL;
+}
+
+NActorSnapshot NetSnapshotActorDelta(const NetSnapshotActor *a,
+		const NetSnapshotActor *base) {
+	NActorSnapshot d = NActorSnapshot_init_default;
+	d.UID = a->UID;
+	if (base == NULL || !svec2_is_equal(a->Pos, base->Pos)) {
+		d.has_Pos = true;
+		d.Pos = Vec2ToNet(a->Pos);
+	}
+	if (base == NULL || !svec2_is_equal(a->MoveVel, base->MoveVel)) {
+		d.has_MoveVel = true;
+		d.MoveVel = Vec2ToNet(a->MoveVel);
+	}
+	if (base == NULL || a->Dir != base->Dir) {
+		d.has_Dir = true;
+		d.Dir = a->Dir;
+	}
+	if (base == NULL || a->InputSeq != base->InputSeq) {
+		d.has_InputSeq = true;
+		d.InputSeq = a->InputSeq;
+	}
+	return d;
+}
+NetSnapshotActor NetSnapshotActorApply(const NActorSnapshot *d,
+		const NetSnapshotActor *base) {
+	NetSnapshotActor a;
+	if (base != NULL) {
+		a = *base;
+	} else {
+		memset(&a, 0, sizeof a);
+	}
+	a.UID = (int) d->UID;
+	if (d->has_Pos) {
+		a.Pos = NetToVec2(d->Pos);
+	}
+	if (d->has_MoveVel) {
+		a.MoveVel = NetToVec2(d->MoveVel);
+	}
+	if (d->has_Dir) {
+		a.Dir = d->Dir;
+	}
+	if (d->has_InputSeq) {
+		a.InputSeq = d->InputSeq;
+	}
+	return a;
+}
@@ -0,0 +1,84 @@
+/*
+ C-Dogs SDL
+ A port of the legendary (and fun) action/arcade cdogs.
+
+ Copyright (c) 2020 Cong Xu
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "c_array.h"
+#include "proto/msg.pb.h"
+#include "vector.h"
+
+// Snapshots of replicated world state, sent periodically by the server as
+// deltas against the last snapshot each client acknowledged
+
+// How many snapshots are kept to be used as delta bases
+#define NET_SNAPSHOT_HISTORY 32
+// Ticks between snapshots
+#define NET_SNAPSHOT_INTERVAL 5
+
+typedef struct {
+	int UID;
+	struct vec2 Pos;
+	struct vec2 MoveVel;
+	int Dir;
+	uint32_t InputSeq;
+} NetSnapshotActor;
+
+typedef struct {
+	uint32_t Seq;	// 0 if unused
+	CArray Actors;	// of NetSnapshotActor
+} NetSnapshot;
+
+// Ring of recent snapshots, indexed by sequence number
+typedef struct {
+	NetSnapshot Snapshots[NET_SNAPSHOT_HISTORY];
+} NetSnapshots;
+
+void NetSnapshotsInit(NetSnapshots *s);
+void NetSnapshotsTerminate(NetSnapshots *s);
+void NetSnapshotsReset(NetSnapshots *s);
+// Returns NULL if the snapshot is no longer kept
+const NetSnapshot* NetSnapshotsGet(const NetSnapshots *s, const uint32_t seq);
+// Replace the oldest snapshot with an empty one
+NetSnapshot* NetSnapshotsNew(NetSnapshots *s, const uint32_t seq);
+
+// Capture the current world state
+void NetSnapshotCapture(NetSnapshot *s);
+// hint is the index to check first, as actors are usually captured in the
+// same order in every snapshot
+const NetSnapshotActor* NetSnapshotFindActor(const NetSnapshot *s,
+		const int uid, const int hint);
+
+// Make a delta containing only the fields that differ from base;
+// if base is NULL all fields are included
+NActorSnapshot NetSnapshotActorDelta(const NetSnapshotActor *a,
+		const NetSnapshotActor *base);
+NetSnapshotActor NetSnapshotActorApply(const NActorSnapshot *d,
+		const NetSnapshotActor *base);
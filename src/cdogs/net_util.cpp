@@ -31,28 +31,140 @@
 #include "proto/nanopb/pb_decode.h"
 #include "proto/nanopb/pb_encode.h"
 
-ENetPacket* NetEncode(const GameEventType e, const void *data) {
-	uint8_t buffer[1024];
-	pb_ostream_t stream = pb_ostream_from_buffer(buffer, sizeof buffer);
+#include "log.h"
+
+size_t NetEncodeSize(const GameEventType e, const void *data) {
+	const pb_field_t *fields = GameEventGetEntry(e).Fields;
+	size_t len = 0;
+	if (data && fields) {
+		const bool status = pb_get_encoded_size(&len, fields, data);
+		CASSERT(status, "Failed to size pb");
+	}
+	CASSERT(len <= UINT16_MAX, "message too large");
+	return NET_MSG_HEADER_SIZE + len;
+}
+void NetEncode(uint8_t *buf, const size_t size, const GameEventType e,
+		const void *data) {
+	const uint16_t len = (uint16_t) (size - NET_MSG_HEADER_SIZE);
+	const uint32_t msgId = (uint32_t) e;
+	memcpy(buf, &len, NET_MSG_LEN_SIZE);
+	memcpy(buf + NET_MSG_LEN_SIZE, &msgId, NET_MSG_SIZE);
 	const pb_field_t *fields = GameEventGetEntry(e).Fields;
-	const bool status =
-			(data && fields) ? pb_encode(&stream, fields, data) : true;
-	CASSERT(status, "Failed to encode pb");
-	int msgId = (int) e;
-	ENetPacket *packet = enet_packet_create(&msgId,
-			NET_MSG_SIZE + stream.bytes_written, ENET_PACKET_FLAG_RELIABLE);
-	memcpy(packet->data + NET_MSG_SIZE, buffer, stream.bytes_written);
-	return packet;
+	if (len > 0) {
+		pb_ostream_t stream =
+				pb_ostream_from_buffer(buf + NET_MSG_HEADER_SIZE, len);
+		const bool status = pb_encode(&stream, fields, data);
+		CASSERT(status, "Failed to encode pb");
+	}
 }
 
-bool NetDecode(ENetPacket *packet, void *dest, const pb_field_t *fields) {
-	pb_istream_t stream = pb_istream_from_buffer(packet->data + NET_MSG_SIZE,
-			packet->dataLength - NET_MSG_SIZE);
+bool NetDecode(const NetMsg *msg, void *dest, const pb_field_t *fields) {
+	pb_istream_t stream = pb_istream_from_buffer(
+			(uint8_t*) msg->Data, msg->Len);
 	bool status = pb_decode(&stream, fields, dest);
 	CASSERT(status, "Failed to decode pb");
 	return status;
 }
 
+void NetBatchInit(NetBatch *b, const GameEventDelivery delivery) {
+	memset(b, 0, sizeof *b);
+	b->Delivery = delivery;
+	CArrayInit(&b->Packets, sizeof(ENetPacket*));
+}
+void NetBatchTerminate(NetBatch *b) {
+	NetBatchClear(b);
+	CArrayTerminate(&b->Packets);
+}
+void NetBatchClear(NetBatch *b) {
+	CA_FOREACH(ENetPacket*, packet, b->Packets)
+		enet_packet_destroy(*packet);
+	CA_FOREACH_END()
+	CArrayClear(&b->Packets);
+	enet_packet_destroy(b->packet);
+	b->packet = NULL;
+	b->len = 0;
+}
+bool NetBatchIsEmpty(const NetBatch *b) {
+	return b->packet == NULL && b->Packets.size == 0;
+}
+
+static uint8_t* BatchAlloc(NetBatch *b, const size_t len);
+void NetBatchEncode(NetBatch *b, const GameEventType e, const void *data) {
+	const size_t size = NetEncodeSize(e, data);
+	NetEncode(BatchAlloc(b, size), size, e, data);
+}
+void NetBatchAdd(NetBatch *b, const uint8_t *msg, const size_t len) {
+	memcpy(BatchAlloc(b, len), msg, len);
+}
+static void BatchFinishPacket(NetBatch *b);
+static uint8_t* BatchAlloc(NetBatch *b, const size_t len) {
+	// Start a new packet if this message would overflow the MTU;
+	// messages larger than the MTU get a packet to themselves, and are
+	// left to ENet to fragment
+	if (b->packet != NULL && b->len + len > b->packet->dataLength) {
+		BatchFinishPacket(b);
+	}
+	if (b->packet == NULL) {
+		// ENet drops unreliable packets that arrive after a newer one on
+		// the same channel, which gives us sequenced delivery
+		b->packet = enet_packet_create(NULL, MAX(len, NET_BATCH_MTU),
+				b->Delivery == DELIVERY_RELIABLE ?
+						ENET_PACKET_FLAG_RELIABLE : 0);
+		CASSERT(b->packet != NULL, "failed to create packet");
+	}
+	uint8_t *buf = b->packet->data + b->len;
+	b->len += len;
+	return buf;
+}
+static void BatchFinishPacket(NetBatch *b) {
+	if (b->packet == NULL) {
+		return;
+	}
+	// Shrinking doesn't reallocate
+	enet_packet_resize(b->packet, b->len);
+	CArrayPushBack(&b->Packets, &b->packet);
+	b->packet = NULL;
+	b->len = 0;
+}
+
+void NetBatchFlush(NetBatch *b, ENetPeer *peer) {
+	BatchFinishPacket(b);
+	CA_FOREACH(ENetPacket*, packet, b->Packets)
+		if (enet_peer_send(peer, (enet_uint8) b->Delivery, *packet) != 0) {
+			LOG(LM_NET, LL_ERROR, "failed to send packet");
+			enet_packet_destroy(*packet);
+		}
+	CA_FOREACH_END()
+	CArrayClear(&b->Packets);
+}
+
+bool NetBatchNext(const ENetPacket *packet, size_t *offset, NetMsg *msg) {
+	if (*offset >= packet->dataLength) {
+		return false;
+	}
+	if (*offset + NET_MSG_HEADER_SIZE > packet->dataLength) {
+		goto bail;
+	}
+	uint16_t len;
+	uint32_t msgId;
+	memcpy(&len, packet->data + *offset, NET_MSG_LEN_SIZE);
+	memcpy(&msgId, packet->data + *offset + NET_MSG_LEN_SIZE, NET_MSG_SIZE);
+	if (*offset + NET_MSG_HEADER_SIZE + len > packet->dataLength) {
+		goto bail;
+	}
+	msg->Type = (GameEventType) msgId;
+	msg->Data = packet->data + *offset + NET_MSG_HEADER_SIZE;
+	msg->Len = len;
+	*offset += NET_MSG_HEADER_SIZE + len;
+	return true;
+
+bail:
+	LOG(LM_NET, LL_ERROR, "truncated message in packet at %d",
+			(int) *offset);
+	*offset = packet->dataLength;
+	return false;
+}
+
 NPlayerData NMakePlayerData(const PlayerData *p) {
 	NPlayerData d = NPlayerData_init_default;
 	const Character *c = &p->Char;
@@ -103,14 +215,24 @@ NVec2i Vec2i2Net(const struct vec2i v) {
 	return nv;
 }
 struct vec2 NetToVec2(const NVec2 v) {
-	return svec2(v.x, v.y);
+	return svec2((float) v.x / NET_VEC2_SCALE, (float) v.y / NET_VEC2_SCALE);
 }
 NVec2 Vec2ToNet(const struct vec2 v) {
 	NVec2 nv;
-	nv.x = v.x;
-	nv.y = v.y;
+	nv.x = (int32_t) roundf(v.x * NET_VEC2_SCALE);
+	nv.y = (int32_t) roundf(v.y * NET_VEC2_SCALE);
 	return nv;
 }
+float NetToRadians(const uint32_t a, const int bits) {
+	return (float) a * (float) (MPI * 2) / (float) (1u << bits);
+}
+uint32_t RadiansToNet(const float radians, const int bits) {
+	const uint32_t steps = 1u << bits;
+	const float turns = radians / (float) (MPI * 2);
+	// Wrap into [0, 1) turns, rounding to the nearest step
+	const float frac = turns - floorf(turns);
+	return (uint32_t) roundf(frac * (float) steps) % steps;
+}
 color_t Net2Color(const NColor c) {
 	color_t co;
 	co.r = (uint8_t) ((c.RGBA & 0xff000000) >> 24);
@@ -40,15 +40,56 @@
 
 #define NET_LISTEN_PORT 34219
 
-#define NET_PROTOCOL_VERSION 7
+#define NET_PROTOCOL_VERSION 13
 
 // Messages
 
-// All messages start with 4 bytes message type followed by the message struct
+// All messages start with 2 bytes payload length and 4 bytes message type,
+// followed by the message struct
+#define NET_MSG_LEN_SIZE sizeof(uint16_t)
 #define NET_MSG_SIZE sizeof(uint32_t)
+#define NET_MSG_HEADER_SIZE (NET_MSG_LEN_SIZE + NET_MSG_SIZE)
 
-ENetPacket* NetEncode(const GameEventType e, const void *data);
-bool NetDecode(ENetPacket *packet, void *dest, const pb_field_t *fields);
+// Messages sent during a tick are appended to a per-peer batch, and the
+// batch is sent once per tick, split into packets no larger than this
+#define NET_BATCH_MTU 1200
+
+// Messages are encoded directly into ENet packets, which are then sent
+// without copying
+typedef struct {
+	GameEventDelivery Delivery;
+	CArray Packets;	// of ENetPacket *, filled and waiting for the flush
+	ENetPacket *packet;	// being filled, NULL if none
+	size_t len;	// bytes used in packet
+} NetBatch;
+
+typedef struct {
+	GameEventType Type;
+	const uint8_t *Data;
+	size_t Len;
+} NetMsg;
+
+// Encoded length of a message, including the header
+size_t NetEncodeSize(const GameEventType e, const void *data);
+// Encode a message into buf, which must be NetEncodeSize bytes
+void NetEncode(uint8_t *buf, const size_t size, const GameEventType e,
+		const void *data);
+bool NetDecode(const NetMsg *msg, void *dest, const pb_field_t *fields);
+
+void NetBatchInit(NetBatch *b, const GameEventDelivery delivery);
+void NetBatchTerminate(NetBatch *b);
+// Discard all unsent messages
+void NetBatchClear(NetBatch *b);
+bool NetBatchIsEmpty(const NetBatch *b);
+// Encode a message straight into the batch
+void NetBatchEncode(NetBatch *b, const GameEventType e, const void *data);
+// Add an already encoded message
+void NetBatchAdd(NetBatch *b, const uint8_t *msg, const size_t len);
+// Send all batched messages to the peer, on the channel for the batch's
+// delivery class
+void NetBatchFlush(NetBatch *b, ENetPeer *peer);
+// Read the next message in a received batch; returns false at the end
+bool NetBatchNext(const ENetPacket *packet, size_t *offset, NetMsg *msg);
 
 NPlayerData NMakePlayerData(const PlayerData *p);
 NCampaignDef NMakeCampaignDef(const CampaignOptions *co);
@@ -57,8 +98,18 @@ NMissionComplete NMakeMissionComplete(const struct MissionOptions *mo,
 
 struct vec2i Net2Vec2i(const NVec2i v);
 NVec2i Vec2i2Net(const struct vec2i v);
+// Vectors are sent as fixed point, in 1/NET_VEC2_SCALE pixels, which
+// encodes much smaller than floats for typical positions and velocities
+#define NET_VEC2_SCALE 16
 struct vec2 NetToVec2(const NVec2 v);
 NVec2 Vec2ToNet(const struct vec2 v);
+// Angles are sent as fractions of a full turn, using this many bits;
+// both can be any angle (e.g. guns fired by moving bullets), and bullets
+// also need fine steps for spread and recoil
+#define NET_ANGLE_BITS_GUN_FIRE 16
+#define NET_ANGLE_BITS_BULLET 16
+float NetToRadians(const uint32_t a, const int bits);
+uint32_t RadiansToNet(const float radians, const int bits);
 NColor Color2Net(const color_t c);
 color_t Net2Color(const NColor c);
 NCharColors CharColors2Net(const CharColors c);
@@ -27,6 +27,7 @@
  */
 #include "particle.h"
 
+#include "asset_pack.h"
 #include "campaigns.h"
 #include "collision/collision.h"
 #include "font.h"
@@ -57,7 +58,7 @@ void ParticleClassesInit(ParticleClasses *classes, const char *filename) {
 
 	char buf[CDOGS_PATH_MAX];
 	GetDataFilePath(buf, filename);
-	FILE *f = fopen(buf, "r");
+	FILE *f = AssetFOpen(buf, "r");
 	json_t *root = NULL;
 	enum json_error e;
 	if (f == NULL) {
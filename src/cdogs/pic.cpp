@@ -32,6 +32,7 @@
 #include "defs.h"
 #include "grafx.h"
 #include "log.h"
+#include "pic_cache.h"
 #include "texture.h"
 #include "utils.h"
 
@@ -56,6 +57,16 @@ Uint32 ColorToPixel(const SDL_PixelFormat *f, const Uint8 aShift,
 
 void PicLoad(Pic *p, const struct vec2i size, const struct vec2i offset,
 		const SDL_Surface *image) {
+	PicLoadData(p, size, offset, image);
+	if (p->Data == NULL) {
+		return;
+	}
+	if (!PicTryMakeTex(p)) {
+		PicFree(p);
+	}
+}
+void PicLoadData(Pic *p, const struct vec2i size, const struct vec2i offset,
+		const SDL_Surface *image) {
 	memset(p, 0, sizeof *p);
 	p->size = size;
 	p->offset = svec2i_zero();
@@ -81,16 +92,13 @@ void PicLoad(Pic *p, const struct vec2i size, const struct vec2i offset,
 			srcI += image->w - size.x;
 		}
 	}
-
-	if (!PicTryMakeTex(p)) {
-		goto bail;
-	}
-	return;
-
-	bail: PicFree(p);
 }
 bool PicTryMakeTex(Pic *p) {
 	CASSERT(!PicIsNone(p), "cannot make tex of none pic");
+#ifdef CDOGS_HEADLESS
+	// No renderer; only the pixel data and size are used
+	UNUSED(p);
+#else
 	if (textureDebugger == NULL) {
 		textureDebugger = hashmap_new();
 	}
@@ -142,6 +150,7 @@ bool PicTryMakeTex(Pic *p) {
 			LOG(LM_GFX, LL_TRACE, "Error: cannot add texture to debugger");
 		}
 	}
+#endif
 	return true;
 }
 
@@ -177,7 +186,10 @@ void PicFree(Pic *pic) {
 			}
 		}
 	}
-	CFREE(pic->Data);
+	// Pics loaded from the pic cache point into the mapped cache file
+	if (!PicCacheOwns(&gPicCache, pic->Data)) {
+		CFREE(pic->Data);
+	}
 	pic->Data = NULL;
 }
 
@@ -231,7 +243,9 @@ void PicShrink(Pic *pic, const struct vec2i size, const struct vec2i offset) {
 		}
 	}
 	// Replace the old data
-	CFREE(pic->Data);
+	if (!PicCacheOwns(&gPicCache, pic->Data)) {
+		CFREE(pic->Data);
+	}
 	pic->Data = newData;
 	pic->size = size;
 	pic->offset = svec2i_zero();
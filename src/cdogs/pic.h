@@ -49,6 +49,10 @@ Uint32 ColorToPixel(const SDL_PixelFormat *f, const Uint8 aShift,
 
 void PicLoad(Pic *p, const struct vec2i size, const struct vec2i offset,
 		const SDL_Surface *image);
+// Load pixel data only, without making a texture; safe to call off the
+// render thread
+void PicLoadData(Pic *p, const struct vec2i size, const struct vec2i offset,
+		const SDL_Surface *image);
 bool PicTryMakeTex(Pic *p);
 Pic PicCopy(const Pic *src);
 void PicFree(Pic *pic);
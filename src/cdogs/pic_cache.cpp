@@ -0,0 +1,405 @@
+/*
+ C-Dogs SDL
+ A port of the legendary (and fun) action/arcade cdogs.
+
+ Copyright (c) 2020 Cong Xu
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "pic_cache.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#define PIC_CACHE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "asset_pack.h"
+#include "grafx.h"
+#include "log.h"
+#include "pic.h"
+#include "utils.h"
+
+#define PIC_CACHE_MAGIC "CDPC"
+#define PIC_CACHE_VERSION 1
+// Records are padded so that pixel data is aligned when mapped
+#define PIC_CACHE_ALIGN 8
+#define PIC_CACHE_PAD(_n) \
+	(((_n) + PIC_CACHE_ALIGN - 1) & ~(size_t)(PIC_CACHE_ALIGN - 1))
+
+// All values are native endian; the cache is local to the machine
+typedef struct {
+	char Magic[4];
+	uint32_t Version;
+	// Pixel data depends on the graphics format
+	uint8_t Shifts[4];
+	uint32_t Count;
+} PicCacheHeader;
+// Followed by the source path (padded), then the pics
+typedef struct {
+	PicCacheStamp Stamp;
+	uint32_t PathLen;	// including terminator, before padding
+	uint32_t IsSpritesheet;
+	uint32_t NumPics;
+	uint32_t Checksum;	// of everything after the path
+	uint64_t PayloadSize;
+} PicCacheRecord;
+// Followed by W * H pixels, then the texture pixels if present (padded)
+typedef struct {
+	int32_t W;
+	int32_t H;
+	uint32_t HasTexData;
+	uint32_t Unused;
+} PicCachePic;
+
+PicCache gPicCache;
+
+static PicCacheHeader MakeHeader(const uint32_t count) {
+	PicCacheHeader h;
+	memset(&h, 0, sizeof h);
+	memcpy(h.Magic, PIC_CACHE_MAGIC, sizeof h.Magic);
+	h.Version = PIC_CACHE_VERSION;
+	const SDL_PixelFormat *f = gGraphicsDevice.Format;
+	h.Shifts[0] = f->Rshift;
+	h.Shifts[1] = f->Gshift;
+	h.Shifts[2] = f->Bshift;
+	h.Shifts[3] = f->Ashift;
+	h.Count = count;
+	return h;
+}
+
+static uint32_t Checksum(uint32_t hash, const void *data, const size_t len) {
+	// FNV-1a
+	const uint8_t *p = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < len; i++) {
+		hash = (hash ^ p[i]) * 16777619u;
+	}
+	return hash;
+}
+#define CHECKSUM_INIT 2166136261u
+
+void PicCacheInit(PicCache *c) {
+	memset(c, 0, sizeof *c);
+	c->entries = hashmap_new();
+}
+static void PicCacheUnmap(PicCache *c);
+void PicCacheTerminate(PicCache *c) {
+	PicCacheUnmap(c);
+	hashmap_free(c->entries);
+	c->entries = NULL;
+}
+static void PicCacheUnmap(PicCache *c) {
+	if (c->Data == NULL) {
+		return;
+	}
+#ifdef PIC_CACHE_MMAP
+	munmap(c->Data, c->Size);
+#else
+	CFREE(c->Data);
+#endif
+	c->Data = NULL;
+	c->Size = 0;
+}
+
+static bool PicCacheMap(PicCache *c, const char *path);
+static bool PicCacheIndex(PicCache *c);
+bool PicCacheOpen(PicCache *c, const char *path) {
+	if (!PicCacheMap(c, path)) {
+		return false;
+	}
+	if (!PicCacheIndex(c)) {
+		LOG(LM_MAIN, LL_INFO, "Pic cache %s is invalid; ignoring", path);
+		hashmap_free(c->entries);
+		c->entries = hashmap_new();
+		PicCacheUnmap(c);
+		return false;
+	}
+	LOG(LM_MAIN, LL_DEBUG, "Opened pic cache %s with %d entries", path,
+			hashmap_length(c->entries));
+	return true;
+}
+static bool PicCacheMap(PicCache *c, const char *path) {
+#ifdef PIC_CACHE_MMAP
+	const int fd = open(path, O_RDONLY);
+	if (fd == -1) {
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(PicCacheHeader)) {
+		close(fd);
+		return false;
+	}
+	// Private mapping so that pics can modify their data in place without
+	// changing the file
+	void *data = mmap(NULL, (size_t) st.st_size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		LOG(LM_MAIN, LL_WARN, "Cannot map pic cache %s: %s", path,
+				strerror(errno));
+		return false;
+	}
+	c->Data = data;
+	c->Size = (size_t) st.st_size;
+	return true;
+#else
+	// No mmap; read the whole file instead
+	FILE *f = fopen(path, "rb");
+	if (f == NULL) {
+		return false;
+	}
+	bool ok = false;
+	long size;
+	if (fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < 0
+			|| size < (long) sizeof(PicCacheHeader)
+			|| fseek(f, 0, SEEK_SET) != 0) {
+		goto bail;
+	}
+	CMALLOC(c->Data, size);
+	c->Size = (size_t) size;
+	if (fread(c->Data, 1, c->Size, f) != c->Size) {
+		PicCacheUnmap(c);
+		goto bail;
+	}
+	ok = true;
+
+bail:
+	fclose(f);
+	return ok;
+#endif
+}
+static bool PicCacheIndex(PicCache *c) {
+	const uint8_t *p = static_cast<const uint8_t*>(c->Data);
+	const uint8_t *end = p + c->Size;
+	const PicCacheHeader expected = MakeHeader(0);
+	const PicCacheHeader *h = reinterpret_cast<const PicCacheHeader*>(p);
+	if (memcmp(h->Magic, expected.Magic, sizeof h->Magic) != 0
+			|| h->Version != expected.Version
+			|| memcmp(h->Shifts, expected.Shifts, sizeof h->Shifts) != 0) {
+		return false;
+	}
+	p += sizeof *h;
+	for (uint32_t i = 0; i < h->Count; i++) {
+		const PicCacheRecord *r = reinterpret_cast<const PicCacheRecord*>(p);
+		if ((size_t) (end - p) < sizeof *r) {
+			return false;
+		}
+		const char *path = reinterpret_cast<const char*>(r + 1);
+		const size_t pathSize = PIC_CACHE_PAD(r->PathLen);
+		if (r->PathLen == 0
+				|| (size_t) (end - p) < sizeof *r + pathSize + r->PayloadSize
+				|| path[r->PathLen - 1] != '\0') {
+			return false;
+		}
+		if (hashmap_put(c->entries, path, (any_t) r) != MAP_OK) {
+			return false;
+		}
+		p += sizeof *r + pathSize + r->PayloadSize;
+	}
+	return true;
+}
+
+int PicCacheCount(const PicCache *c) {
+	return c->entries != NULL ? hashmap_length(c->entries) : 0;
+}
+bool PicCacheOwns(const PicCache *c, const void *data) {
+	const uint8_t *p = static_cast<const uint8_t*>(data);
+	const uint8_t *start = static_cast<const uint8_t*>(c->Data);
+	return start != NULL && p >= start && p < start + c->Size;
+}
+
+PicCacheStamp PicCacheStampFile(const char *path) {
+	PicCacheStamp s;
+	memset(&s, 0, sizeof s);
+	AssetStat(path, &s.MTime, &s.Size);
+	return s;
+}
+
+bool PicCacheTryLoad(const PicCache *c, const char *srcPath,
+		const PicCacheStamp stamp, bool *isSpritesheet, CArray *pics,
+		CArray *texData) {
+	if (c->Data == NULL) {
+		return false;
+	}
+	any_t data;
+	if (hashmap_get(c->entries, srcPath, &data) != MAP_OK) {
+		return false;
+	}
+	const PicCacheRecord *r = static_cast<const PicCacheRecord*>(data);
+	if (r->Stamp.MTime != stamp.MTime || r->Stamp.Size != stamp.Size) {
+		return false;
+	}
+	uint8_t *payload = reinterpret_cast<uint8_t*>(const_cast<PicCacheRecord*>(
+			r + 1)) + PIC_CACHE_PAD(r->PathLen);
+	if (Checksum(CHECKSUM_INIT, payload, (size_t) r->PayloadSize)
+			!= r->Checksum) {
+		LOG(LM_MAIN, LL_WARN, "Pic cache entry %s is corrupt", srcPath);
+		return false;
+	}
+
+	// Validate sizes before handing out any pics
+	const uint8_t *end = payload + r->PayloadSize;
+	uint8_t *p = payload;
+	for (uint32_t i = 0; i < r->NumPics; i++) {
+		const PicCachePic *cp = reinterpret_cast<const PicCachePic*>(p);
+		if ((size_t) (end - p) < sizeof *cp || cp->W < 0 || cp->H < 0) {
+			return false;
+		}
+		const size_t len = (size_t) cp->W * cp->H * sizeof(Uint32);
+		const size_t size = sizeof *cp
+				+ PIC_CACHE_PAD(len * (cp->HasTexData ? 2 : 1));
+		if ((size_t) (end - p) < size) {
+			return false;
+		}
+		p += size;
+	}
+
+	*isSpritesheet = r->IsSpritesheet != 0;
+	p = payload;
+	for (uint32_t i = 0; i < r->NumPics; i++) {
+		const PicCachePic *cp = reinterpret_cast<const PicCachePic*>(p);
+		p += sizeof *cp;
+		Pic pic;
+		memset(&pic, 0, sizeof pic);
+		pic.size = svec2i(cp->W, cp->H);
+		const size_t len = (size_t) cp->W * cp->H * sizeof(Uint32);
+		Uint32 *tex = NULL;
+		if (len > 0) {
+			pic.Data = reinterpret_cast<Uint32*>(p);
+			if (cp->HasTexData) {
+				tex = reinterpret_cast<Uint32*>(p + len);
+			}
+		}
+		CArrayPushBack(pics, &pic);
+		CArrayPushBack(texData, &tex);
+		p += PIC_CACHE_PAD(len * (cp->HasTexData ? 2 : 1));
+	}
+	return true;
+}
+
+bool PicCacheWriterOpen(PicCacheWriter *w, const char *path) {
+	memset(w, 0, sizeof *w);
+	strcpy(w->path, path);
+	sprintf(w->tmpPath, "%s.tmp", path);
+	w->f = fopen(w->tmpPath, "wb");
+	if (w->f == NULL) {
+		LOG(LM_MAIN, LL_WARN, "Cannot write pic cache %s: %s", w->tmpPath,
+				strerror(errno));
+		return false;
+	}
+	// Count is filled in on close
+	const PicCacheHeader h = MakeHeader(0);
+	fwrite(&h, sizeof h, 1, w->f);
+	return true;
+}
+static void WritePadding(FILE *f, const size_t len) {
+	static const uint8_t zeros[PIC_CACHE_ALIGN] = { 0 };
+	fwrite(zeros, 1, PIC_CACHE_PAD(len) - len, f);
+}
+void PicCacheWriterAdd(PicCacheWriter *w, const char *srcPath,
+		const PicCacheStamp stamp, const bool isSpritesheet,
+		const CArray *pics, const CArray *texData) {
+	if (w->f == NULL) {
+		return;
+	}
+	PicCacheRecord r;
+	memset(&r, 0, sizeof r);
+	r.Stamp = stamp;
+	r.PathLen = (uint32_t) strlen(srcPath) + 1;
+	r.IsSpritesheet = isSpritesheet;
+	r.NumPics = (uint32_t) pics->size;
+
+	// Work out the payload size and checksum as it will be written
+	uint32_t checksum = CHECKSUM_INIT;
+	static const uint8_t zeros[PIC_CACHE_ALIGN] = { 0 };
+	CA_FOREACH(const Pic, pic, *pics)
+		const Uint32 *tex = *static_cast<Uint32* const*>(CArrayGet(texData,
+				_ca_index));
+		PicCachePic cp;
+		memset(&cp, 0, sizeof cp);
+		if (pic->Data != NULL) {
+			cp.W = pic->size.x;
+			cp.H = pic->size.y;
+		}
+		cp.HasTexData = cp.W * cp.H > 0 && tex != NULL;
+		const size_t len = (size_t) cp.W * cp.H * sizeof(Uint32);
+		checksum = Checksum(checksum, &cp, sizeof cp);
+		checksum = Checksum(checksum, pic->Data, len);
+		if (cp.HasTexData) {
+			checksum = Checksum(checksum, tex, len);
+		}
+		const size_t dataLen = len * (cp.HasTexData ? 2 : 1);
+		checksum = Checksum(checksum, zeros, PIC_CACHE_PAD(dataLen) - dataLen);
+		r.PayloadSize += sizeof cp + PIC_CACHE_PAD(dataLen);
+	CA_FOREACH_END()
+	r.Checksum = checksum;
+
+	fwrite(&r, sizeof r, 1, w->f);
+	fwrite(srcPath, 1, r.PathLen, w->f);
+	WritePadding(w->f, r.PathLen);
+	CA_FOREACH(const Pic, pic, *pics)
+		const Uint32 *tex = *static_cast<Uint32* const*>(CArrayGet(texData,
+				_ca_index));
+		PicCachePic cp;
+		memset(&cp, 0, sizeof cp);
+		if (pic->Data != NULL) {
+			cp.W = pic->size.x;
+			cp.H = pic->size.y;
+		}
+		cp.HasTexData = cp.W * cp.H > 0 && tex != NULL;
+		const size_t len = (size_t) cp.W * cp.H * sizeof(Uint32);
+		fwrite(&cp, sizeof cp, 1, w->f);
+		fwrite(pic->Data, 1, len, w->f);
+		if (cp.HasTexData) {
+			fwrite(tex, 1, len, w->f);
+		}
+		WritePadding(w->f, len * (cp.HasTexData ? 2 : 1));
+	CA_FOREACH_END()
+	w->count++;
+}
+void PicCacheWriterClose(PicCacheWriter *w) {
+	if (w->f == NULL) {
+		return;
+	}
+	const PicCacheHeader h = MakeHeader(w->count);
+	const bool ok = fseek(w->f, 0, SEEK_SET) == 0
+			&& fwrite(&h, sizeof h, 1, w->f) == 1;
+	if (fclose(w->f) != 0 || !ok) {
+		LOG(LM_MAIN, LL_WARN, "Failed to write pic cache %s", w->tmpPath);
+		remove(w->tmpPath);
+	} else {
+		// The old cache may still be mapped; this is fine as the mapping
+		// keeps its own reference to the file
+		remove(w->path);
+		if (rename(w->tmpPath, w->path) != 0) {
+			LOG(LM_MAIN, LL_WARN, "Failed to replace pic cache %s: %s",
+					w->path, strerror(errno));
+			remove(w->tmpPath);
+		}
+	}
+	w->f = NULL;
+}
@@ -0,0 +1,84 @@
+/*
+ C-Dogs SDL
+ A port of the legendary (and fun) action/arcade cdogs.
+
+ Copyright (c) 2020 Cong Xu
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "c_array.h"
+#include "c_hashmap/hashmap.h"
+#include "sys_config.h"
+
+// On-disk cache of decoded and post-processed pics, so that warm starts can
+// skip PNG decoding and the char channel conversion.
+// Entries are keyed by source file path and are only used if the source's
+// modification time and size are unchanged and the payload checksum matches.
+// The cache file is memory-mapped and pic data points directly into it.
+
+typedef struct {
+	int64_t MTime;
+	int64_t Size;
+} PicCacheStamp;
+
+typedef struct {
+	void *Data;	// mapped cache file
+	size_t Size;
+	map_t entries;	// of PicCacheEntry, by source file path
+} PicCache;
+
+extern PicCache gPicCache;
+
+void PicCacheInit(PicCache *c);
+// Pics loaded from the cache must be freed before terminating it
+void PicCacheTerminate(PicCache *c);
+
+// Map the cache file; returns false if there is no valid cache
+bool PicCacheOpen(PicCache *c, const char *path);
+int PicCacheCount(const PicCache *c);
+bool PicCacheOwns(const PicCache *c, const void *data);
+
+PicCacheStamp PicCacheStampFile(const char *path);
+// Read-only; safe to call from multiple threads at once
+// pics: of Pic, texData: of Uint32 *, like PicLoadJob
+bool PicCacheTryLoad(const PicCache *c, const char *srcPath,
+		const PicCacheStamp stamp, bool *isSpritesheet, CArray *pics,
+		CArray *texData);
+
+// Writing a new cache: replaces the file on success
+typedef struct {
+	FILE *f;
+	char path[CDOGS_PATH_MAX];
+	char tmpPath[CDOGS_PATH_MAX];
+	uint32_t count;
+} PicCacheWriter;
+bool PicCacheWriterOpen(PicCacheWriter *w, const char *path);
+void PicCacheWriterAdd(PicCacheWriter *w, const char *srcPath,
+		const PicCacheStamp stamp, const bool isSpritesheet,
+		const CArray *pics, const CArray *texData);
+void PicCacheWriterClose(PicCacheWriter *w);
@@ -27,14 +27,20 @@
  */
 #include "pic_manager.h"
 
+#include <SDL2/SDL_cpuinfo.h>
 #include <SDL2/SDL_image.h>
+#include <SDL2/SDL_thread.h>
 
 #include <tinydir/tinydir.h>
 
+#include "asset_pack.h"
 #include "files.h"
 #include "log.h"
+#include "pic_cache.h"
+#include "pixels.h"
 
 #define GRAPHICS_DIR "graphics"
+#define PIC_CACHE_FILE "pics.cache"
 
 PicManager gPicManager;
 
@@ -54,113 +60,194 @@ void PicManagerInit(PicManager *pm) {
 	CArrayInit(&pm->exitStyleNames, sizeof(char*));
 	CArrayInit(&pm->doorStyleNames, sizeof(char*));
 	CArrayInit(&pm->keyStyleNames, sizeof(char*));
+	CArrayInit(&pm->pendingTextures, sizeof(PicPendingTexture));
+	PicCacheInit(&gPicCache);
 }
 
-static NamedPic* AddNamedPic(map_t pics, const char *name, const Pic *p);
-static NamedSprites* AddNamedSprites(map_t sprites, const char *name);
-static void AfterAdd(PicManager *pm);
-static void PicManagerAdd(map_t pics, map_t sprites, const char *name,
-		SDL_Surface *imageIn) {
-	char buf[CDOGS_FILENAME_MAX];
-	const char *dot = strrchr(name, '.');
-	if (dot) {
-		strncpy(buf, name, dot - name);
-		buf[dot - name] = '\0';
-	} else {
-		strcpy(buf, name);
-	}
-	// TODO: check if name already exists
-	// Special case: if the file name is in the form foobar_WxH.ext,
-	// this is a spritesheet where each sprite is W wide by H high
-	// Load multiple images from this single sheet
-	struct vec2i size = svec2i(imageIn->w, imageIn->h);
-	bool isSpritesheet = false;
-	char *underscore = strrchr(buf, '_');
-	const char *x = strrchr(buf, 'x');
-	if (underscore != NULL && x != NULL && underscore + 1 < x
-			&& x + 1 < buf + strlen(buf)) {
-		if (sscanf(underscore, "_%dx%d", &size.x, &size.y) != 2) {
-			size = svec2i(imageIn->w, imageIn->h);
-		} else {
-			*underscore = '\0';
-			isSpritesheet = true;
-		}
+static PixelShifts GetPixelShifts(void) {
+	const SDL_PixelFormat *f = gGraphicsDevice.Format;
+	PixelShifts s = { f->Rshift, f->Gshift, f->Bshift, f->Ashift };
+	return s;
+}
+
+// Images are decoded by a pool of worker threads, then added to the pic
+// manager and made into textures on the calling (render) thread in the order
+// they were found, so that names and ordering are the same as a serial load
+#define PIC_LOADER_MAX_THREADS 8
+typedef struct {
+	char Path[CDOGS_PATH_MAX];
+	char Name[CDOGS_PATH_MAX];
+	// Written by the worker
+	PicCacheStamp Stamp;
+	bool FromCache;
+	bool IsSpritesheet;
+	CArray Pics;	// of Pic, without textures
+	// Source data for making the textures of pics whose data is changed
+	// after loading, or NULL to use the pic's data
+	CArray TexData;	// of Uint32 *
+	bool Done;
+	// The pics' copies in the pic manager, or NULL if they couldn't be added
+	Pic *Added;
+} PicLoadJob;
+typedef struct {
+	CArray Jobs;	// of PicLoadJob
+	const PicCache *Cache;	// NULL to always decode
+	SDL_atomic_t Next;
+	SDL_mutex *Lock;
+	SDL_cond *Cond;
+} PicLoader;
+
+static void LoadDir(PicLoader *l, const char *path, const char *prefix);
+static void PicLoaderRun(PicLoader *l, PicManager *pm, map_t pics,
+		map_t sprites);
+static int PicLoaderStart(PicLoader *l, SDL_Thread **threads);
+static void PicLoaderStop(PicLoader *l, SDL_Thread **threads,
+		const int numThreads);
+static int PicLoaderWork(void *data);
+static void PicLoaderAddJob(PicManager *pm, map_t pics, map_t sprites,
+		PicLoadJob *job);
+static void PicLoaderWriteCache(const PicLoader *l, const char *cachePath);
+static void PicLoadJobFinish(PicManager *pm, PicLoadJob *job);
+static void PicLoadJobTerminate(PicLoadJob *job);
+static void LoadDirCached(PicManager *pm, const char *path,
+		const char *prefix, map_t pics, map_t sprites, const char *cachePath) {
+	PicLoader l;
+	memset(&l, 0, sizeof l);
+	CArrayInit(&l.Jobs, sizeof(PicLoadJob));
+	l.Cache = cachePath != NULL ? &gPicCache : NULL;
+	LoadDir(&l, path, prefix);
+	if (l.Jobs.size > 0) {
+		PicLoaderRun(&l, pm, pics, sprites);
 	}
-	NamedSprites *nsp = NULL;
-	NamedPic *np = NULL;
-	if (isSpritesheet) {
-		nsp = AddNamedSprites(sprites, buf);
-	} else {
-		np = AddNamedPic(pics, buf, NULL);
+	if (cachePath != NULL) {
+		PicLoaderWriteCache(&l, cachePath);
+		CA_FOREACH(PicLoadJob, job, l.Jobs)
+			PicLoadJobFinish(pm, job);
+		CA_FOREACH_END()
 	}
-	// Use 32-bit image
-	SDL_Surface *image = SDL_ConvertSurfaceFormat(imageIn,
-			SDL_PIXELFORMAT_RGBA8888, 0);
-	SDL_FreeSurface(imageIn);
-	SDL_LockSurface(image);
-	struct vec2i offset;
-	for (offset.y = 0; offset.y < image->h; offset.y += size.y) {
-		for (offset.x = 0; offset.x < image->w; offset.x += size.x) {
-			Pic *pic;
-			if (isSpritesheet) {
-				Pic p;
-				CArrayPushBack(&nsp->pics, &p);
-				pic = static_cast<Pic*>(CArrayGet(&nsp->pics,
-						nsp->pics.size - 1));
-			} else {
-				pic = &np->pic;
+	CA_FOREACH(PicLoadJob, job, l.Jobs)
+		PicLoadJobTerminate(job);
+	CA_FOREACH_END()
+	CArrayTerminate(&l.Jobs);
+}
+void PicManagerLoadDir(PicManager *pm, const char *path, const char *prefix,
+		map_t pics, map_t sprites) {
+	LoadDirCached(pm, path, prefix, pics, sprites, NULL);
+}
+void PicDecodedDirLoad(PicDecodedDir *d, const char *path,
+		const char *prefix) {
+	PicLoader l;
+	memset(&l, 0, sizeof l);
+	CArrayInit(&l.Jobs, sizeof(PicLoadJob));
+	LoadDir(&l, path, prefix);
+	if (l.Jobs.size > 0) {
+		SDL_Thread *threads[PIC_LOADER_MAX_THREADS];
+		PicLoaderStop(&l, threads, PicLoaderStart(&l, threads));
+	}
+	d->Jobs = l.Jobs;
+}
+void PicManagerAddDecodedDir(PicManager *pm, PicDecodedDir *d, map_t pics,
+		map_t sprites) {
+	PicManagerBeginBulkLoad(pm);
+	CA_FOREACH(PicLoadJob, job, d->Jobs)
+		PicLoaderAddJob(pm, pics, sprites, job);
+		PicLoadJobFinish(pm, job);
+		PicLoadJobTerminate(job);
+	CA_FOREACH_END()
+	PicManagerEndBulkLoad(pm);
+	CArrayClear(&d->Jobs);
+}
+void PicDecodedDirTerminate(PicDecodedDir *d) {
+	// Free the pics that were never added
+	CA_FOREACH(PicLoadJob, job, d->Jobs)
+		for (int i = 0; i < (int) job->Pics.size; i++) {
+			Pic *pic = static_cast<Pic*>(CArrayGet(&job->Pics, i));
+			if (!PicIsNone(pic)) {
+				PicFree(pic);
 			}
-			PicLoad(pic, size, offset, image);
-
-			if (strncmp("chars/", buf, strlen("chars/")) == 0) {
-				// Convert char pics to multichannel version
-				for (int i = 0; i < pic->size.x * pic->size.y; i++) {
-					color_t c = PIXEL2COLOR(pic->Data[i]);
-					// Don't bother if the alpha has already been modified; it
-					// means we have already processed this pixel
-					if (c.a != 255) {
-						continue;
-					}
-					const uint8_t value = MAX(MAX(c.r, c.g), c.b);
-					if (abs((int) c.r - c.g) < 5 && abs((int) c.g - c.b) < 5) {
-						// don't convert greyscale colours
-					} else if ((c.g < 5 && c.b < 5)
-							|| (abs((int) c.g - c.b) < 5 && c.r > 250)) {
-						// Skin
-						c.r = c.g = c.b = value;
-						c.a = 254;
-					} else if ((c.r < 5 && c.b < 5)
-							|| (abs((int) c.r - c.b) < 5 && c.g > 250)) {
-						// Hair
-						c.r = c.g = c.b = value;
-						c.a = 250;
-					} else if ((c.r < 5 && c.g < 5)
-							|| (abs((int) c.r - c.g) < 5 && c.b > 250)) {
-						// Arms
-						c.r = c.g = c.b = value;
-						c.a = 253;
-					} else if (c.b < 5 || (c.r > 250 && c.g > 250)) {
-						// Body
-						c.r = c.g = c.b = value;
-						c.a = 252;
-					} else if (c.r < 5 || (c.g > 250 && c.b > 250)) {
-						// Legs
-						c.r = c.g = c.b = value;
-						c.a = 251;
-					}
-					pic->Data[i] = COLOR2PIXEL(c);
-				}
+		}
+		PicLoadJobTerminate(job);
+	CA_FOREACH_END()
+	CArrayTerminate(&d->Jobs);
+}
+static bool PicLoaderIsDone(const PicLoader *l, const int i) {
+	return static_cast<const PicLoadJob*>(CArrayGet(&l->Jobs, i))->Done;
+}
+static void PicLoaderRun(PicLoader *l, PicManager *pm, map_t pics,
+		map_t sprites) {
+	SDL_Thread *threads[PIC_LOADER_MAX_THREADS];
+	const int numThreads = PicLoaderStart(l, threads);
+
+	// Add the jobs in order as they complete, a batch at a time
+	PicManagerBeginBulkLoad(pm);
+	for (int i = 0; i < (int) l->Jobs.size;) {
+		int end = i;
+		SDL_LockMutex(l->Lock);
+		while (!PicLoaderIsDone(l, i)) {
+			SDL_CondWait(l->Cond, l->Lock);
+		}
+		while (end < (int) l->Jobs.size && PicLoaderIsDone(l, end)) {
+			end++;
+		}
+		SDL_UnlockMutex(l->Lock);
+		for (; i < end; i++) {
+			PicLoadJob *job = static_cast<PicLoadJob*>(CArrayGet(&l->Jobs, i));
+			PicLoaderAddJob(pm, pics, sprites, job);
+			// Without a cache to write, nothing else reads the job's pics
+			if (l->Cache == NULL) {
+				PicLoadJobFinish(pm, job);
 			}
 		}
 	}
-	SDL_UnlockSurface(image);
-	SDL_FreeSurface(image);
+	PicManagerEndBulkLoad(pm);
 
-	AfterAdd(&gPicManager);
-}
+	PicLoaderStop(l, threads, numThreads);
+}
+// Start decoding the jobs; returns the number of thread slots used
+static int PicLoaderStart(PicLoader *l, SDL_Thread **threads) {
+	l->Lock = SDL_CreateMutex();
+	l->Cond = SDL_CreateCond();
+	const int numThreads = CLAMP(SDL_GetCPUCount(), 1,
+			MIN(PIC_LOADER_MAX_THREADS, (int) l->Jobs.size));
+	int threadsCreated = 0;
+	for (int i = 0; i < numThreads; i++) {
+		threads[i] = SDL_CreateThread(PicLoaderWork, "PicLoader", l);
+		if (threads[i] == NULL) {
+			LOG(LM_MAIN, LL_WARN, "Cannot create pic loader thread: %s",
+					SDL_GetError());
+		} else {
+			threadsCreated++;
+		}
+	}
+	if (threadsCreated == 0) {
+		// Load everything on this thread instead
+		PicLoaderWork(l);
+	}
+	return numThreads;
+}
+// Wait for all the jobs to be decoded
+static void PicLoaderStop(PicLoader *l, SDL_Thread **threads,
+		const int numThreads) {
+	for (int i = 0; i < numThreads; i++) {
+		if (threads[i] != NULL) {
+			SDL_WaitThread(threads[i], NULL);
+		}
+	}
+	SDL_DestroyCond(l->Cond);
+	SDL_DestroyMutex(l->Lock);
+}
+static void AddLoadJob(PicLoader *l, const char *path, const char *name,
+		const char *prefix);
+static void LoadDir(PicLoader *l, const char *path, const char *prefix) {
+	// Use the asset pack's listing if it has this dir
+	AssetPackDir pd;
+	if (AssetPackDirOpen(&pd, &gAssetPack, path)) {
+		while (AssetPackDirNext(&pd)) {
+			AddLoadJob(l, pd.Path, pd.Name, prefix);
+		}
+		return;
+	}
 
-void PicManagerLoadDir(PicManager *pm, const char *path, const char *prefix,
-		map_t pics, map_t sprites) {
 	tinydir_dir dir;
 	if (tinydir_open(&dir, path) == -1) {
 		if (errno != ENOENT) {
@@ -178,202 +265,412 @@ void PicManagerLoadDir(PicManager *pm, const char *path, const char *prefix,
 			goto bail;
 		}
 		if (file.is_reg) {
-			SDL_RWops *rwops = SDL_RWFromFile(file.path, "rb");
-			const bool isPng = IMG_isPNG(rwops);
-			if (isPng) {
-				SDL_Surface *data = IMG_Load_RW(rwops, 0);
-				if (!data) {
-					LOG(LM_MAIN, LL_ERROR, "Cannot load image IMG_Load: %s",
-							IMG_GetError());
-				} else {
-					char buf[CDOGS_PATH_MAX];
-					if (prefix) {
-						char buf1[CDOGS_PATH_MAX];
-						sprintf(buf1, "%s/%s", prefix, file.name);
-						PathGetWithoutExtension(buf, buf1);
-					} else {
-						PathGetBasenameWithoutExtension(buf, file.name);
-					}
-					PicManagerAdd(pics, sprites, buf, data);
-				}
-			}
-			rwops->close(rwops);
+			AddLoadJob(l, file.path, file.name, prefix);
 		} else if (file.is_dir && file.name[0] != '.') {
 			if (prefix) {
 				char buf[CDOGS_PATH_MAX];
 				sprintf(buf, "%s/%s", prefix, file.name);
-				PicManagerLoadDir(pm, file.path, buf, pics, sprites);
+				LoadDir(l, file.path, buf);
 			} else {
-				PicManagerLoadDir(pm, file.path, file.name, pics, sprites);
+				LoadDir(l, file.path, file.name);
 			}
 		}
 	}
 
 	bail: tinydir_close(&dir);
 }
-void PicManagerLoad(PicManager *pm) {
-	char buf[CDOGS_PATH_MAX];
-	GetDataFilePath(buf, GRAPHICS_DIR);
-	PicManagerLoadDir(pm, buf, NULL, pm->pics, pm->sprites);
-}
-
-static void FindStylePics(PicManager *pm, CArray *styleNames,
-		PFany hashmapFunc);
-static void FindStyleSprites(PicManager *pm, CArray *styleNames,
-		PFany hashmapFunc);
-static int MaybeAdHairSpriteName(any_t data, any_t item);
-static int MaybeAddWallPicName(any_t data, any_t item);
-static int MaybeAddTilePicName(any_t data, any_t item);
-static int MaybeAddExitPicName(any_t data, any_t item);
-static int MaybeAddKeyPicName(any_t data, any_t item);
-static int MaybeAddDoorPicName(any_t data, any_t item);
-static void AfterAdd(PicManager *pm) {
-	FindStyleSprites(pm, &pm->hairstyleNames, MaybeAdHairSpriteName);
-	FindStylePics(pm, &pm->wallStyleNames, MaybeAddWallPicName);
-	FindStylePics(pm, &pm->tileStyleNames, MaybeAddTilePicName);
-	FindStylePics(pm, &pm->exitStyleNames, MaybeAddExitPicName);
-	FindStylePics(pm, &pm->doorStyleNames, MaybeAddDoorPicName);
-	FindStylePics(pm, &pm->keyStyleNames, MaybeAddKeyPicName);
-}
-static int CompareStyleNames(const void *v1, const void *v2);
-static void StylesClear(CArray *styles) {
-	CA_FOREACH(char *, styleName, *styles)
-	CFREE(*styleName);
-	CA_FOREACH_END()
-	CArrayClear(styles);
+// name is the file's path relative to the dir being loaded
+static void AddLoadJob(PicLoader *l, const char *path, const char *name,
+		const char *prefix) {
+	PicLoadJob job;
+	memset(&job, 0, sizeof job);
+	strcpy(job.Path, path);
+	if (prefix) {
+		char buf[CDOGS_PATH_MAX];
+		sprintf(buf, "%s/%s", prefix, name);
+		PathGetWithoutExtension(job.Name, buf);
+	} else {
+		PathGetWithoutExtension(job.Name, name);
+	}
+	CArrayInit(&job.Pics, sizeof(Pic));
+	CArrayInit(&job.TexData, sizeof(Uint32*));
+	CArrayPushBack(&l->Jobs, &job);
 }
-static void FindStylePics(PicManager *pm, CArray *styleNames,
-		PFany hashmapFunc) {
-	// Scan all pics for style pics
-	StylesClear(styleNames);
-	hashmap_iterate(pm->customPics, hashmapFunc, pm);
-	hashmap_iterate(pm->pics, hashmapFunc, pm);
-	// Sort the style names alphabetically
-	// This prevents the list from reordering unpredictably, when the editor
-	// is used and masked pics get added
-	if (styleNames->data != NULL) {
-		qsort(styleNames->data, styleNames->size, styleNames->elemSize,
-				CompareStyleNames);
-	}
-}
-static int CompareStyleNames(const void *v1, const void *v2) {
-	const char *const*s1 = static_cast<const char* const*>(v1);
-	const char *const*s2 = static_cast<const char* const*>(v2);
-	return strcmp(*s1, *s2);
-}
-static void FindStyleSprites(PicManager *pm, CArray *styleNames,
-		PFany hashmapFunc) {
-	// Scan all pics for style sprites
-	StylesClear(styleNames);
-	hashmap_iterate(pm->customSprites, hashmapFunc, pm);
-	hashmap_iterate(pm->sprites, hashmapFunc, pm);
-	// Sort the style names alphabetically
-	// This prevents the list from reordering unpredictably, when the editor
-	// is used and masked pics get added
-	if (styleNames->data != NULL) {
-		qsort(styleNames->data, styleNames->size, styleNames->elemSize,
-				CompareStyleNames);
+
+static void PicLoadJobRun(PicLoadJob *job, const PicCache *cache);
+static int PicLoaderWork(void *data) {
+	PicLoader *l = static_cast<PicLoader*>(data);
+	for (;;) {
+		const int i = SDL_AtomicAdd(&l->Next, 1);
+		if (i >= (int) l->Jobs.size) {
+			break;
+		}
+		PicLoadJob *job = static_cast<PicLoadJob*>(CArrayGet(&l->Jobs, i));
+		PicLoadJobRun(job, l->Cache);
+		SDL_LockMutex(l->Lock);
+		job->Done = true;
+		SDL_CondSignal(l->Cond);
+		SDL_UnlockMutex(l->Lock);
 	}
+	return 0;
 }
-static void MaybeAddStyleName(const char *picName, const char *prefix,
-		CArray *styleNames) {
-	// Look for style names within a full name of the form:
-	// prefix/style/suffix
-	// NOTE: prefix should include trailing slash
-	if (strncmp(picName, prefix, strlen(prefix)) != 0) {
+static bool ParseSpritesheetName(char *name, struct vec2i *size);
+static void PicLoadJobRun(PicLoadJob *job, const PicCache *cache) {
+	job->Stamp = PicCacheStampFile(job->Path);
+	if (cache != NULL && PicCacheTryLoad(cache, job->Path, job->Stamp,
+			&job->IsSpritesheet, &job->Pics, &job->TexData)) {
+		job->FromCache = true;
+		if (job->IsSpritesheet) {
+			struct vec2i size;
+			ParseSpritesheetName(job->Name, &size);
+		}
 		return;
 	}
-	const char *nextSlash = strchr(picName + strlen(prefix), '/');
-	if (nextSlash == NULL) {
-		nextSlash = picName + strlen(picName);
+
+	SDL_RWops *rwops = AssetRWFromFile(job->Path);
+	if (rwops == NULL) {
+		return;
 	}
-	char buf[CDOGS_PATH_MAX];
-	const size_t len = nextSlash - picName - strlen(prefix);
-	strncpy(buf, picName + strlen(prefix), len);
-	buf[len] = '\0';
-	// Check if we already have the style name
-	// This can happen if a custom pic uses the same name as a built in one
-	CA_FOREACH(char *, styleName, *styleNames)
-	if (strcmp(*styleName, buf) == 0)
+	SDL_Surface *imageIn = NULL;
+	SDL_Surface *image = NULL;
+	if (!IMG_isPNG(rwops)) {
+		goto bail;
+	}
+	imageIn = IMG_Load_RW(rwops, 0);
+	if (!imageIn) {
+		LOG(LM_MAIN, LL_ERROR, "Cannot load image IMG_Load: %s",
+				IMG_GetError());
+		goto bail;
+	}
+
 	{
+		struct vec2i size = svec2i(imageIn->w, imageIn->h);
+		job->IsSpritesheet = ParseSpritesheetName(job->Name, &size);
+		const bool isChar =
+				strncmp("chars/", job->Name, strlen("chars/")) == 0;
+		// Use 32-bit image
+		image = SDL_ConvertSurfaceFormat(imageIn, SDL_PIXELFORMAT_RGBA8888, 0);
+		if (image == NULL) {
+			LOG(LM_MAIN, LL_ERROR, "Cannot convert image %s: %s", job->Path,
+					SDL_GetError());
+			goto bail;
+		}
+		SDL_LockSurface(image);
+		struct vec2i offset;
+		for (offset.y = 0; offset.y < image->h; offset.y += size.y) {
+			for (offset.x = 0; offset.x < image->w; offset.x += size.x) {
+				Pic pic;
+				PicLoadData(&pic, size, offset, image);
+				Uint32 *texData = NULL;
+				if (isChar && pic.Data != NULL) {
+					// Convert char pics to multichannel version, keeping the
+					// original for the texture
+					const size_t len = pic.size.x * pic.size.y;
+					CMALLOC(texData, len * sizeof *texData);
+					memcpy(texData, pic.Data, len * sizeof *texData);
+					PixelsToCharChannels(pic.Data, (int) len,
+							GetPixelShifts());
+				}
+				CArrayPushBack(&job->Pics, &pic);
+				CArrayPushBack(&job->TexData, &texData);
+			}
+		}
+		SDL_UnlockSurface(image);
+	}
+
+bail:
+	SDL_FreeSurface(image);
+	SDL_FreeSurface(imageIn);
+	rwops->close(rwops);
+}
+// TODO: check if name already exists
+// Special case: if the file name is in the form foobar_WxH.ext,
+// this is a spritesheet where each sprite is W wide by H high
+// Load multiple images from this single sheet
+// Strips the size from the name and returns true if so
+static bool ParseSpritesheetName(char *name, struct vec2i *size) {
+	char *underscore = strrchr(name, '_');
+	const char *x = strrchr(name, 'x');
+	if (underscore != NULL && x != NULL && underscore + 1 < x
+			&& x + 1 < name + strlen(name)) {
+		struct vec2i s;
+		if (sscanf(underscore, "_%dx%d", &s.x, &s.y) == 2) {
+			*underscore = '\0';
+			*size = s;
+			return true;
+		}
+	}
+	return false;
+}
+
+static NamedPic* AddNamedPic(PicManager *pm, map_t pics, const char *name,
+		const Pic *p);
+static NamedSprites* AddNamedSprites(PicManager *pm, map_t sprites,
+		const char *name);
+static void PicLoaderAddJob(PicManager *pm, map_t pics, map_t sprites,
+		PicLoadJob *job) {
+	if (job->Pics.size == 0) {
+		return;
+	}
+	if (job->IsSpritesheet) {
+		NamedSprites *nsp = AddNamedSprites(pm, sprites, job->Name);
+		if (nsp == NULL) {
+			return;
+		}
+		CA_FOREACH(Pic, pic, job->Pics)
+			CArrayPushBack(&nsp->pics, pic);
+		CA_FOREACH_END()
+		job->Added = static_cast<Pic*>(CArrayGet(&nsp->pics, 0));
+	} else {
+		Pic *pic = static_cast<Pic*>(CArrayGet(&job->Pics, 0));
+		NamedPic *n = AddNamedPic(pm, pics, job->Name, pic);
+		if (n != NULL) {
+			job->Added = &n->pic;
+		}
+	}
+}
+// The loader owns the pic data until the job is finished, so that the cache
+// can be written from it. Make the textures of the pics in the pic manager,
+// and free the pics that couldn't be added.
+static void MakeTex(PicManager *pm, Pic *pic, Uint32 **texData);
+static void PicLoadJobFinish(PicManager *pm, PicLoadJob *job) {
+	for (int i = 0; i < (int) job->Pics.size; i++) {
+		if (job->Added != NULL) {
+			MakeTex(pm, &job->Added[i],
+					static_cast<Uint32**>(CArrayGet(&job->TexData, i)));
+		} else {
+			Pic *pic = static_cast<Pic*>(CArrayGet(&job->Pics, i));
+			if (!PicIsNone(pic)) {
+				PicFree(pic);
+			}
+		}
+	}
+}
+// Make the pic's texture now, or queue it if textures are deferred, in which
+// case texData is taken by the pic manager
+static void PicLoaderMakeTex(Pic *pic, Uint32 *texData);
+static void MakeTex(PicManager *pm, Pic *pic, Uint32 **texData) {
+	if (pm->deferTextures) {
+		PicPendingTexture pt;
+		pt.pic = pic;
+		pt.texData = texData != NULL ? *texData : NULL;
+		CArrayPushBack(&pm->pendingTextures, &pt);
+		if (texData != NULL) {
+			*texData = NULL;
+		}
+		return;
+	}
+	PicLoaderMakeTex(pic, texData != NULL ? *texData : NULL);
+}
+static void PicLoaderMakeTex(Pic *pic, Uint32 *texData) {
+	if (pic->Data == NULL) {
 		return;
 	}
+	Uint32 *data = pic->Data;
+	if (texData != NULL) {
+		pic->Data = texData;
+	}
+	const bool ok = PicTryMakeTex(pic);
+	pic->Data = data;
+	if (!ok) {
+		PicFree(pic);
+	}
+}
+static void PicLoaderWriteCache(const PicLoader *l, const char *cachePath) {
+	// Only rewrite the cache if anything has changed
+	bool isDirty = PicCacheCount(l->Cache) != (int) l->Jobs.size;
+	CA_FOREACH(const PicLoadJob, job, l->Jobs)
+		isDirty = isDirty || !job->FromCache;
 	CA_FOREACH_END()
-
-	char *s;
-	CSTRDUP(s, buf);
-	CArrayPushBack(styleNames, &s);
+	if (!isDirty) {
+		return;
+	}
+	LOG(LM_MAIN, LL_INFO, "Writing pic cache %s", cachePath);
+	PicCacheWriter w;
+	if (!PicCacheWriterOpen(&w, cachePath)) {
+		return;
+	}
+	// No pic data has been freed or handed off yet, as no job is finished
+	CA_FOREACH(const PicLoadJob, job, l->Jobs)
+		PicCacheWriterAdd(&w, job->Path, job->Stamp, job->IsSpritesheet,
+				&job->Pics, &job->TexData);
+	CA_FOREACH_END()
+	PicCacheWriterClose(&w);
 }
-static int MaybeAdHairSpriteName(any_t data, any_t item) {
-	PicManager *pm = static_cast<PicManager*>(data);
-	MaybeAddStyleName(((const NamedSprites*) item)->name, "chars/hairs/",
-			&pm->hairstyleNames);
-	return MAP_OK;
+static void PicLoadJobTerminate(PicLoadJob *job) {
+	CA_FOREACH(Uint32 *, texData, job->TexData)
+		if (!PicCacheOwns(&gPicCache, *texData)) {
+			CFREE(*texData);
+		}
+	CA_FOREACH_END()
+	CArrayTerminate(&job->Pics);
+	CArrayTerminate(&job->TexData);
+}
+int PicManagerMakeTextures(PicManager *pm, const int max) {
+	CASSERT(!pm->deferTextures, "making textures while still deferring");
+	for (int i = 0;
+			(max <= 0 || i < max) && pm->pendingTextures.size > 0; i++) {
+		const int last = (int) pm->pendingTextures.size - 1;
+		PicPendingTexture *pt = static_cast<PicPendingTexture*>(
+				CArrayGet(&pm->pendingTextures, last));
+		PicLoaderMakeTex(pt->pic, pt->texData);
+		if (!PicCacheOwns(&gPicCache, pt->texData)) {
+			CFREE(pt->texData);
+		}
+		CArrayDelete(&pm->pendingTextures, last);
+	}
+	return (int) pm->pendingTextures.size;
+}
+static void ClearPendingTextures(PicManager *pm) {
+	CA_FOREACH(PicPendingTexture, pt, pm->pendingTextures)
+		if (!PicCacheOwns(&gPicCache, pt->texData)) {
+			CFREE(pt->texData);
+		}
+	CA_FOREACH_END()
+	CArrayClear(&pm->pendingTextures);
+}
+void PicManagerLoad(PicManager *pm) {
+	char buf[CDOGS_PATH_MAX];
+	GetDataFilePath(buf, GRAPHICS_DIR);
+	char cachePath[CDOGS_PATH_MAX];
+	strcpy(cachePath, GetConfigFilePath(PIC_CACHE_FILE));
+	PicCacheOpen(&gPicCache, cachePath);
+	LoadDirCached(pm, buf, NULL, pm->pics, pm->sprites, cachePath);
 }
-static int MaybeAddExitPicName(any_t data, any_t item) {
+
+void PicManagerBeginBulkLoad(PicManager *pm) {
+	pm->bulkLoadDepth++;
+}
+static void RebuildStyleNames(PicManager *pm);
+void PicManagerEndBulkLoad(PicManager *pm) {
+	CASSERT(pm->bulkLoadDepth > 0, "unbalanced pic manager bulk load");
+	pm->bulkLoadDepth--;
+	if (pm->bulkLoadDepth == 0) {
+		RebuildStyleNames(pm);
+	}
+}
+
+static void MaybeAddStyleName(const char *picName, const char *prefix,
+		CArray *styleNames);
+static void AddPicStyleNames(PicManager *pm, const char *name) {
 	// Exit pics should be like:
 	// exits/style/shadow
 	// where style is the style name to be stored, and
 	// shadow is normal/shadow
-	PicManager *pm = static_cast<PicManager*>(data);
-	MaybeAddStyleName(((const NamedPic*) item)->name, "exits/",
-			&pm->exitStyleNames);
-	return MAP_OK;
-}
-static int MaybeAddDoorPicName(any_t data, any_t item) {
+	MaybeAddStyleName(name, "exits/", &pm->exitStyleNames);
 	// Door pics should be like:
 	// door/style/type
 	// where style is the style name to be stored
-	PicManager *pm = static_cast<PicManager*>(data);
-	MaybeAddStyleName(((const NamedPic*) item)->name, "door/",
-			&pm->doorStyleNames);
-	return MAP_OK;
-}
-static int MaybeAddKeyPicName(any_t data, any_t item) {
+	MaybeAddStyleName(name, "door/", &pm->doorStyleNames);
 	// Key pics should be like:
 	// keys/style/colour
 	// where style is the style name to be stored, and
 	// colour is yellow/green/blue/red
 	// TODO: more colours
-	PicManager *pm = static_cast<PicManager*>(data);
-	MaybeAddStyleName(((const NamedPic*) item)->name, "keys/",
-			&pm->keyStyleNames);
-	return MAP_OK;
-}
-static int MaybeAddWallPicName(any_t data, any_t item) {
+	MaybeAddStyleName(name, "keys/", &pm->keyStyleNames);
 	// Wall pics should be like:
 	// wall/style/type
 	// where style is the style name to be stored
-	PicManager *pm = static_cast<PicManager*>(data);
-	MaybeAddStyleName(((const NamedPic*) item)->name, "wall/",
-			&pm->wallStyleNames);
-	return MAP_OK;
-}
-static int MaybeAddTilePicName(any_t data, any_t item) {
+	MaybeAddStyleName(name, "wall/", &pm->wallStyleNames);
 	// Tile pics should be like:
 	// tile/style/type
 	// where style is the style name to be stored, and
 	// type is normal/shadow/alt1/alt2
-	PicManager *pm = static_cast<PicManager*>(data);
-	MaybeAddStyleName(((const NamedPic*) item)->name, "tile/",
-			&pm->tileStyleNames);
+	MaybeAddStyleName(name, "tile/", &pm->tileStyleNames);
+}
+static void AddSpritesStyleNames(PicManager *pm, const char *name) {
+	MaybeAddStyleName(name, "chars/hairs/", &pm->hairstyleNames);
+}
+static void StylesClear(CArray *styles) {
+	CA_FOREACH(char *, styleName, *styles)
+	CFREE(*styleName);
+	CA_FOREACH_END()
+	CArrayClear(styles);
+}
+static int AddPicStyleNamesIter(any_t data, any_t item);
+static int AddSpritesStyleNamesIter(any_t data, any_t item);
+static void RebuildStyleNames(PicManager *pm) {
+	// Scan all pics for style pics
+	StylesClear(&pm->hairstyleNames);
+	StylesClear(&pm->wallStyleNames);
+	StylesClear(&pm->tileStyleNames);
+	StylesClear(&pm->exitStyleNames);
+	StylesClear(&pm->doorStyleNames);
+	StylesClear(&pm->keyStyleNames);
+	hashmap_iterate(pm->customSprites, AddSpritesStyleNamesIter, pm);
+	hashmap_iterate(pm->sprites, AddSpritesStyleNamesIter, pm);
+	hashmap_iterate(pm->customPics, AddPicStyleNamesIter, pm);
+	hashmap_iterate(pm->pics, AddPicStyleNamesIter, pm);
+}
+static int AddPicStyleNamesIter(any_t data, any_t item) {
+	AddPicStyleNames(static_cast<PicManager*>(data),
+			((const NamedPic*) item)->name);
 	return MAP_OK;
 }
+static int AddSpritesStyleNamesIter(any_t data, any_t item) {
+	AddSpritesStyleNames(static_cast<PicManager*>(data),
+			((const NamedSprites*) item)->name);
+	return MAP_OK;
+}
+static void MaybeAddStyleName(const char *picName, const char *prefix,
+		CArray *styleNames) {
+	// Look for style names within a full name of the form:
+	// prefix/style/suffix
+	// NOTE: prefix should include trailing slash
+	const size_t prefixLen = strlen(prefix);
+	if (strncmp(picName, prefix, prefixLen) != 0) {
+		return;
+	}
+	const char *nextSlash = strchr(picName + prefixLen, '/');
+	if (nextSlash == NULL) {
+		nextSlash = picName + strlen(picName);
+	}
+	char buf[CDOGS_PATH_MAX];
+	const size_t len = nextSlash - picName - prefixLen;
+	strncpy(buf, picName + prefixLen, len);
+	buf[len] = '\0';
+	// Keep the style names sorted alphabetically
+	// This prevents the list from reordering unpredictably, when the editor
+	// is used and masked pics get added
+	// Binary search for the insert position; if we already have the style
+	// name then don't add it again. This can happen if a custom pic uses the
+	// same name as a built in one, or for masked versions of style pics
+	size_t lo = 0;
+	size_t hi = styleNames->size;
+	while (lo < hi) {
+		const size_t mid = lo + (hi - lo) / 2;
+		const int cmp = strcmp(*(char**) CArrayGet(styleNames, mid), buf);
+		if (cmp == 0) {
+			return;
+		} else if (cmp < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	char *s;
+	CSTRDUP(s, buf);
+	CArrayInsert(styleNames, lo, &s);
+}
 
 // Need to free the pics and the memory since hashmap stores on heap
 static void NamedPicDestroy(any_t data);
 static void NamedSpritesDestroy(any_t data);
 void PicManagerClearCustom(PicManager *pm) {
+	// Pending textures can only be for custom pics
+	ClearPendingTextures(pm);
 	hashmap_clear(pm->customPics, NamedPicDestroy);
 	hashmap_clear(pm->customSprites, NamedSpritesDestroy);
-	AfterAdd(pm);
+	RebuildStyleNames(pm);
 }
 static void PicManagerUnload(PicManager *pm) {
+	ClearPendingTextures(pm);
 	hashmap_clear(pm->pics, NamedPicDestroy);
 	hashmap_clear(pm->sprites, NamedSpritesDestroy);
 	hashmap_clear(pm->customPics, NamedPicDestroy);
 	hashmap_clear(pm->customSprites, NamedSpritesDestroy);
-	AfterAdd(pm);
+	RebuildStyleNames(pm);
 }
 static void StyleNamesDestroy(CArray *a) {
 	CA_FOREACH(char, n, *a)
@@ -389,6 +686,9 @@ void PicManagerTerminate(PicManager *pm) {
 	StyleNamesDestroy(&pm->exitStyleNames);
 	StyleNamesDestroy(&pm->doorStyleNames);
 	StyleNamesDestroy(&pm->keyStyleNames);
+	CArrayTerminate(&pm->pendingTextures);
+	// After the pics, which may point into the cache
+	PicCacheTerminate(&gPicCache);
 	IMG_Quit();
 }
 static void NamedPicDestroy(any_t data) {
@@ -497,26 +797,19 @@ static void PicManagerGenerateMaskedPic(PicManager *pm, const char *name,
 
 	// Create the new pic by masking the original pic
 	Pic p = PicCopy(original);
-	for (int i = 0; i < p.size.x * p.size.y; i++) {
-		color_t c = PIXEL2COLOR(original->Data[i]);
+	const size_t n = p.size.x * p.size.y;
+	if (noAltMask) {
+		PixelsMult(p.Data, original->Data, n, COLOR2PIXEL(mask));
+	} else {
 		// Apply mask based on which channel each pixel is
-		if (c.g <= 2 && c.b <= 2 && !noAltMask) {
-			// Restore to white before masking
-			c.g = c.r;
-			c.b = c.r;
-			c = ColorMult(c, maskAlt);
-		} else {
-			c = ColorMult(c, mask);
-		}
-		p.Data[i] = COLOR2PIXEL(c);
+		PixelsMultAlt(p.Data, original->Data, n, GetPixelShifts(),
+				COLOR2PIXEL(mask), COLOR2PIXEL(maskAlt));
 		// TODO: more channels
 	}
-	if (!PicTryMakeTex(&p)) {
-		p.Tex = NULL;
+	NamedPic *np = AddNamedPic(pm, pm->customPics, maskedName, &p);
+	if (np != NULL) {
+		MakeTex(pm, &np->pic, NULL);
 	}
-	AddNamedPic(pm->customPics, maskedName, &p);
-
-	AfterAdd(pm);
 }
 void PicManagerGenerateMaskedStylePic(PicManager *pm, const char *name,
 		const char *style, const char *type, const color_t mask,
@@ -539,24 +832,21 @@ const NamedSprites* PicManagerGetCharSprites(PicManager *pm, const char *name,
 	if (ons == NULL) {
 		return NULL;
 	}
-	NamedSprites *nsp = AddNamedSprites(pm->customSprites, buf);
+	NamedSprites *nsp = AddNamedSprites(pm, pm->customSprites, buf);
+	uint32_t masks[PIXEL_CHAR_CHANNELS];
+	for (int i = 0; i < PIXEL_CHAR_CHANNELS; i++) {
+		masks[i] = COLOR2PIXEL(CharColorsGetChannelMask(colors, 255 - i));
+	}
 	CA_FOREACH(Pic, op, ons->pics)
 	Pic p = PicCopy(op);
 	p.Tex = NULL;
-	for (int i = 0; i < p.size.x * p.size.y; i++) {
-		if (op->Data[i] == 0) {
-			continue;
-		}
-		const color_t c = PIXEL2COLOR(op->Data[i]);
-		p.Data[i] = COLOR2PIXEL(
-				ColorMult(c, CharColorsGetChannelMask(colors, c.a)));
-	}
-	if (!PicTryMakeTex(&p)) {
-		p.Tex = NULL;
-	}
+	PixelsMultCharChannels(p.Data, op->Data, p.size.x * p.size.y,
+			GetPixelShifts(), masks);
 	CArrayPushBack(&nsp->pics, &p);
 	CA_FOREACH_END()
-	AfterAdd(pm);
+	CA_FOREACH(Pic, p, nsp->pics)
+		MakeTex(pm, p, NULL);
+	CA_FOREACH_END()
 	return nsp;
 }
 
@@ -569,7 +859,8 @@ static void GetMaskedName(char *buf, const char *name, const color_t mask,
 	sprintf(buf, "%s/%s/%s", name, maskName, maskAltName);
 }
 
-static NamedPic* AddNamedPic(map_t pics, const char *name, const Pic *p) {
+static NamedPic* AddNamedPic(PicManager *pm, map_t pics, const char *name,
+		const Pic *p) {
 	NamedPic *n;
 	CMALLOC(n, sizeof *n);
 	if (p != NULL)
@@ -581,9 +872,14 @@ static NamedPic* AddNamedPic(map_t pics, const char *name, const Pic *p) {
 		CFREE(n);
 		return NULL;
 	}
+	// Style names are rebuilt at the end of bulk loads
+	if (pm->bulkLoadDepth == 0) {
+		AddPicStyleNames(pm, name);
+	}
 	return n;
 }
-static NamedSprites* AddNamedSprites(map_t sprites, const char *name) {
+static NamedSprites* AddNamedSprites(PicManager *pm, map_t sprites,
+		const char *name) {
 	NamedSprites *ns;
 	CMALLOC(ns, sizeof *ns);
 	NamedSpritesInit(ns, name);
@@ -594,6 +890,9 @@ static NamedSprites* AddNamedSprites(map_t sprites, const char *name) {
 		CFREE(ns);
 		return NULL;
 	}
+	if (pm->bulkLoadDepth == 0) {
+		AddSpritesStyleNames(pm, name);
+	}
 	return ns;
 }
 
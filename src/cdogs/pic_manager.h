@@ -32,6 +32,11 @@
 #include "cpic.h"
 #include "pics.h"
 
+typedef struct {
+	Pic *pic;
+	Uint32 *texData;	// source data for the texture, or NULL for pic's data
+} PicPendingTexture;
+
 struct PicManager {
 	map_t pics;	// of NamedPic
 	map_t sprites;	// of NamedSprites
@@ -44,6 +49,15 @@ struct PicManager {
 	CArray exitStyleNames;	// of char *
 	CArray doorStyleNames;	// of char *
 	CArray keyStyleNames;	// of char *
+
+	// Style names are only indexed at the end of bulk loads
+	int bulkLoadDepth;
+
+	// While set, pics are loaded and generated without textures, so that
+	// this can be done off the render thread; the textures are then made
+	// with PicManagerMakeTextures on the render thread
+	bool deferTextures;
+	CArray pendingTextures;	// of PicPendingTexture
 };
 
 extern PicManager gPicManager;
@@ -52,6 +66,24 @@ void PicManagerInit(PicManager *pm);
 void PicManagerLoad(PicManager *pm);
 void PicManagerLoadDir(PicManager *pm, const char *path, const char *prefix,
 		map_t pics, map_t sprites);
+// Pics of a dir decoded without touching the pic manager, so that this can be
+// done off the render thread; they are then added with PicManagerAddDecodedDir
+typedef struct {
+	CArray Jobs;	// private
+} PicDecodedDir;
+void PicDecodedDirLoad(PicDecodedDir *d, const char *path,
+		const char *prefix);
+void PicManagerAddDecodedDir(PicManager *pm, PicDecodedDir *d, map_t pics,
+		map_t sprites);
+// Frees any pics that weren't added
+void PicDecodedDirTerminate(PicDecodedDir *d);
+// Wrap loads of many pics in these to index style names once at the end,
+// instead of after each pic
+void PicManagerBeginBulkLoad(PicManager *pm);
+void PicManagerEndBulkLoad(PicManager *pm);
+// Make up to max deferred textures, or all of them if max is 0
+// Returns the number of textures still pending
+int PicManagerMakeTextures(PicManager *pm, const int max);
 void PicManagerClearCustom(PicManager *pm);
 void PicManagerTerminate(PicManager *pm);
 void PicManagerReloadTextures(PicManager *pm);
@@ -28,6 +28,7 @@
 #include "pickup.h"
 
 #include "ammo.h"
+#include "asset_pack.h"
 #include "game_events.h"
 #include "json_utils.h"
 #include "log.h"
@@ -133,7 +134,7 @@ void PickupClassesInit(PickupClasses *classes, const char *filename,
 
 	char buf[CDOGS_PATH_MAX];
 	GetDataFilePath(buf, filename);
-	FILE *f = fopen(buf, "r");
+	FILE *f = AssetFOpen(buf, "r");
 	json_t *root = NULL;
 	enum json_error e;
 	if (f == NULL) {
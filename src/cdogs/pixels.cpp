@@ -0,0 +1,286 @@
+/*
+ C-Dogs SDL
+ A port of the legendary (and fun) action/arcade cdogs.
+
+ Copyright (c) 2020 Cong Xu
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "pixels.h"
+
+#include "utils.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PIXELS_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PIXELS_NEON
+#include <arm_neon.h>
+#endif
+
+// Exact c * m / 255 for each 8-bit component
+static uint32_t PixelMult(const uint32_t p, const uint32_t m) {
+	uint32_t out = 0;
+	for (int shift = 0; shift < 32; shift += 8) {
+		const uint32_t c = (p >> shift) & 0xff;
+		const uint32_t cm = (m >> shift) & 0xff;
+		out |= (c * cm / 255) << shift;
+	}
+	return out;
+}
+static bool PixelIsAlt(const uint32_t p, const PixelShifts s) {
+	return ((p >> s.G) & 0xff) <= 2 && ((p >> s.B) & 0xff) <= 2;
+}
+// Copy the red component into green and blue
+static uint32_t PixelRedToGrey(const uint32_t p, const PixelShifts s) {
+	const uint32_t r = (p >> s.R) & 0xff;
+	const uint32_t gb = (0xffu << s.G) | (0xffu << s.B);
+	return (p & ~gb) | (r << s.G) | (r << s.B);
+}
+static uint32_t PixelCharChannelMask(const uint32_t p, const PixelShifts s,
+		const uint32_t masks[PIXEL_CHAR_CHANNELS]) {
+	const uint32_t a = (p >> s.A) & 0xff;
+	if (a < 256 - PIXEL_CHAR_CHANNELS) {
+		return 0xffffffff;
+	}
+	return masks[255 - a];
+}
+
+void PixelsMultScalar(uint32_t *dst, const uint32_t *src, const size_t n,
+		const uint32_t mask) {
+	for (size_t i = 0; i < n; i++) {
+		dst[i] = PixelMult(src[i], mask);
+	}
+}
+void PixelsMultAltScalar(uint32_t *dst, const uint32_t *src, const size_t n,
+		const PixelShifts s, const uint32_t mask, const uint32_t maskAlt) {
+	for (size_t i = 0; i < n; i++) {
+		if (PixelIsAlt(src[i], s)) {
+			dst[i] = PixelMult(PixelRedToGrey(src[i], s), maskAlt);
+		} else {
+			dst[i] = PixelMult(src[i], mask);
+		}
+	}
+}
+void PixelsMultCharChannelsScalar(uint32_t *dst, const uint32_t *src,
+		const size_t n, const PixelShifts s,
+		const uint32_t masks[PIXEL_CHAR_CHANNELS]) {
+	for (size_t i = 0; i < n; i++) {
+		dst[i] = PixelMult(src[i], PixelCharChannelMask(src[i], s, masks));
+	}
+}
+
+#if defined(PIXELS_SSE2)
+// Multiply 4 pixels at once, using 16-bit intermediates
+// x / 255 == (x + 1 + ((x + 1) >> 8)) >> 8 for all 8-bit products
+static __m128i Mult4(const __m128i p, const __m128i m) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi16(1);
+	__m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(p, zero),
+			_mm_unpacklo_epi8(m, zero));
+	__m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(p, zero),
+			_mm_unpackhi_epi8(m, zero));
+	lo = _mm_add_epi16(lo, one);
+	hi = _mm_add_epi16(hi, one);
+	lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+	hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+	return _mm_packus_epi16(lo, hi);
+}
+static __m128i Select4(const __m128i sel, const __m128i a, const __m128i b) {
+	return _mm_or_si128(_mm_and_si128(sel, a), _mm_andnot_si128(sel, b));
+}
+#elif defined(PIXELS_NEON)
+static uint32x4_t Mult4(const uint32x4_t p, const uint32x4_t m) {
+	const uint8x16_t p8 = vreinterpretq_u8_u32(p);
+	const uint8x16_t m8 = vreinterpretq_u8_u32(m);
+	const uint16x8_t one = vdupq_n_u16(1);
+	uint16x8_t lo = vaddq_u16(vmull_u8(vget_low_u8(p8), vget_low_u8(m8)), one);
+	uint16x8_t hi = vaddq_u16(
+			vmull_u8(vget_high_u8(p8), vget_high_u8(m8)), one);
+	lo = vsraq_n_u16(lo, lo, 8);
+	hi = vsraq_n_u16(hi, hi, 8);
+	return vreinterpretq_u32_u8(
+			vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8)));
+}
+#endif
+
+void PixelsMult(uint32_t *dst, const uint32_t *src, const size_t n,
+		const uint32_t mask) {
+	size_t i = 0;
+#if defined(PIXELS_SSE2)
+	const __m128i m = _mm_set1_epi32((int) mask);
+	for (; i + 4 <= n; i += 4) {
+		const __m128i p = _mm_loadu_si128((const __m128i*) (src + i));
+		_mm_storeu_si128((__m128i*) (dst + i), Mult4(p, m));
+	}
+#elif defined(PIXELS_NEON)
+	const uint32x4_t m = vdupq_n_u32(mask);
+	for (; i + 4 <= n; i += 4) {
+		vst1q_u32(dst + i, Mult4(vld1q_u32(src + i), m));
+	}
+#endif
+	PixelsMultScalar(dst + i, src + i, n - i, mask);
+}
+
+void PixelsMultAlt(uint32_t *dst, const uint32_t *src, const size_t n,
+		const PixelShifts s, const uint32_t mask, const uint32_t maskAlt) {
+	size_t i = 0;
+	const uint32_t gbBits = (0xffu << s.G) | (0xffu << s.B);
+#if defined(PIXELS_SSE2)
+	const __m128i m = _mm_set1_epi32((int) mask);
+	const __m128i mAlt = _mm_set1_epi32((int) maskAlt);
+	const __m128i gb = _mm_set1_epi32((int) gbBits);
+	const __m128i two = _mm_set1_epi8(2);
+	const __m128i byteMask = _mm_set1_epi32(0xff);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i rShift = _mm_cvtsi32_si128(s.R);
+	const __m128i gShift = _mm_cvtsi32_si128(s.G);
+	const __m128i bShift = _mm_cvtsi32_si128(s.B);
+	for (; i + 4 <= n; i += 4) {
+		const __m128i p = _mm_loadu_si128((const __m128i*) (src + i));
+		// Alt pixels have green and blue components <= 2
+		const __m128i isAlt = _mm_cmpeq_epi32(
+				_mm_and_si128(_mm_subs_epu8(p, two), gb), zero);
+		const __m128i r = _mm_and_si128(_mm_srl_epi32(p, rShift), byteMask);
+		const __m128i grey = _mm_or_si128(_mm_andnot_si128(gb, p),
+				_mm_or_si128(_mm_sll_epi32(r, gShift), _mm_sll_epi32(r, bShift)));
+		const __m128i out = Mult4(Select4(isAlt, grey, p),
+				Select4(isAlt, mAlt, m));
+		_mm_storeu_si128((__m128i*) (dst + i), out);
+	}
+#elif defined(PIXELS_NEON)
+	const uint32x4_t m = vdupq_n_u32(mask);
+	const uint32x4_t mAlt = vdupq_n_u32(maskAlt);
+	const uint32x4_t gb = vdupq_n_u32(gbBits);
+	const uint8x16_t two = vdupq_n_u8(2);
+	const uint32x4_t byteMask = vdupq_n_u32(0xff);
+	const int32x4_t rShift = vdupq_n_s32(-(int) s.R);
+	const int32x4_t gShift = vdupq_n_s32(s.G);
+	const int32x4_t bShift = vdupq_n_s32(s.B);
+	for (; i + 4 <= n; i += 4) {
+		const uint32x4_t p = vld1q_u32(src + i);
+		const uint32x4_t sub = vreinterpretq_u32_u8(
+				vqsubq_u8(vreinterpretq_u8_u32(p), two));
+		const uint32x4_t isAlt = vceqq_u32(vandq_u32(sub, gb), vdupq_n_u32(0));
+		const uint32x4_t r = vandq_u32(vshlq_u32(p, rShift), byteMask);
+		const uint32x4_t grey = vorrq_u32(vbicq_u32(p, gb),
+				vorrq_u32(vshlq_u32(r, gShift), vshlq_u32(r, bShift)));
+		vst1q_u32(dst + i,
+				Mult4(vbslq_u32(isAlt, grey, p), vbslq_u32(isAlt, mAlt, m)));
+	}
+#else
+	(void) gbBits;
+#endif
+	PixelsMultAltScalar(dst + i, src + i, n - i, s, mask, maskAlt);
+}
+
+void PixelsMultCharChannels(uint32_t *dst, const uint32_t *src,
+		const size_t n, const PixelShifts s,
+		const uint32_t masks[PIXEL_CHAR_CHANNELS]) {
+	size_t i = 0;
+#if defined(PIXELS_SSE2)
+	__m128i channelMasks[PIXEL_CHAR_CHANNELS];
+	__m128i channelAlphas[PIXEL_CHAR_CHANNELS];
+	for (int c = 0; c < PIXEL_CHAR_CHANNELS; c++) {
+		channelMasks[c] = _mm_set1_epi32((int) masks[c]);
+		channelAlphas[c] = _mm_set1_epi32(255 - c);
+	}
+	const __m128i byteMask = _mm_set1_epi32(0xff);
+	const __m128i aShift = _mm_cvtsi32_si128(s.A);
+	for (; i + 4 <= n; i += 4) {
+		const __m128i p = _mm_loadu_si128((const __m128i*) (src + i));
+		const __m128i a = _mm_and_si128(_mm_srl_epi32(p, aShift), byteMask);
+		// Unknown channels are left unmasked
+		__m128i m = _mm_set1_epi32(-1);
+		for (int c = 0; c < PIXEL_CHAR_CHANNELS; c++) {
+			m = Select4(_mm_cmpeq_epi32(a, channelAlphas[c]), channelMasks[c],
+					m);
+		}
+		_mm_storeu_si128((__m128i*) (dst + i), Mult4(p, m));
+	}
+#elif defined(PIXELS_NEON)
+	uint32x4_t channelMasks[PIXEL_CHAR_CHANNELS];
+	uint32x4_t channelAlphas[PIXEL_CHAR_CHANNELS];
+	for (int c = 0; c < PIXEL_CHAR_CHANNELS; c++) {
+		channelMasks[c] = vdupq_n_u32(masks[c]);
+		channelAlphas[c] = vdupq_n_u32(255 - c);
+	}
+	const uint32x4_t byteMask = vdupq_n_u32(0xff);
+	const int32x4_t aShift = vdupq_n_s32(-(int) s.A);
+	for (; i + 4 <= n; i += 4) {
+		const uint32x4_t p = vld1q_u32(src + i);
+		const uint32x4_t a = vandq_u32(vshlq_u32(p, aShift), byteMask);
+		// Unknown channels are left unmasked
+		uint32x4_t m = vdupq_n_u32(0xffffffff);
+		for (int c = 0; c < PIXEL_CHAR_CHANNELS; c++) {
+			m = vbslq_u32(vceqq_u32(a, channelAlphas[c]), channelMasks[c], m);
+		}
+		vst1q_u32(dst + i, Mult4(p, m));
+	}
+#endif
+	PixelsMultCharChannelsScalar(dst + i, src + i, n - i, s, masks);
+}
+
+static int AbsDiff(const int a, const int b) {
+	return a > b ? a - b : b - a;
+}
+void PixelsToCharChannels(uint32_t *pixels, const size_t n,
+		const PixelShifts s) {
+	for (size_t i = 0; i < n; i++) {
+		const uint32_t p = pixels[i];
+		// Don't bother if the alpha has already been modified; it
+		// means we have already processed this pixel
+		if (((p >> s.A) & 0xff) != 255) {
+			continue;
+		}
+		const int r = (p >> s.R) & 0xff;
+		const int g = (p >> s.G) & 0xff;
+		const int b = (p >> s.B) & 0xff;
+		uint32_t alpha;
+		if (AbsDiff(r, g) < 5 && AbsDiff(g, b) < 5) {
+			// don't convert greyscale colours
+			continue;
+		} else if ((g < 5 && b < 5) || (AbsDiff(g, b) < 5 && r > 250)) {
+			// Skin
+			alpha = 254;
+		} else if ((r < 5 && b < 5) || (AbsDiff(r, b) < 5 && g > 250)) {
+			// Hair
+			alpha = 250;
+		} else if ((r < 5 && g < 5) || (AbsDiff(r, g) < 5 && b > 250)) {
+			// Arms
+			alpha = 253;
+		} else if (b < 5 || (r > 250 && g > 250)) {
+			// Body
+			alpha = 252;
+		} else if (r < 5 || (g > 250 && b > 250)) {
+			// Legs
+			alpha = 251;
+		} else {
+			continue;
+		}
+		const uint32_t value = (uint32_t) MAX(MAX(r, g), b);
+		pixels[i] = (value << s.R) | (value << s.G) | (value << s.B)
+				| (alpha << s.A);
+	}
+}
@@ -0,0 +1,75 @@
+/*
+ C-Dogs SDL
+ A port of the legendary (and fun) action/arcade cdogs.
+
+ Copyright (c) 2020 Cong Xu
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Colour masking over packed 32-bit pixels, used to generate masked pics
+// Uses SSE2 or NEON where available, otherwise plain C
+// All variants produce the same output as ColorMult on each pixel
+
+// Bit positions of each channel within a pixel
+typedef struct {
+	uint8_t R;
+	uint8_t G;
+	uint8_t B;
+	uint8_t A;
+} PixelShifts;
+
+// Number of char sprite channels, stored in the alpha component:
+// 255 white (unmasked), 254 skin, 253 arms, 252 body, 251 legs, 250 hair
+#define PIXEL_CHAR_CHANNELS 6
+
+// dst = src * mask
+void PixelsMult(uint32_t *dst, const uint32_t *src, const size_t n,
+		const uint32_t mask);
+// As PixelsMult, but pixels that only have red (green and blue <= 2) are
+// restored to grey and multiplied by maskAlt instead
+void PixelsMultAlt(uint32_t *dst, const uint32_t *src, const size_t n,
+		const PixelShifts s, const uint32_t mask, const uint32_t maskAlt);
+// Multiply each pixel by the mask selected by its alpha channel
+// masks are ordered by alpha, from 255 down to 250; unknown alphas are left
+// as they are
+void PixelsMultCharChannels(uint32_t *dst, const uint32_t *src,
+		const size_t n, const PixelShifts s,
+		const uint32_t masks[PIXEL_CHAR_CHANNELS]);
+// Convert pure-coloured char pics to the multichannel greyscale version,
+// where the alpha identifies the channel
+void PixelsToCharChannels(uint32_t *pixels, const size_t n,
+		const PixelShifts s);
+
+// Plain C versions, for reference
+void PixelsMultScalar(uint32_t *dst, const uint32_t *src, const size_t n,
+		const uint32_t mask);
+void PixelsMultAltScalar(uint32_t *dst, const uint32_t *src, const size_t n,
+		const PixelShifts s, const uint32_t mask, const uint32_t maskAlt);
+void PixelsMultCharChannelsScalar(uint32_t *dst, const uint32_t *src,
+		const size_t n, const PixelShifts s,
+		const uint32_t masks[PIXEL_CHAR_CHANNELS]);
@@ -177,8 +177,8 @@ PB_FIELD( 2, INT32 , REQUIRED, STATIC , OTHER, NVec2i, y, x, 0),
 PB_LAST_FIELD };
 
 const pb_field_t NVec2_fields[3] = {
-PB_FIELD( 1, FLOAT , REQUIRED, STATIC , FIRST, NVec2, x, x, 0),
-PB_FIELD( 2, FLOAT , REQUIRED, STATIC , OTHER, NVec2, y, x, 0),
+PB_FIELD( 1, SINT32 , REQUIRED, STATIC , FIRST, NVec2, x, x, 0),
+PB_FIELD( 2, SINT32 , REQUIRED, STATIC , OTHER, NVec2, y, x, 0),
 PB_LAST_FIELD };
 
 const pb_field_t NGameBegin_fields[2] = {
@@ -200,12 +200,13 @@ PB_FIELD( 4, INT32 , REQUIRED, STATIC , OTHER, NActorAdd, Health, Direction, 0),
 				ThingFlags, &NVec2_fields),
 PB_LAST_FIELD };
 
-const pb_field_t NActorMove_fields[4] = {
+const pb_field_t NActorMove_fields[5] = {
 PB_FIELD( 1, UINT32 , REQUIRED, STATIC , FIRST, NActorMove, UID, UID, 0),
 		PB_FIELD(2, MESSAGE, REQUIRED, STATIC, OTHER, NActorMove, Pos, UID,
 				&NVec2_fields),
 		PB_FIELD(3, MESSAGE, REQUIRED, STATIC, OTHER, NActorMove, MoveVel, Pos,
 				&NVec2_fields),
+PB_FIELD( 4, UINT32 , REQUIRED, STATIC , OTHER, NActorMove, Seq, MoveVel, 0),
 PB_LAST_FIELD };
 
 const pb_field_t NActorState_fields[3] = {
@@ -356,7 +357,7 @@ PB_FIELD( 2, STRING , REQUIRED, STATIC , OTHER, NGunFire, Gun, ActorUID, 0),
 		PB_FIELD(3, MESSAGE, REQUIRED, STATIC, OTHER, NGunFire, MuzzlePos, Gun,
 				&NVec2_fields),
 PB_FIELD( 4, INT32 , REQUIRED, STATIC , OTHER, NGunFire, Z, MuzzlePos, 0),
-PB_FIELD( 5, FLOAT , REQUIRED, STATIC , OTHER, NGunFire, Angle, Z, 0),
+PB_FIELD( 5, UINT32 , REQUIRED, STATIC , OTHER, NGunFire, Angle, Z, 0),
 PB_FIELD( 6, BOOL , REQUIRED, STATIC , OTHER, NGunFire, Sound, Angle, 0),
 PB_FIELD( 7, UINT32 , REQUIRED, STATIC , OTHER, NGunFire, Flags, Sound, 0),
 PB_FIELD( 8, BOOL , REQUIRED, STATIC , OTHER, NGunFire, IsGun, Flags, 0),
@@ -376,7 +377,7 @@ PB_FIELD( 1, UINT32 , REQUIRED, STATIC , FIRST, NAddBullet, UID, UID, 0),
 						MuzzlePos, BulletClass, &NVec2_fields),
 				PB_FIELD(4, INT32, REQUIRED, STATIC, OTHER, NAddBullet,
 						MuzzleHeight, MuzzlePos, 0),
-				PB_FIELD(5, FLOAT, REQUIRED, STATIC, OTHER, NAddBullet, Angle,
+				PB_FIELD(5, UINT32, REQUIRED, STATIC, OTHER, NAddBullet, Angle,
 						MuzzleHeight, 0),
 				PB_FIELD(6, INT32, REQUIRED, STATIC, OTHER, NAddBullet,
 						Elevation, Angle, 0),
@@ -436,6 +437,35 @@ PB_FIELD( 2, BOOL , REQUIRED, STATIC , OTHER, NMissionEnd, IsQuit, Delay, 0),
 PB_FIELD( 3, STRING , REQUIRED, STATIC , OTHER, NMissionEnd, Msg, IsQuit, 0),
 PB_LAST_FIELD };
 
+const pb_field_t NActorSnapshot_fields[6] = {
+PB_FIELD( 1, UINT32 , REQUIRED, STATIC , FIRST, NActorSnapshot, UID, UID, 0),
+		PB_FIELD(2, MESSAGE, OPTIONAL, STATIC, OTHER, NActorSnapshot, Pos, UID,
+				&NVec2_fields),
+		PB_FIELD(3, MESSAGE, OPTIONAL, STATIC, OTHER, NActorSnapshot, MoveVel,
+				Pos, &NVec2_fields),
+PB_FIELD( 4, INT32 , OPTIONAL, STATIC , OTHER, NActorSnapshot, Dir, MoveVel, 0),
+PB_FIELD( 5, UINT32 , OPTIONAL, STATIC , OTHER, NActorSnapshot, InputSeq, Dir, 0),
+PB_LAST_FIELD };
+
+const pb_field_t NSnapshot_fields[6] = {
+PB_FIELD( 1, UINT32 , REQUIRED, STATIC , FIRST, NSnapshot, Seq, Seq, 0),
+PB_FIELD( 2, UINT32 , REQUIRED, STATIC , OTHER, NSnapshot, BaseSeq, Seq, 0),
+PB_FIELD( 3, UINT32 , REQUIRED, STATIC , OTHER, NSnapshot, Part, BaseSeq, 0),
+PB_FIELD( 4, UINT32 , REQUIRED, STATIC , OTHER, NSnapshot, Parts, Part, 0),
+		PB_FIELD(5, MESSAGE, REPEATED, STATIC, OTHER, NSnapshot, Actors, Parts,
+				&NActorSnapshot_fields),
+PB_LAST_FIELD };
+
+const pb_field_t NSnapshotAck_fields[2] = {
+PB_FIELD( 1, UINT32 , REQUIRED, STATIC , FIRST, NSnapshotAck, Seq, Seq, 0),
+PB_LAST_FIELD };
+
+const pb_field_t NJoinChunk_fields[4] = {
+PB_FIELD( 1, UINT32 , REQUIRED, STATIC , FIRST, NJoinChunk, Offset, Offset, 0),
+PB_FIELD( 2, UINT32 , REQUIRED, STATIC , OTHER, NJoinChunk, Total, Offset, 0),
+PB_FIELD( 3, BYTES  , REQUIRED, STATIC , OTHER, NJoinChunk, Data, Total, 0),
+PB_LAST_FIELD };
+
 /* Check that field information fits in pb_field_t */
 #if !defined(PB_FIELD_32BIT)
 /* If you get an error here, it means that you need to define PB_FIELD_32BIT
@@ -446,8 +476,8 @@ PB_LAST_FIELD };
  * field descriptors.
  */
 PB_STATIC_ASSERT(
-		(pb_membersize(NCharColors, Skin) < 65536 && pb_membersize(NCharColors, Arms) < 65536 && pb_membersize(NCharColors, Body) < 65536 && pb_membersize(NCharColors, Legs) < 65536 && pb_membersize(NCharColors, Hair) < 65536 && pb_membersize(NPlayerData, Colors) < 65536 && pb_membersize(NPlayerData, Stats) < 65536 && pb_membersize(NPlayerData, Totals) < 65536 && pb_membersize(NTileSet, Pos) < 65536 && pb_membersize(NThingDamage, Vel) < 65536 && pb_membersize(NMapObjectAdd, Pos) < 65536 && pb_membersize(NMapObjectAdd, Mask) < 65536 && pb_membersize(NSound, Pos) < 65536 && pb_membersize(NActorAdd, Pos) < 65536 && pb_membersize(NActorMove, Pos) < 65536 && pb_membersize(NActorMove, MoveVel) < 65536 && pb_membersize(NActorSlide, Vel) < 65536 && pb_membersize(NActorImpulse, Vel) < 65536 && pb_membersize(NActorImpulse, Pos) < 65536 && pb_membersize(NAddPickup, Pos) < 65536 && pb_membersize(NBulletBounce, BouncePos) < 65536 && pb_membersize(NBulletBounce, Pos) < 65536 && pb_membersize(NBulletBounce, Vel) < 65536 && pb_membersize(NGunReload, Pos) < 65536 && pb_membersize(NGunFire, MuzzlePos) < 65536 && pb_membersize(NAddBullet, MuzzlePos) < 65536 && pb_membersize(NTrigger, Tile) < 65536 && pb_membersize(NExploreTiles, Runs[0]) < 65536 && pb_membersize(NExploreTiles_Run, Tile) < 65536 && pb_membersize(NAddKeys, Pos) < 65536 && pb_membersize(NMissionComplete, ExitStart) < 65536 && pb_membersize(NMissionComplete, ExitEnd) < 65536),
-		YOU_MUST_DEFINE_PB_FIELD_32BIT_FOR_MESSAGES_NServerInfo_NClientId_NCampaignDef_NColor_NCharColors_NPlayerStats_NPlayerData_NPlayerRemove_NConfig_NTileSet_NThingDamage_NMapObjectAdd_NMapObjectRemove_NScore_NSound_NVec2i_NVec2_NGameBegin_NActorAdd_NActorMove_NActorState_NActorDir_NActorSlide_NActorImpulse_NActorSwitchGun_NActorPickupAll_NActorReplaceGun_NActorHeal_NActorAddAmmo_NActorUseAmmo_NActorDie_NActorMelee_NAddPickup_NRemovePickup_NBulletBounce_NRemoveBullet_NGunReload_NGunFire_NGunState_NAddBullet_NTrigger_NExploreTiles_NExploreTiles_Run_NRescueCharacter_NObjectiveUpdate_NAddKeys_NMissionComplete_NMissionEnd)
+		(pb_membersize(NCharColors, Skin) < 65536 && pb_membersize(NCharColors, Arms) < 65536 && pb_membersize(NCharColors, Body) < 65536 && pb_membersize(NCharColors, Legs) < 65536 && pb_membersize(NCharColors, Hair) < 65536 && pb_membersize(NPlayerData, Colors) < 65536 && pb_membersize(NPlayerData, Stats) < 65536 && pb_membersize(NPlayerData, Totals) < 65536 && pb_membersize(NTileSet, Pos) < 65536 && pb_membersize(NThingDamage, Vel) < 65536 && pb_membersize(NMapObjectAdd, Pos) < 65536 && pb_membersize(NMapObjectAdd, Mask) < 65536 && pb_membersize(NSound, Pos) < 65536 && pb_membersize(NActorAdd, Pos) < 65536 && pb_membersize(NActorMove, Pos) < 65536 && pb_membersize(NActorMove, MoveVel) < 65536 && pb_membersize(NActorSlide, Vel) < 65536 && pb_membersize(NActorImpulse, Vel) < 65536 && pb_membersize(NActorImpulse, Pos) < 65536 && pb_membersize(NAddPickup, Pos) < 65536 && pb_membersize(NBulletBounce, BouncePos) < 65536 && pb_membersize(NBulletBounce, Pos) < 65536 && pb_membersize(NBulletBounce, Vel) < 65536 && pb_membersize(NGunReload, Pos) < 65536 && pb_membersize(NGunFire, MuzzlePos) < 65536 && pb_membersize(NAddBullet, MuzzlePos) < 65536 && pb_membersize(NTrigger, Tile) < 65536 && pb_membersize(NExploreTiles, Runs[0]) < 65536 && pb_membersize(NExploreTiles_Run, Tile) < 65536 && pb_membersize(NAddKeys, Pos) < 65536 && pb_membersize(NMissionComplete, ExitStart) < 65536 && pb_membersize(NMissionComplete, ExitEnd) < 65536 && pb_membersize(NActorSnapshot, Pos) < 65536 && pb_membersize(NActorSnapshot, MoveVel) < 65536 && pb_membersize(NSnapshot, Actors[0]) < 65536 && pb_membersize(NJoinChunk, Data) < 65536),
+		YOU_MUST_DEFINE_PB_FIELD_32BIT_FOR_MESSAGES_NServerInfo_NClientId_NCampaignDef_NColor_NCharColors_NPlayerStats_NPlayerData_NPlayerRemove_NConfig_NTileSet_NThingDamage_NMapObjectAdd_NMapObjectRemove_NScore_NSound_NVec2i_NVec2_NGameBegin_NActorAdd_NActorMove_NActorState_NActorDir_NActorSlide_NActorImpulse_NActorSwitchGun_NActorPickupAll_NActorReplaceGun_NActorHeal_NActorAddAmmo_NActorUseAmmo_NActorDie_NActorMelee_NAddPickup_NRemovePickup_NBulletBounce_NRemoveBullet_NGunReload_NGunFire_NGunState_NAddBullet_NTrigger_NExploreTiles_NExploreTiles_Run_NRescueCharacter_NObjectiveUpdate_NAddKeys_NMissionComplete_NMissionEnd_NActorSnapshot_NSnapshot_NSnapshotAck_NJoinChunk)
 #endif
 
 #if !defined(PB_FIELD_16BIT) && !defined(PB_FIELD_32BIT)
@@ -120,6 +120,14 @@ typedef struct _NGunState {
 	/* @@protoc_insertion_point(struct:NGunState) */
 } NGunState;
 
+typedef PB_BYTES_ARRAY_T(1024) NJoinChunk_Data_t;
+typedef struct _NJoinChunk {
+	uint32_t Offset;
+	uint32_t Total;
+	NJoinChunk_Data_t Data;
+	/* @@protoc_insertion_point(struct:NJoinChunk) */
+} NJoinChunk;
+
 typedef struct _NMapObjectRemove {
 	uint32_t UID;
 	int32_t ActorUID;
@@ -187,9 +195,14 @@ typedef struct _NServerInfo {
 	/* @@protoc_insertion_point(struct:NServerInfo) */
 } NServerInfo;
 
+typedef struct _NSnapshotAck {
+	uint32_t Seq;
+	/* @@protoc_insertion_point(struct:NSnapshotAck) */
+} NSnapshotAck;
+
 typedef struct _NVec2 {
-	float x;
-	float y;
+	int32_t x;
+	int32_t y;
 	/* @@protoc_insertion_point(struct:NVec2) */
 } NVec2;
 
@@ -221,6 +234,7 @@ typedef struct _NActorMove {
 	uint32_t UID;
 	NVec2 Pos;
 	NVec2 MoveVel;
+	uint32_t Seq;
 	/* @@protoc_insertion_point(struct:NActorMove) */
 } NActorMove;
 
@@ -230,12 +244,25 @@ typedef struct _NActorSlide {
 	/* @@protoc_insertion_point(struct:NActorSlide) */
 } NActorSlide;
 
+typedef struct _NActorSnapshot {
+	uint32_t UID;
+	bool has_Pos;
+	NVec2 Pos;
+	bool has_MoveVel;
+	NVec2 MoveVel;
+	bool has_Dir;
+	int32_t Dir;
+	bool has_InputSeq;
+	uint32_t InputSeq;
+	/* @@protoc_insertion_point(struct:NActorSnapshot) */
+} NActorSnapshot;
+
 typedef struct _NAddBullet {
 	uint32_t UID;
 	char BulletClass[128];
 	NVec2 MuzzlePos;
 	int32_t MuzzleHeight;
-	float Angle;
+	uint32_t Angle;
 	int32_t Elevation;
 	uint32_t Flags;
 	int32_t ActorUID;
@@ -290,7 +317,7 @@ typedef struct _NGunFire {
 	char Gun[128];
 	NVec2 MuzzlePos;
 	int32_t Z;
-	float Angle;
+	uint32_t Angle;
 	bool Sound;
 	uint32_t Flags;
 	bool IsGun;
@@ -377,6 +404,16 @@ typedef struct _NPlayerData {
 	/* @@protoc_insertion_point(struct:NPlayerData) */
 } NPlayerData;
 
+typedef struct _NSnapshot {
+	uint32_t Seq;
+	uint32_t BaseSeq;
+	uint32_t Part;
+	uint32_t Parts;
+	pb_size_t Actors_count;
+	NActorSnapshot Actors[16];
+	/* @@protoc_insertion_point(struct:NSnapshot) */
+} NSnapshot;
+
 /* Default values for struct fields */
 extern const int32_t NThingDamage_SourceActorUID_default;
 extern const int32_t NActorAdd_Direction_default;
@@ -410,7 +447,7 @@ extern const int32_t NAddBullet_ActorUID_default;
 #define NVec2_init_default                       {0, 0}
 #define NGameBegin_init_default                  {0}
 #define NActorAdd_init_default                   {0, 0, 4, 0, -1, 0, NVec2_init_default}
-#define NActorMove_init_default                  {0, NVec2_init_default, NVec2_init_default}
+#define NActorMove_init_default                  {0, NVec2_init_default, NVec2_init_default, 0}
 #define NActorState_init_default                 {0, 0}
 #define NActorDir_init_default                   {0, 0}
 #define NActorSlide_init_default                 {0, NVec2_init_default}
@@ -439,6 +476,10 @@ extern const int32_t NAddBullet_ActorUID_default;
 #define NAddKeys_init_default                    {0, NVec2_init_default}
 #define NMissionComplete_init_default            {0, NVec2i_init_default, NVec2i_init_default}
 #define NMissionEnd_init_default                 {0, 0, ""}
+#define NActorSnapshot_init_default              {0, false, NVec2_init_default, false, NVec2_init_default, false, 0, false, 0}
+#define NSnapshot_init_default                   {0, 0, 0, 0, 0, {NActorSnapshot_init_default, NActorSnapshot_init_default, NActorSnapshot_init_default, NActorSnapshot_init_default, NActorSnapshot_init_default, NActorSnapshot_init_default, NActorSnapshot_init_default, NActorSnapshot_init_default, NActorSnapshot_init_default, NActorSnapshot_init_default, NActorSnapshot_init_default, NActorSnapshot_init_default, NActorSnapshot_init_default, NActorSnapshot_init_default, NActorSnapshot_init_default, NActorSnapshot_init_default}}
+#define NSnapshotAck_init_default                {0}
+#define NJoinChunk_init_default                  {0, 0, {0, {0}}}
 #define NServerInfo_init_zero                    {0, 0, "", 0, "", 0, 0, 0}
 #define NClientId_init_zero                      {0, 0}
 #define NCampaignDef_init_zero                   {"", 0, 0}
@@ -458,7 +499,7 @@ extern const int32_t NAddBullet_ActorUID_default;
 #define NVec2_init_zero                          {0, 0}
 #define NGameBegin_init_zero                     {0}
 #define NActorAdd_init_zero                      {0, 0, 0, 0, 0, 0, NVec2_init_zero}
-#define NActorMove_init_zero                     {0, NVec2_init_zero, NVec2_init_zero}
+#define NActorMove_init_zero                     {0, NVec2_init_zero, NVec2_init_zero, 0}
 #define NActorState_init_zero                    {0, 0}
 #define NActorDir_init_zero                      {0, 0}
 #define NActorSlide_init_zero                    {0, NVec2_init_zero}
@@ -487,6 +528,10 @@ extern const int32_t NAddBullet_ActorUID_default;
 #define NAddKeys_init_zero                       {0, NVec2_init_zero}
 #define NMissionComplete_init_zero               {0, NVec2i_init_zero, NVec2i_init_zero}
 #define NMissionEnd_init_zero                    {0, 0, ""}
+#define NActorSnapshot_init_zero                 {0, false, NVec2_init_zero, false, NVec2_init_zero, false, 0, false, 0}
+#define NSnapshot_init_zero                      {0, 0, 0, 0, 0, {NActorSnapshot_init_zero, NActorSnapshot_init_zero, NActorSnapshot_init_zero, NActorSnapshot_init_zero, NActorSnapshot_init_zero, NActorSnapshot_init_zero, NActorSnapshot_init_zero, NActorSnapshot_init_zero, NActorSnapshot_init_zero, NActorSnapshot_init_zero, NActorSnapshot_init_zero, NActorSnapshot_init_zero, NActorSnapshot_init_zero, NActorSnapshot_init_zero, NActorSnapshot_init_zero, NActorSnapshot_init_zero}}
+#define NSnapshotAck_init_zero                   {0}
+#define NJoinChunk_init_zero                     {0, 0, {0, {0}}}
 
 /* Field tags (for use in manual encoding/decoding) */
 #define NActorAddAmmo_UID_tag                    1
@@ -530,6 +575,9 @@ extern const int32_t NAddBullet_ActorUID_default;
 #define NGameBegin_MissionTime_tag               1
 #define NGunState_ActorUID_tag                   1
 #define NGunState_State_tag                      2
+#define NJoinChunk_Offset_tag                    1
+#define NJoinChunk_Total_tag                     2
+#define NJoinChunk_Data_tag                      3
 #define NMapObjectRemove_UID_tag                 1
 #define NMapObjectRemove_ActorUID_tag            2
 #define NMapObjectRemove_Flags_tag               3
@@ -557,6 +605,7 @@ extern const int32_t NAddBullet_ActorUID_default;
 #define NServerInfo_MissionNumber_tag            6
 #define NServerInfo_NumPlayers_tag               7
 #define NServerInfo_MaxPlayers_tag               8
+#define NSnapshotAck_Seq_tag                     1
 #define NVec2_x_tag                              1
 #define NVec2_y_tag                              2
 #define NVec2i_x_tag                             1
@@ -574,8 +623,14 @@ extern const int32_t NAddBullet_ActorUID_default;
 #define NActorMove_UID_tag                       1
 #define NActorMove_Pos_tag                       2
 #define NActorMove_MoveVel_tag                   3
+#define NActorMove_Seq_tag                       4
 #define NActorSlide_UID_tag                      1
 #define NActorSlide_Vel_tag                      2
+#define NActorSnapshot_UID_tag                   1
+#define NActorSnapshot_Pos_tag                   2
+#define NActorSnapshot_MoveVel_tag               3
+#define NActorSnapshot_Dir_tag                   4
+#define NActorSnapshot_InputSeq_tag              5
 #define NAddBullet_UID_tag                       1
 #define NAddBullet_BulletClass_tag               2
 #define NAddBullet_MuzzlePos_tag                 3
@@ -657,6 +712,11 @@ extern const int32_t NAddBullet_ActorUID_default;
 #define NPlayerData_MaxHealth_tag                9
 #define NPlayerData_LastMission_tag              10
 #define NPlayerData_UID_tag                      11
+#define NSnapshot_Seq_tag                        1
+#define NSnapshot_BaseSeq_tag                    2
+#define NSnapshot_Part_tag                       3
+#define NSnapshot_Parts_tag                      4
+#define NSnapshot_Actors_tag                     5
 
 /* Struct field encoding specification for nanopb */
 extern const pb_field_t NServerInfo_fields[9];
@@ -678,7 +738,7 @@ extern const pb_field_t NVec2i_fields[3];
 extern const pb_field_t NVec2_fields[3];
 extern const pb_field_t NGameBegin_fields[2];
 extern const pb_field_t NActorAdd_fields[8];
-extern const pb_field_t NActorMove_fields[4];
+extern const pb_field_t NActorMove_fields[5];
 extern const pb_field_t NActorState_fields[3];
 extern const pb_field_t NActorDir_fields[3];
 extern const pb_field_t NActorSlide_fields[3];
@@ -707,6 +767,10 @@ extern const pb_field_t NObjectiveUpdate_fields[3];
 extern const pb_field_t NAddKeys_fields[3];
 extern const pb_field_t NMissionComplete_fields[4];
 extern const pb_field_t NMissionEnd_fields[4];
+extern const pb_field_t NActorSnapshot_fields[6];
+extern const pb_field_t NSnapshot_fields[6];
+extern const pb_field_t NSnapshotAck_fields[2];
+extern const pb_field_t NJoinChunk_fields[4];
 
 /* Maximum encoded size of messages (where known) */
 #define NServerInfo_size                         97
@@ -719,20 +783,20 @@ extern const pb_field_t NMissionEnd_fields[4];
 #define NPlayerRemove_size                       6
 #define NConfig_size                             262
 #define NTileSet_size                            297
-#define NThingDamage_size                        73
-#define NMapObjectAdd_size                       179
+#define NThingDamage_size                        75
+#define NMapObjectAdd_size                       181
 #define NMapObjectRemove_size                    23
 #define NScore_size                              17
-#define NSound_size                              145
+#define NSound_size                              147
 #define NVec2i_size                              22
-#define NVec2_size                               10
+#define NVec2_size                               12
 #define NGameBegin_size                          11
-#define NActorAdd_size                           63
-#define NActorMove_size                          30
+#define NActorAdd_size                           65
+#define NActorMove_size                          40
 #define NActorState_size                         17
 #define NActorDir_size                           17
-#define NActorSlide_size                         18
-#define NActorImpulse_size                       30
+#define NActorSlide_size                         20
+#define NActorImpulse_size                       34
 #define NActorSwitchGun_size                     12
 #define NActorPickupAll_size                     8
 #define NActorReplaceGun_size                    143
@@ -741,22 +805,26 @@ extern const pb_field_t NMissionEnd_fields[4];
 #define NActorUseAmmo_size                       29
 #define NActorDie_size                           6
 #define NActorMelee_size                         165
-#define NAddPickup_size                          168
+#define NAddPickup_size                          170
 #define NRemovePickup_size                       17
-#define NBulletBounce_size                       59
+#define NBulletBounce_size                       65
 #define NRemoveBullet_size                       6
-#define NGunReload_size                          165
-#define NGunFire_size                            180
+#define NGunReload_size                          167
+#define NGunFire_size                            183
 #define NGunState_size                           17
-#define NAddBullet_size                          193
+#define NAddBullet_size                          196
 #define NTrigger_size                            30
 #define NExploreTiles_size                       592
 #define NExploreTiles_Run_size                   35
 #define NRescueCharacter_size                    6
 #define NObjectiveUpdate_size                    17
-#define NAddKeys_size                            18
+#define NAddKeys_size                            20
 #define NMissionComplete_size                    50
 #define NMissionEnd_size                         144
+#define NActorSnapshot_size                      51
+#define NSnapshot_size                           872
+#define NSnapshotAck_size                        6
+#define NJoinChunk_size                          1039
 
 /* Message IDs (where set with "msgid" option) */
 #ifdef PB_MSGID
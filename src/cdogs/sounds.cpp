@@ -54,13 +54,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/stat.h>
 
 #include <SDL2/SDL.h>
 
 #include <tinydir/tinydir.h>
 
 #include "algorithms.h"
+#include "asset_pack.h"
 #include "files.h"
 #include "log.h"
 #include "map.h"
@@ -95,6 +95,19 @@ int OpenAudio(int frequency, Uint16 format, int channels, int chunkSize) {
 	return 0;
 }
 
+// Upper limit of decoded sound data to keep in memory
+#define SOUND_CACHE_BUDGET (24 * 1024 * 1024)
+
+typedef struct {
+	Mix_Chunk chunk;	// must be first; this is the handle given out
+	char *path;
+	unsigned int lastUsed;
+	bool isBroken;	// failed to decode; don't try again
+} SoundChunk;
+static SoundChunk* SoundChunkFromHandle(Mix_Chunk *data) {
+	return reinterpret_cast<SoundChunk*>(data);
+}
+
 static Mix_Chunk* LoadSound(const char *path);
 static void AddSound(map_t sounds, const char *name, SoundData *sound);
 static void SoundLoad(map_t sounds, const char *name, const char *path) {
@@ -158,8 +171,106 @@ static Mix_Chunk* LoadSound(const char *path) {
 					|| strcmp(ext, ".wav") == 0 || strcmp(ext, ".WAV") == 0)) {
 		return NULL;
 	}
-	LOG(LM_MAIN, LL_TRACE, "loading sound file %s", path);
-	return Mix_LoadWAV(path);
+	int64_t mtime, size;
+	if (!AssetStat(path, &mtime, &size)) {
+		return NULL;
+	}
+	// Only record the path; the sound is decoded when needed
+	SoundChunk *sc;
+	CCALLOC(sc, sizeof *sc);
+	sc->chunk.volume = MIX_MAX_VOLUME;
+	CSTRDUP(sc->path, path);
+	return &sc->chunk;
+}
+static void SoundChunkEvict(SoundDevice *device, const SoundChunk *keep);
+static bool SoundChunkLoad(SoundDevice *device, SoundChunk *sc) {
+	sc->lastUsed = ++device->soundTicks;
+	if (sc->chunk.abuf != NULL) {
+		return true;
+	}
+	if (sc->isBroken) {
+		return false;
+	}
+	LOG(LM_MAIN, LL_TRACE, "loading sound file %s", sc->path);
+	Mix_Chunk *data = Mix_LoadWAV_RW(AssetRWFromFile(sc->path), 1);
+	if (data == NULL) {
+		LOG(LM_MAIN, LL_ERROR, "Cannot load sound %s: %s", sc->path,
+				Mix_GetError());
+		sc->isBroken = true;
+		return false;
+	}
+	// Take the decoded data and free the rest of the chunk
+	sc->chunk.allocated = data->allocated;
+	sc->chunk.abuf = data->abuf;
+	sc->chunk.alen = data->alen;
+	data->allocated = 0;
+	data->abuf = NULL;
+	Mix_FreeChunk(data);
+
+	Mix_Chunk *handle = &sc->chunk;
+	CArrayPushBack(&device->loadedSounds, &handle);
+	device->loadedSoundsSize += sc->chunk.alen;
+	SoundChunkEvict(device, sc);
+	return true;
+}
+static bool SoundChunkIsPlaying(const SoundDevice *device,
+		const SoundChunk *sc) {
+	for (int i = 0; i < device->channels; i++) {
+		if (Mix_Playing(i) && Mix_GetChunk(i) == &sc->chunk) {
+			return true;
+		}
+	}
+	return false;
+}
+static void SoundChunkUnload(SoundDevice *device, SoundChunk *sc) {
+	if (sc->chunk.allocated) {
+		SDL_free(sc->chunk.abuf);
+	}
+	device->loadedSoundsSize -= sc->chunk.alen;
+	sc->chunk.allocated = 0;
+	sc->chunk.abuf = NULL;
+	sc->chunk.alen = 0;
+}
+static void SoundChunkEvict(SoundDevice *device, const SoundChunk *keep) {
+	while (device->loadedSoundsSize > SOUND_CACHE_BUDGET) {
+		// Find the least recently used sound that isn't playing
+		int lru = -1;
+		unsigned int lruTicks = 0;
+		CA_FOREACH(Mix_Chunk *, data, device->loadedSounds)
+			const SoundChunk *sc = SoundChunkFromHandle(*data);
+			if (sc != keep && (lru == -1 || sc->lastUsed < lruTicks)
+					&& !SoundChunkIsPlaying(device, sc)) {
+				lru = _ca_index;
+				lruTicks = sc->lastUsed;
+			}
+		CA_FOREACH_END()
+		if (lru == -1) {
+			break;
+		}
+		Mix_Chunk **data = static_cast<Mix_Chunk**>(CArrayGet(
+				&device->loadedSounds, lru));
+		SoundChunkUnload(device, SoundChunkFromHandle(*data));
+		CArrayDelete(&device->loadedSounds, lru);
+	}
+}
+static void SoundChunkFree(SoundDevice *device, Mix_Chunk *data) {
+	SoundChunk *sc = SoundChunkFromHandle(data);
+	if (sc->chunk.abuf != NULL) {
+		for (int i = 0; i < device->channels; i++) {
+			if (Mix_GetChunk(i) == data) {
+				Mix_HaltChannel(i);
+			}
+		}
+		CA_FOREACH(Mix_Chunk *, loaded, device->loadedSounds)
+			if (*loaded == data) {
+				CArrayDelete(&device->loadedSounds, _ca_index);
+				break;
+			}
+		CA_FOREACH_END()
+		SoundChunkUnload(device, sc);
+	}
+	CFREE(sc->path);
+	CFREE(sc);
 }
 static void SoundDataTerminate(any_t data);
 static void AddSound(map_t sounds, const char *name, SoundData *sound) {
@@ -177,6 +288,7 @@ void SoundInitialize(SoundDevice *device, const char *path) {
 
 	device->sounds = hashmap_new();
 	device->customSounds = hashmap_new();
+	CArrayInit(&device->loadedSounds, sizeof(Mix_Chunk*));
 	char buf[CDOGS_PATH_MAX];
 	GetDataFilePath(buf, path);
 	SoundLoadDir(device->sounds, buf, NULL);
@@ -187,6 +299,21 @@ void SoundInitialize(SoundDevice *device, const char *path) {
 	SoundLoadMusic(&device->musicTracks[MUSIC_GAME], "music/game");
 }
 void SoundLoadDir(map_t sounds, const char *path, const char *prefix) {
+	// Use the asset pack's listing if it has this dir
+	AssetPackDir pd;
+	if (AssetPackDirOpen(&pd, &gAssetPack, path)) {
+		while (AssetPackDirNext(&pd)) {
+			char buf[CDOGS_PATH_MAX];
+			if (prefix != NULL) {
+				sprintf(buf, "%s/%s", prefix, pd.Name);
+			} else {
+				strcpy(buf, pd.Name);
+			}
+			SoundLoad(sounds, buf, pd.Path);
+		}
+		return;
+	}
+
 	tinydir_dir dir;
 	if (tinydir_open(&dir, path) == -1) {
 		if (errno != ENOENT) {
@@ -220,7 +347,7 @@ void SoundLoadDir(map_t sounds, const char *path, const char *prefix) {
 	bail: tinydir_close(&dir);
 }
 static void SoundLoadMusic(CArray *tracks, const char *path) {
-	CArrayInit(tracks, sizeof(Mix_Music*));
+	CArrayInit(tracks, sizeof(char*));
 	tinydir_dir dir;
 	char buf[CDOGS_PATH_MAX];
 	GetDataFilePath(buf, path);
@@ -231,19 +358,16 @@ static void SoundLoadMusic(CArray *tracks, const char *path) {
 	}
 
 	for (; dir.has_next; tinydir_next(&dir)) {
-		Mix_Music *m;
 		tinydir_file file;
 		if (tinydir_readfile(&dir, &file) == -1) {
 			goto bail;
 		}
-		if (!file.is_reg) {
+		if (!file.is_reg || !MusicIsSupported(file.path)) {
 			continue;
 		}
 
-		m = MusicLoad(file.path);
-		if (m == NULL) {
-			continue;
-		}
+		char *m;
+		CSTRDUP(m, file.path);
 		CArrayPushBack(tracks, &m);
 	}
 
@@ -308,7 +432,10 @@ void SoundTerminate(SoundDevice *device, const bool waitForSoundsComplete) {
 
 	hashmap_destroy(device->sounds, SoundDataTerminate);
 	hashmap_destroy(device->customSounds, SoundDataTerminate);
+	CArrayTerminate(&device->loadedSounds);
 
+	MusicStop(device);
+	MusicPrefetchClear(device);
 	for (MusicType type = MUSIC_MENU; type < MUSIC_COUNT; ++type) {
 		SoundUnloadMusic(&device->musicTracks[type]);
 	}
@@ -317,11 +444,11 @@ static void SoundDataTerminate(any_t data) {
 	SoundData *s = static_cast<SoundData*>(data);
 	switch (s->Type) {
 	case SOUND_NORMAL:
-		Mix_FreeChunk(s->u.normal);
+		SoundChunkFree(&gSoundDevice, s->u.normal);
 		break;
 	case SOUND_RANDOM:
 		CA_FOREACH(Mix_Chunk *, chunk, s->u.random.sounds)
-		Mix_FreeChunk(*chunk);
+		SoundChunkFree(&gSoundDevice, *chunk);
 		CA_FOREACH_END()
 		CArrayTerminate(&s->u.random.sounds);
 		break;
@@ -333,8 +460,8 @@ static void SoundDataTerminate(any_t data) {
 	CFREE(s);
 }
 static void SoundUnloadMusic(CArray *tracks) {
-	CA_FOREACH(Mix_Music *, m, *tracks)
-	Mix_FreeMusic(*m);
+	CA_FOREACH(char *, m, *tracks)
+	CFREE(*m);
 	CA_FOREACH_END()
 	CArrayTerminate(tracks);
 }
@@ -402,6 +529,11 @@ static void SoundPlayAtPosition(SoundDevice *device, Mix_Chunk *data,
 	LOG(LM_SOUND, LL_TRACE, "distance(%d) bearing(%d)", distance,
 			bearingDegrees);
 
+	// Decode the sound now that we know it will be played
+	if (!SoundChunkLoad(device, SoundChunkFromHandle(data))) {
+		return;
+	}
+
 	// Get sound channel to play sound
 	const int channel = GetChannel(device, data);
 	if (channel < 0) {
@@ -526,22 +658,29 @@ void SoundPlayAtPlusDistance(SoundDevice *device, Mix_Chunk *data,
 			svec2(dp.x, fabsf(dp.y) + plusDistance), isMuffled);
 }
 
-static Mix_Chunk* SoundDataGet(SoundData *s);
-Mix_Chunk* StrSound(const char *s) {
+static SoundData* SoundDataFind(const char *s) {
 	if (s == NULL || strlen(s) == 0 || !gSoundDevice.isInitialised) {
 		return NULL;
 	}
 	SoundData *sound;
 	int error = hashmap_get(gSoundDevice.customSounds, s, (any_t*) &sound);
 	if (error == MAP_OK) {
-		return SoundDataGet(sound);
+		return sound;
 	}
 	error = hashmap_get(gSoundDevice.sounds, s, (any_t*) &sound);
 	if (error == MAP_OK) {
-		return SoundDataGet(sound);
+		return sound;
 	}
 	return NULL;
 }
+static Mix_Chunk* SoundDataGet(SoundData *s);
+Mix_Chunk* StrSound(const char *s) {
+	SoundData *sound = SoundDataFind(s);
+	if (sound == NULL) {
+		return NULL;
+	}
+	return SoundDataGet(sound);
+}
 static Mix_Chunk* SoundDataGet(SoundData *s) {
 	switch (s->Type) {
 	case SOUND_NORMAL:
@@ -567,3 +706,30 @@ static Mix_Chunk* SoundDataGet(SoundData *s) {
 		return NULL;
 	}
 }
+
+void SoundPrefetch(SoundDevice *device, Mix_Chunk *data) {
+	if (!device->isInitialised || data == NULL) {
+		return;
+	}
+	SoundChunkLoad(device, SoundChunkFromHandle(data));
+}
+void SoundPrefetchStr(SoundDevice *device, const char *s) {
+	const SoundData *sound = SoundDataFind(s);
+	if (sound == NULL) {
+		return;
+	}
+	switch (sound->Type) {
+	case SOUND_NORMAL:
+		SoundPrefetch(device, sound->u.normal);
+		break;
+	case SOUND_RANDOM:
+		CA_FOREACH(Mix_Chunk * const, chunk, sound->u.random.sounds)
+			SoundPrefetch(device, *chunk);
+		CA_FOREACH_END()
+		break;
+	default:
+		CASSERT(false, "Unknown sound data type")
+		;
+		break;
+	}
+}
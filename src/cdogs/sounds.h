@@ -52,7 +52,13 @@
 #include <stdbool.h>
 
 #include <SDL2/SDL.h>
+#ifdef CDOGS_HEADLESS
+// The headless server has no audio; sounds are only passed around as handles
+typedef struct Mix_Chunk Mix_Chunk;
+typedef struct _Mix_Music Mix_Music;
+#else
 #include <SDL2/SDL_mixer.h>
+#endif
 
 #include "c_array.h"
 #include "c_hashmap/hashmap.h"
@@ -66,6 +72,9 @@ typedef enum {
 	SOUND_NORMAL, SOUND_RANDOM
 } SoundType;
 
+// Sound data is loaded lazily. The Mix_Chunk pointers handed out by StrSound
+// are stable handles whose PCM data is only decoded when first played or
+// prefetched, and may be freed again when over the memory budget.
 typedef struct {
 	SoundType Type;
 	union {
@@ -84,8 +93,14 @@ MusicType& operator++(MusicType &d);
 typedef struct {
 	int isInitialised;
 	Mix_Music *music;
-	bool musicIsDynamic;
-	CArray musicTracks[MUSIC_COUNT];	// of Mix_Music *
+	// Tracks are only loaded when played, so only index their paths
+	CArray musicTracks[MUSIC_COUNT];	// of char *
+	// The next track to be played, loaded in the background
+	struct {
+		const char *Path;	// from musicTracks
+		Mix_Music *Music;
+		SDL_Thread *Thread;
+	} musicNext;
 	char musicErrorMessage[128];
 	int channels;
 
@@ -97,6 +112,11 @@ typedef struct {
 
 	map_t sounds;		// of SoundData
 	map_t customSounds;	// of SoundData
+
+	// Sounds with decoded data, for evicting the least recently used
+	CArray loadedSounds;	// of Mix_Chunk *
+	size_t loadedSoundsSize;
+	unsigned int soundTicks;
 } SoundDevice;
 
 extern SoundDevice gSoundDevice;
@@ -135,4 +155,9 @@ void SoundPlayAtPlusDistance(SoundDevice *device, Mix_Chunk *data,
 		const struct vec2 pos, const int plusDistance);
 
 Mix_Chunk* StrSound(const char *s);
+
+// Decode sounds ahead of time, so they don't need to be decoded on first play
+void SoundPrefetch(SoundDevice *device, Mix_Chunk *data);
+// Prefetch all the variants of a sound
+void SoundPrefetchStr(SoundDevice *device, const char *s);
 #endif
@@ -146,7 +146,9 @@ void TileClassInit(TileClass *t, PicManager *pm, const TileClass *base,
 	}
 	t->Mask = mask;
 	t->MaskAlt = maskAlt;
-	TileClassReloadPic(t, pm);
+	if (pm != NULL) {
+		TileClassReloadPic(t, pm);
+	}
 }
 void TileClassInitDefault(TileClass *t, PicManager *pm, const TileClass *base,
 		const char *forceStyle, const color_t *forceMask) {
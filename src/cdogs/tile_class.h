@@ -87,6 +87,7 @@ void TileClassesTerminate(TileClasses *c);
 void TileClassDestroy(any_t data);
 void TileClassTerminate(TileClass *tc);
 
+// pm can be NULL to leave making the pic until later, e.g. when the map is built
 void TileClassInit(TileClass *t, PicManager *pm, const TileClass *base,
 		const char *style, const char *type, const color_t mask,
 		const color_t maskAlt);
@@ -48,16 +48,10 @@
  */
 #pragma once
 
-#ifdef __EMSCRIPTEN__
-#include <SDL2/SDL.h>
-#include <SDL2/SDL_mixer.h>
-#else
-#include <SDL2/SDL_mixer.h>
-#endif
-
 #include "c_array.h"
 #include "game_events.h"
 #include "pic.h"
+#include "sounds.h"
 #include "proto/msg.pb.h"
 
 typedef enum {
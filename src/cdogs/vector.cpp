@@ -79,3 +79,18 @@ bool Rect2iOverlap(const Rect2i r1, const Rect2i r2) {
 			&& r1.Pos.y < r2.Pos.y + r2.Size.y
 			&& r1.Pos.y + r1.Size.y > r2.Pos.y;
 }
+
+Rect2i Rect2iUnion(const Rect2i r1, const Rect2i r2) {
+	if (r1.Size.x <= 0 || r1.Size.y <= 0) {
+		return r2;
+	}
+	if (r2.Size.x <= 0 || r2.Size.y <= 0) {
+		return r1;
+	}
+	const struct vec2i pos = svec2i(MIN(r1.Pos.x, r2.Pos.x),
+			MIN(r1.Pos.y, r2.Pos.y));
+	const struct vec2i end = svec2i(
+			MAX(r1.Pos.x + r1.Size.x, r2.Pos.x + r2.Size.x),
+			MAX(r1.Pos.y + r1.Size.y, r2.Pos.y + r2.Size.y));
+	return Rect2iNew(pos, svec2i_subtract(end, pos));
+}
@@ -66,3 +66,5 @@ bool Rect2iIsZero(const Rect2i r);
 bool Rect2iIsAtEdge(const Rect2i r, const struct vec2i v);
 bool Rect2iIsInside(const Rect2i r, const struct vec2i v);
 bool Rect2iOverlap(const Rect2i r1, const Rect2i r2);
+// Smallest rect containing both; empty rects are ignored
+Rect2i Rect2iUnion(const Rect2i r1, const Rect2i r2);
@@ -28,6 +28,7 @@
 #include "weapon_class.h"
 
 #include "ammo.h"
+#include "asset_pack.h"
 #include "game_events.h"
 #include "json_utils.h"
 #include "log.h"
@@ -363,7 +364,8 @@ void WeaponClassFire(const WeaponClass *wc, const struct vec2 pos,
 	e.u.GunFire.MuzzlePos = Vec2ToNet(pos);
 	// TODO: GunFire Z to float
 	e.u.GunFire.Z = (int) z;
-	e.u.GunFire.Angle = (float) radians;
+	e.u.GunFire.Angle =
+			RadiansToNet((float) radians, NET_ANGLE_BITS_GUN_FIRE);
 	e.u.GunFire.Sound = playSound;
 	e.u.GunFire.Flags = flags;
 	e.u.GunFire.IsGun = isGun;
@@ -473,7 +475,7 @@ void BulletAndWeaponInitialize(BulletClasses *b, WeaponClasses *wcs,
 	bool freeBRoot = true;
 	char buf[CDOGS_PATH_MAX];
 	GetDataFilePath(buf, bpath);
-	bf = fopen(buf, "r");
+	bf = AssetFOpen(buf, "r");
 	if (bf == NULL) {
 		LOG(LM_MAP, LL_ERROR, "Error: cannot load bullets file %s", buf);
 		goto bail;
@@ -488,7 +490,7 @@ void BulletAndWeaponInitialize(BulletClasses *b, WeaponClasses *wcs,
 
 	WeaponClassesInitialize(wcs);
 	GetDataFilePath(buf, gpath);
-	gf = fopen(buf, "r");
+	gf = AssetFOpen(buf, "r");
 	if (gf == NULL) {
 		LOG(LM_MAP, LL_ERROR, "Error: cannot load guns file %s", buf);
 		goto bail;
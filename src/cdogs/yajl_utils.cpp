@@ -28,6 +28,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "asset_pack.h"
+
 static char* ReadFile(const char *filename);
 yajl_val YAJLReadFile(const char *filename) {
 	yajl_val node = NULL;
@@ -48,7 +50,7 @@ yajl_val YAJLReadFile(const char *filename) {
 }
 // Read a file into a dynamic buffer
 static char* ReadFile(const char *filename) {
-	FILE *f = fopen(filename, "r");
+	FILE *f = AssetFOpen(filename, "r");
 	char *buf = NULL;
 	long bufsize;
 	size_t readlen;
@@ -113,10 +113,7 @@ bool ConfirmScreen(const char *info, const char *msg) {
 
 void ClearScreen(GraphicsDevice *g) {
 	color_t color = { 32, 32, 60, 255 };
-	const Uint32 pixel = COLOR2PIXEL(color);
-	for (int i = 0; i < GraphicsGetScreenSize(&g->cachedConfig); i++) {
-		g->buf[i] = pixel;
-	}
+	BlitFillBuf(g, color);
 	if (SDL_SetRenderTarget(g->gameWindow.renderer, g->bkgTgt) != 0) {
 		LOG(LM_GFX, LL_ERROR, "cannot set render target: %s", SDL_GetError());
 	}
@@ -29,8 +29,10 @@
 
 #include <stdio.h>
 
+#include <cdogs/asset_pack.h>
 #include <cdogs/config.h>
 #include <cdogs/log.h>
+#include <cdogs/map_archive.h>
 #include <cdogs/sys_config.h>
 #include <cdogs/utils.h>
 #include <cdogs/XGetopt.h>
@@ -74,7 +76,15 @@ void PrintHelp(void) {
 	printf("    --logfile=F      Log to file by filename\n\n");
 
 	printf("%s\n", "Other:\n"
-			"    --connect=host   (Experimental) connect to a game server\n");
+			"    --connect=host   (Experimental) connect to a game server\n"
+			"    --pack-assets    Pack the data files into " ASSET_PACK_FILE "\n"
+			"                     for faster loading, and exit\n"
+			"    --compile-campaign=path\n"
+			"                     Compile the static maps of a campaign archive\n"
+			"                     into a binary file for faster loading, and exit\n"
+			"    --decompile-campaign=path\n"
+			"                     Move compiled static maps back into JSON, and\n"
+			"                     exit\n");
 }
 
 void ProcessCommandLine(char *buf, const int argc, char *argv[]) {
@@ -103,6 +113,9 @@ bool ParseArgs(const int argc, char *argv[], ENetAddress *connectAddr,
 					required_argument, NULL, 'x' }, { "config",
 					optional_argument, NULL, 'C' }, { "log", required_argument,
 					NULL, 1000 }, { "logfile", required_argument, NULL, 1001 },
+					{ "pack-assets", no_argument, NULL, 1002 },
+					{ "compile-campaign", required_argument, NULL, 1003 },
+					{ "decompile-campaign", required_argument, NULL, 1004 },
 					{ "help", no_argument, NULL, 'h' }, { 0, 0, NULL, 0 } };
 	int opt = 0;
 	int idx = 0;
@@ -155,6 +168,33 @@ bool ParseArgs(const int argc, char *argv[], ENetAddress *connectAddr,
 		case 1001:
 			LogOpenFile(optarg);
 			break;
+		case 1002: {
+			const char *dirs[] = { "graphics", "sounds", "data" };
+			char root[CDOGS_PATH_MAX];
+			char path[CDOGS_PATH_MAX];
+			GetDataFilePath(root, "");
+			GetDataFilePath(path, ASSET_PACK_FILE);
+			if (AssetPackBuild(path, root, dirs, 3)) {
+				printf("Packed assets into %s\n", path);
+			} else {
+				printf("Error: failed to pack assets into %s\n", path);
+			}
+		}
+			return false;
+		case 1003:
+			if (MapArchiveCompile(optarg)) {
+				printf("Compiled %s\n", optarg);
+			} else {
+				printf("Error: failed to compile %s\n", optarg);
+			}
+			return false;
+		case 1004:
+			if (MapArchiveDecompile(optarg)) {
+				printf("Decompiled %s\n", optarg);
+			} else {
+				printf("Error: failed to decompile %s\n", optarg);
+			}
+			return false;
 		case 'x':
 			if (enet_address_set_host(connectAddr, optarg) != 0) {
 				printf("Error: unknown host %s\n", optarg);
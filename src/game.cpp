@@ -399,7 +399,6 @@ static void RunGameInput(GameLoopData *data) {
 	CameraInput(&rData->Camera, rData->cmds[0], rData->lastCmds[0]);
 }
 static void NextLoop(RunGameData *rData, LoopRunner *l);
-static void CheckMissionCompletion(const struct MissionOptions *mo);
 static GameLoopResult RunGameUpdate(GameLoopData *data, LoopRunner *l) {
 	RunGameData *rData = static_cast<RunGameData*>(data->Data);
 
@@ -514,14 +513,14 @@ static GameLoopResult RunGameUpdate(GameLoopData *data, LoopRunner *l) {
 			if (!svec2_is_zero(vel)) {
 				GameEvent ei = GameEventNew(GAME_EVENT_ACTOR_IMPULSE);
 				ei.u.ActorImpulse.UID = p->uid;
-				ei.u.ActorImpulse.Vel = Vec2ToNet(svec2_scale(vel, 0.25f));
+				const struct vec2 impulse = svec2_scale(vel, 0.25f);
+				ei.u.ActorImpulse.Vel = Vec2ToNet(impulse);
 				ei.u.ActorImpulse.Pos = Vec2ToNet(svec2_zero());
 				GameEventsEnqueue(&gGameEvents, ei);
 				LOG(LM_MAIN, LL_TRACE,
 						"playerUID(%d) pos(%f, %f) screen(%d, %d) impulse(%f, %f)",
 						p->uid, p->thing.Pos.x, p->thing.Pos.y, screen.x,
-						screen.y, ei.u.ActorImpulse.Vel.x,
-						ei.u.ActorImpulse.Vel.y);
+						screen.y, impulse.x, impulse.y);
 			}CA_FOREACH_END()
 	}
 
@@ -539,7 +538,7 @@ static GameLoopResult RunGameUpdate(GameLoopData *data, LoopRunner *l) {
 	CA_FOREACH_END()
 
 	if (!gCampaign.IsClient) {
-		CheckMissionCompletion(rData->m);
+		MissionCheckCompletion(rData->m);
 	} else if (!NetClientIsConnected(&gNetClient)) {
 		// Check if disconnected from server; end mission
 		const NMissionEnd me = NMissionEnd_init_zero;
@@ -549,6 +548,10 @@ static GameLoopResult RunGameUpdate(GameLoopData *data, LoopRunner *l) {
 	HandleGameEvents(&gGameEvents, &rData->Camera, &rData->healthSpawner,
 			&rData->ammoSpawners);
 
+	if (!gCampaign.IsClient) {
+		NetServerSendSnapshot(&gNetServer);
+	}
+
 	rData->m->time += ticksPerFrame;
 
 	if (gEventHandlers.HasResolutionChanged) {
@@ -586,53 +589,6 @@ static void NextLoop(RunGameData *rData, LoopRunner *l) {
 		LoopRunnerChange(l, HighScoresScreen(&gCampaign, &gGraphicsDevice));
 	}
 }
-static void CheckMissionCompletion(const struct MissionOptions *mo) {
-	// Check if we need to update explore objectives
-	CA_FOREACH(const Objective, o, mo->missionData->Objectives)
-		if (o->Type != OBJECTIVE_INVESTIGATE)
-			continue;
-		const int update = MapGetExploredPercentage(&gMap) - o->done;
-		if (update > 0 && !gCampaign.IsClient) {
-			GameEvent e = GameEventNew(GAME_EVENT_OBJECTIVE_UPDATE);
-			e.u.ObjectiveUpdate.ObjectiveId = _ca_index;
-			e.u.ObjectiveUpdate.Count = update;
-			GameEventsEnqueue(&gGameEvents, e);
-		}CA_FOREACH_END()
-
-	const bool isMissionComplete = GetNumPlayers(PLAYER_ALIVE_OR_DYING, false,
-			false) > 0 && IsMissionComplete(mo);
-	if (mo->state == MISSION_STATE_PLAY && isMissionComplete) {
-		GameEvent e = GameEventNew(GAME_EVENT_MISSION_PICKUP);
-		GameEventsEnqueue(&gGameEvents, e);
-	}
-	if (mo->state == MISSION_STATE_PICKUP && !isMissionComplete) {
-		GameEvent e = GameEventNew(GAME_EVENT_MISSION_INCOMPLETE);
-		GameEventsEnqueue(&gGameEvents, e);
-	}
-	if (mo->state == MISSION_STATE_PICKUP
-			&& mo->pickupTime + PICKUP_LIMIT <= mo->time) {
-		GameEvent e = GameEventNew(GAME_EVENT_MISSION_END);
-		GameEventsEnqueue(&gGameEvents, e);
-	}
-
-	// Check that all players have been destroyed
-	// If the server has no players at all, wait for a player to join
-	if (gPlayerDatas.size > 0) {
-		// Note: there's a period of time where players are dying
-		// Wait until after this period before ending the game
-		bool allPlayersDestroyed = true;
-		CA_FOREACH(const PlayerData, p, gPlayerDatas)
-			if (p->ActorUID != -1) {
-				allPlayersDestroyed = false;
-				break;
-			}CA_FOREACH_END()
-		if (allPlayersDestroyed && AreAllPlayersDeadAndNoLives()) {
-			GameEvent e = GameEventNew(GAME_EVENT_MISSION_END);
-			e.u.MissionEnd.Delay = GAME_OVER_DELAY;
-			GameEventsEnqueue(&gGameEvents, e);
-		}
-	}
-}
 static void RunGameDraw(GameLoopData *data) {
 	RunGameData *rData = static_cast<RunGameData*>(data->Data);
 
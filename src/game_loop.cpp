@@ -181,14 +181,21 @@ bool LoopRunnerRunInner(LoopRunInnerData *ctx) {
 #ifndef __EMSCRIPTEN__
 	// Frame rate control
 	if (LoopRunParamsShouldSleep(&(ctx->p))) {
+#ifdef CDOGS_HEADLESS
+		// Nothing to do until the next tick
+		SDL_Delay(ctx->p.FrameDurationMs - ctx->p.TicksElapsed);
+#else
 		SDL_Delay(1);
+#endif
 		return true;
 	}
 #endif
 
 	// Input
 	if ((ctx->data->Frames & 1) || !ctx->data->InputEverySecondFrame) {
+#ifndef CDOGS_HEADLESS
 		EventPoll(&gEventHandlers, ctx->p.TicksNow, NULL);
+#endif
 		if (ctx->data->InputFunc) {
 			ctx->data->InputFunc(ctx->data);
 		}
@@ -235,6 +242,7 @@ bool LoopRunnerRunInner(LoopRunInnerData *ctx) {
 	}
 #endif
 
+#ifndef CDOGS_HEADLESS
 	// Draw
 	if (draw) {
 		WindowContextPreRender(&gGraphicsDevice.gameWindow);
@@ -250,6 +258,9 @@ bool LoopRunnerRunInner(LoopRunInnerData *ctx) {
 		}
 		ctx->data->HasDrawnFirst = true;
 	}
+#else
+	UNUSED(draw);
+#endif
 
 	return true;
 }
@@ -344,8 +355,10 @@ static void GameLoopOnEnter(GameLoopData *data) {
 	if (data->OnEnter) {
 		data->OnEnter(data);
 	}
+#ifndef CDOGS_HEADLESS
 	EventReset(&gEventHandlers, gEventHandlers.mouse.cursor,
 			gEventHandlers.mouse.trail);
+#endif
 }
 static void GameLoopOnExit(GameLoopData *data) {
 	if (data->OnExit) {
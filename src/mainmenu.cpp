@@ -29,6 +29,7 @@
 #include <string.h>
 
 #include <cdogs/config.h>
+#include <cdogs/draw/drawtools.h>
 #include <cdogs/font.h>
 #include <cdogs/grafx_bg.h>
 #include <cdogs/log.h>
@@ -57,6 +58,7 @@ static void MainMenuOnEnter(GameLoopData *data);
 static void MainMenuOnExit(GameLoopData *data);
 static GameLoopResult MainMenuUpdate(GameLoopData *data, LoopRunner *l);
 static void MainMenuDraw(GameLoopData *data);
+static GameLoopData* ScreenCampaignLoading(void);
 GameLoopData* MainMenu(GraphicsDevice *graphics, LoopRunner *l) {
 	MainMenuData *data;
 	CMALLOC(data, sizeof *data);
@@ -158,6 +160,8 @@ static GameLoopResult MainMenuUpdate(GameLoopData *data, LoopRunner *l) {
 	if (result == UPDATE_RESULT_OK) {
 		if (gCampaign.IsLoaded) {
 			LoopRunnerPush(l, ScreenCampaignIntro(&gCampaign.Setting));
+		} else if (gCampaign.IsLoading) {
+			LoopRunnerPush(l, ScreenCampaignLoading());
 		} else {
 			LoopRunnerPop(l);
 		}
@@ -172,6 +176,53 @@ static void MainMenuDraw(GameLoopData *data) {
 	MenuDraw(&mData->ms);
 }
 
+static void CampaignLoadingTerminate(GameLoopData *data);
+static GameLoopResult CampaignLoadingUpdate(GameLoopData *data,
+		LoopRunner *l);
+static void CampaignLoadingDraw(GameLoopData *data);
+static GameLoopData* ScreenCampaignLoading(void) {
+	float *progress;
+	CCALLOC(progress, sizeof *progress);
+	return GameLoopDataNew(progress, CampaignLoadingTerminate, NULL, NULL,
+			NULL, CampaignLoadingUpdate, CampaignLoadingDraw);
+}
+static void CampaignLoadingTerminate(GameLoopData *data) {
+	CFREE(data->Data);
+}
+static GameLoopResult CampaignLoadingUpdate(GameLoopData *data,
+		LoopRunner *l) {
+	float *progress = static_cast<float*>(data->Data);
+	if (CampaignLoadPoll(&gCampaign, progress)) {
+		if (gCampaign.IsLoaded) {
+			LoopRunnerChange(l, ScreenCampaignIntro(&gCampaign.Setting));
+		} else {
+			printf("Error: cannot load campaign %s\n", gCampaign.Entry.Info);
+			LoopRunnerPop(l);
+		}
+	}
+	return UPDATE_RESULT_DRAW;
+}
+static void CampaignLoadingDraw(GameLoopData *data) {
+	const float *progress = static_cast<const float*>(data->Data);
+	BlitClearBuf(&gGraphicsDevice);
+	const struct vec2i res = gGraphicsDevice.cachedConfig.Res;
+
+	FontOpts opts = FontOptsNew();
+	opts.HAlign = ALIGN_CENTER;
+	opts.Area = res;
+	opts.Pad.y = res.y / 2 - FontH() * 2;
+	FontStrOpt(gCampaign.Entry.Info, svec2i_zero(), opts);
+
+	const struct vec2i barSize = svec2i(res.x / 2, FontH());
+	const struct vec2i barPos = svec2i((res.x - barSize.x) / 2, res.y / 2);
+	DrawRectangle(&gGraphicsDevice, barPos, barSize, colorGray, false);
+	DrawRectangle(&gGraphicsDevice, barPos,
+			svec2i((int) (barSize.x * *progress), barSize.y), colorWhite,
+			true);
+
+	BlitUpdateFromBuf(&gGraphicsDevice, gGraphicsDevice.screen);
+}
+
 static menu_t* MenuCreateStart(const char *name, MenuSystem *ms, LoopRunner *l,
 		custom_campaigns_t *campaigns);
 static menu_t* MenuCreateOptions(const char *name, MenuSystem *ms);
@@ -264,7 +315,8 @@ static void StartGameMode(menu_t *menu, void *data) {
 	UNUSED(menu);
 	StartGameModeData *mData = static_cast<StartGameModeData*>(data);
 	gCampaign.Entry.Mode = mData->GameMode;
-	if (!CampaignLoad(&gCampaign, mData->Entry)) {
+	// The loading screen takes over once the menu exits
+	if (!CampaignLoadBegin(&gCampaign, mData->Entry)) {
 		// Failed to load
 		printf("Error: cannot load campaign %s\n", mData->Entry->Info);
 	}
@@ -0,0 +1,106 @@
+/*
+ C-Dogs SDL
+ A port of the legendary (and fun) action/arcade cdogs.
+
+ Copyright (c) 2020 Cong Xu
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <cdogs/draw/draw_actor.h>
+#include <cdogs/font.h>
+#include <cdogs/grafx.h>
+#include <cdogs/grafx_bg.h>
+#include <cdogs/hud/hud.h>
+#include <cdogs/hud/hud_num_popup.h>
+#include <cdogs/texture.h>
+
+// Graphics for the headless server, which has no window or renderer; only the
+// pixel format is used, for loading pics. Everything else is a no-op
+
+GraphicsDevice gGraphicsDevice;
+
+void GraphicsInitialize(GraphicsDevice *g) {
+	UNUSED(g);
+}
+void GraphicsConfigSet(GraphicsConfig *c, struct vec2i res,
+		const bool fullscreen, const int scaleFactor, const ScaleMode scaleMode,
+		const int brightness, const bool secondWindow) {
+	UNUSED(c);
+	UNUSED(res);
+	UNUSED(fullscreen);
+	UNUSED(scaleFactor);
+	UNUSED(scaleMode);
+	UNUSED(brightness);
+	UNUSED(secondWindow);
+}
+void GraphicsConfigSetFromConfig(GraphicsConfig *gc, Config *c) {
+	UNUSED(gc);
+	UNUSED(c);
+}
+void GrafxMakeRandomBackground(GraphicsDevice *device, CampaignOptions *co,
+		struct MissionOptions *mo, Map *map) {
+	UNUSED(device);
+	UNUSED(co);
+	UNUSED(mo);
+	UNUSED(map);
+}
+void TextureRender(SDL_Texture *t, SDL_Renderer *r, const Rect2i src,
+		const Rect2i dest, const color_t mask, const double angle,
+		const SDL_RendererFlip flip) {
+	UNUSED(t);
+	UNUSED(r);
+	UNUSED(src);
+	UNUSED(dest);
+	UNUSED(mask);
+	UNUSED(angle);
+	UNUSED(flip);
+}
+
+FontOpts FontOptsNew(void) {
+	FontOpts opts;
+	memset(&opts, 0, sizeof opts);
+	return opts;
+}
+void FontStrOpt(const char *s, struct vec2i pos, const FontOpts opts) {
+	UNUSED(s);
+	UNUSED(pos);
+	UNUSED(opts);
+}
+
+void HUDDisplayMessage(HUD *hud, const char *msg, int ticks) {
+	UNUSED(hud);
+	UNUSED(msg);
+	UNUSED(ticks);
+}
+void HUDNumPopupsAdd(HUDNumPopups *popups, const HUDNumPopupType type,
+		const int idxOrUID, const int amount) {
+	UNUSED(popups);
+	UNUSED(type);
+	UNUSED(idxOrUID);
+	UNUSED(amount);
+}
+
+// Actor sprites are only used for drawing
+void ActorLoadSprites(TActor *a) {
+	UNUSED(a);
+}
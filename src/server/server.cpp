@@ -0,0 +1,213 @@
+/*
+ C-Dogs SDL
+ A port of the legendary (and fun) action/arcade cdogs.
+
+ Copyright (c) 2020 Cong Xu
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <SDL2/SDL.h>
+
+#include <cdogs/ammo.h>
+#include <cdogs/asset_pack.h>
+#include <cdogs/campaigns.h>
+#include <cdogs/character_class.h>
+#include <cdogs/collision/collision.h>
+#include <cdogs/config_io.h>
+#include <cdogs/draw/char_sprites.h>
+#include <cdogs/events.h>
+#include <cdogs/files.h>
+#include <cdogs/game_events.h>
+#include <cdogs/grafx.h>
+#include <cdogs/log.h>
+#include <cdogs/mission.h>
+#include <cdogs/net_client.h>
+#include <cdogs/net_server.h>
+#include <cdogs/objs.h>
+#include <cdogs/particle.h>
+#include <cdogs/pic_manager.h>
+#include <cdogs/pickup.h>
+#include <cdogs/sounds.h>
+
+#include "command_line.h"
+#include "server_game.h"
+
+// Dedicated server: hosts a campaign for remote players, without a window,
+// audio or input devices
+
+static void OnSignal(int sig) {
+	UNUSED(sig);
+	gEventHandlers.HasQuit = true;
+}
+
+int main(int argc, char *argv[]) {
+	int err = 0;
+	const char *loadCampaign = NULL;
+	ENetAddress connectAddr;
+	memset(&connectAddr, 0, sizeof connectAddr);
+	CampaignEntry entry;
+	LoopRunner l;
+
+	srand((unsigned int) time(NULL));
+	LogInit();
+
+	PrintTitle();
+	SetupConfigDir();
+	gConfig = ConfigLoad(GetConfigFilePath(CONFIG_FILE));
+
+	if (enet_initialize() != 0) {
+		LOG(LM_MAIN, LL_ERROR, "An error occurred while initializing ENet.");
+		err = EXIT_FAILURE;
+		goto bail;
+	}
+	// The game loop polls the client too; it just never connects
+	NetClientInit(&gNetClient);
+
+	// Print command line
+	char buf[CDOGS_PATH_MAX];
+	ProcessCommandLine(buf, argc, argv);
+	LOG(LM_MAIN, LL_INFO, "Command line (%d args):%s", argc, buf);
+	if (!ParseArgs(argc, argv, &connectAddr, &loadCampaign)) {
+		goto bail;
+	}
+	if (loadCampaign == NULL) {
+		printf("Usage: %s [options] <campaign>\n", argv[0]);
+		err = EXIT_FAILURE;
+		goto bail;
+	}
+
+	// Only for SDL_GetTicks and SDL_Delay
+	if (SDL_Init(SDL_INIT_TIMER) != 0) {
+		LOG(LM_MAIN, LL_ERROR, "Could not initialise SDL: %s", SDL_GetError());
+		err = EXIT_FAILURE;
+		goto bail;
+	}
+
+	GetDataFilePath(buf, "");
+	LOG(LM_MAIN, LL_INFO, "data dir(%s)", buf);
+	LOG(LM_MAIN, LL_INFO, "config dir(%s)", GetConfigFilePath(""));
+
+	// Load assets from the pack if there is one, otherwise from loose files
+	AssetPackInit(&gAssetPack);
+	{
+		char packPath[CDOGS_PATH_MAX];
+		GetDataFilePath(packPath, ASSET_PACK_FILE);
+		AssetPackOpen(&gAssetPack, packPath, buf);
+	}
+
+	SoundInitialize(&gSoundDevice, "sounds");
+	NetServerInit(&gNetServer);
+	// Pics are loaded without textures, but their pixel data is still
+	// converted using the graphics device format
+	gGraphicsDevice.Format = SDL_AllocFormat(SDL_PIXELFORMAT_RGBA8888);
+	if (gGraphicsDevice.Format == NULL) {
+		LOG(LM_MAIN, LL_ERROR, "Could not allocate pixel format: %s",
+				SDL_GetError());
+		err = EXIT_FAILURE;
+		goto bail;
+	}
+	PicManagerInit(&gPicManager);
+	TileClassesInit(&gTileClasses);
+	PicManagerLoad(&gPicManager);
+	CharSpriteClassesInit(&gCharSpriteClasses);
+
+	ParticleClassesInit(&gParticleClasses, "data/particles.json");
+	AmmoInitialize(&gAmmo, "data/ammo.json");
+	BulletAndWeaponInitialize(&gBulletClasses, &gWeaponClasses,
+			"data/bullets.json", "data/guns.json");
+	CharacterClassesInitialize(&gCharacterClasses,
+			"data/character_classes.json");
+	PickupClassesInit(&gPickupClasses, "data/pickups.json", &gAmmo,
+			&gWeaponClasses);
+	MapObjectsInit(&gMapObjects, "data/map_objects.json", &gAmmo,
+			&gWeaponClasses);
+	CollisionSystemInit(&gCollisionSystem);
+	CampaignInit(&gCampaign);
+	PlayerDataInit(&gPlayerDatas);
+	GameEventsInit(&gGameEvents);
+
+	LOG(LM_MAIN, LL_INFO, "Loading campaign %s...", loadCampaign);
+	gCampaign.Entry.Mode =
+			strstr(loadCampaign, "/" CDOGS_DOGFIGHT_DIR "/") != NULL ?
+					GAME_MODE_DOGFIGHT : GAME_MODE_NORMAL;
+	if (!CampaignEntryTryLoad(&entry, loadCampaign, GAME_MODE_NORMAL)
+			|| !CampaignLoad(&gCampaign, &entry)) {
+		LOG(LM_MAIN, LL_ERROR, "Failed to load campaign %s", loadCampaign);
+		err = EXIT_FAILURE;
+		goto bail;
+	}
+
+	// The game code checks this to see if it is hosting
+	ConfigGet(&gConfig, "StartServer")->u.Bool.Value = true;
+	NetServerOpen(&gNetServer);
+	if (gNetServer.server == NULL) {
+		err = EXIT_FAILURE;
+		goto bail;
+	}
+
+	signal(SIGINT, OnSignal);
+	signal(SIGTERM, OnSignal);
+
+	LOG(LM_MAIN, LL_INFO, "Starting server");
+	l = LoopRunnerNew(ServerGame());
+	LoopRunnerRun(&l);
+	LoopRunnerTerminate(&l);
+
+	bail: NetServerTerminate(&gNetServer);
+	GameEventsTerminate(&gGameEvents);
+	MapTerminate(&gMap);
+	PlayerDataTerminate(&gPlayerDatas);
+	MapObjectsTerminate(&gMapObjects);
+	PickupClassesTerminate(&gPickupClasses);
+	ParticleClassesTerminate(&gParticleClasses);
+	AmmoTerminate(&gAmmo);
+	WeaponClassesTerminate(&gWeaponClasses);
+	BulletTerminate(&gBulletClasses);
+	CharacterClassesTerminate(&gCharacterClasses);
+	MissionOptionsTerminate(&gMission);
+	NetClientTerminate(&gNetClient);
+	atexit(enet_deinitialize);
+	CampaignTerminate(&gCampaign);
+	CollisionSystemTerminate(&gCollisionSystem);
+
+	CharSpriteClassesTerminate(&gCharSpriteClasses);
+	TileClassesTerminate(&gTileClasses);
+	PicManagerTerminate(&gPicManager);
+	if (gGraphicsDevice.Format != NULL) {
+		SDL_FreeFormat(gGraphicsDevice.Format);
+	}
+	SoundTerminate(&gSoundDevice, false);
+	AssetPackTerminate(&gAssetPack);
+	ConfigDestroy(&gConfig);
+	LogTerminate();
+
+	SDL_Quit();
+
+	return err;
+}
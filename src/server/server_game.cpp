@@ -0,0 +1,233 @@
+/*
+ C-Dogs SDL
+ A port of the legendary (and fun) action/arcade cdogs.
+
+ Copyright (c) 2020 Cong Xu
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "server_game.h"
+
+#include <time.h>
+
+#include <cdogs/actors.h>
+#include <cdogs/ai.h>
+#include <cdogs/events.h>
+#include <cdogs/game_events.h>
+#include <cdogs/gamedata.h>
+#include <cdogs/handle_game_events.h>
+#include <cdogs/log.h>
+#include <cdogs/los.h>
+#include <cdogs/map_build.h>
+#include <cdogs/net_server.h>
+#include <cdogs/objs.h>
+#include <cdogs/particle.h>
+#include <cdogs/pickup.h>
+#include <cdogs/powerup.h>
+
+typedef struct {
+	PowerupSpawner healthSpawner;
+	CArray ammoSpawners;	// of PowerupSpawner
+	int aiUpdateCounter;
+} ServerGameData;
+
+static void ServerGameTerminate(GameLoopData *data);
+static void ServerGameOnEnter(GameLoopData *data);
+static void ServerGameOnExit(GameLoopData *data);
+static void ServerGameInput(GameLoopData *data);
+static GameLoopResult ServerGameUpdate(GameLoopData *data, LoopRunner *l);
+GameLoopData* ServerGame(void) {
+	ServerGameData *data;
+	CCALLOC(data, sizeof *data);
+	GameLoopData *g = GameLoopDataNew(data, ServerGameTerminate,
+			ServerGameOnEnter, ServerGameOnExit, ServerGameInput,
+			ServerGameUpdate, NULL);
+	g->FPS = ConfigGetInt(&gConfig, "Game.FPS");
+	return g;
+}
+static void ServerGameTerminate(GameLoopData *data) {
+	ServerGameData *sData = static_cast<ServerGameData*>(data->Data);
+
+	CFREE(sData);
+}
+static void ServerGameOnEnter(GameLoopData *data) {
+	ServerGameData *sData = static_cast<ServerGameData*>(data->Data);
+
+	MissionOptionsTerminate(&gMission);
+	CampaignAndMissionSetup(&gCampaign, &gMission);
+	LOG(LM_MAIN, LL_INFO, "starting mission %d/%d: %s",
+			gCampaign.MissionIndex + 1, (int) gCampaign.Setting.Missions.size,
+			gMission.missionData->Title);
+	MapBuild(&gMap, gMission.missionData, &gCampaign);
+
+	if (IsPVP(gCampaign.Entry.Mode)) {
+		// Seed random so that players don't always spawn in the same place
+		srand((unsigned int) time(NULL));
+		MapMarkAllAsVisited(&gMap);
+	} else {
+		InitializeBadGuys();
+		CreateEnemies();
+	}
+
+	HealthSpawnerInit(&sData->healthSpawner, &gMap);
+	CArrayInit(&sData->ammoSpawners, sizeof(PowerupSpawner));
+	for (int i = 0; i < AmmoGetNumClasses(&gAmmo); i++) {
+		PowerupSpawner ps;
+		AmmoSpawnerInit(&ps, &gMap, i);
+		CArrayPushBack(&sData->ammoSpawners, &ps);
+	}
+
+	gMission.state = MISSION_STATE_WAITING;
+	gMission.isDone = false;
+	gMission.DoneCounter = 0;
+
+	// Clients that are ready will join straight away; the rest will join
+	// when they ready up
+	NetServerSendGameStartMessages(&gNetServer, NET_SERVER_BCAST);
+	GameEvent start = GameEventNew(GAME_EVENT_GAME_START);
+	GameEventsEnqueue(&gGameEvents, start);
+}
+static void ServerGameOnExit(GameLoopData *data) {
+	ServerGameData *sData = static_cast<ServerGameData*>(data->Data);
+
+	LOG(LM_MAIN, LL_INFO, "mission finished");
+
+	// Flush events
+	HandleGameEvents(&gGameEvents, NULL, &sData->healthSpawner,
+			&sData->ammoSpawners);
+
+	PowerupSpawnerTerminate(&sData->healthSpawner);
+	CA_FOREACH(PowerupSpawner, a, sData->ammoSpawners)
+		PowerupSpawnerTerminate(a);
+	CA_FOREACH_END()
+	CArrayTerminate(&sData->ammoSpawners);
+
+	// Players need to ready up again for the next mission, keeping their
+	// remaining health if they survived
+	CA_FOREACH(PlayerData, p, gPlayerDatas)
+		p->Ready = false;
+		p->survived = IsPlayerAlive(p);
+		if (p->survived) {
+			p->hp = ActorGetByUID(p->ActorUID)->health;
+		}
+	CA_FOREACH_END()
+}
+static void ServerGameInput(GameLoopData *data) {
+	UNUSED(data);
+	// Set by signal handlers
+	if (gEventHandlers.HasQuit && !gMission.isDone) {
+		GameEvent e = GameEventNew(GAME_EVENT_MISSION_END);
+		e.u.MissionEnd.IsQuit = true;
+		GameEventsEnqueue(&gGameEvents, e);
+	}
+}
+static void NextMission(void);
+static GameLoopResult ServerGameUpdate(GameLoopData *data, LoopRunner *l) {
+	ServerGameData *sData = static_cast<ServerGameData*>(data->Data);
+
+	// Detect exit
+	if (gMission.isDone) {
+		gMission.DoneCounter--;
+		if (gMission.DoneCounter <= 0) {
+			if (gMission.IsQuit) {
+				LoopRunnerPop(l);
+			} else {
+				NextMission();
+				LoopRunnerChange(l, ServerGame());
+			}
+		}
+		return UPDATE_RESULT_OK;
+	}
+
+	// Check if game can begin
+	if (!gMission.HasBegun && MissionCanBegin()) {
+		GameEvent begin = GameEventNew(GAME_EVENT_GAME_BEGIN);
+		begin.u.GameBegin.MissionTime = gMission.time;
+		GameEventsEnqueue(&gGameEvents, begin);
+	}
+
+	// Set mission complete and display exit if it is complete
+	MissionSetMessageIfComplete(&gMission);
+
+	// Update all the things in the game
+	const int ticksPerFrame = 1;
+
+	// Explore tiles around all players alive or dying; commands for their
+	// actors come from the clients
+	LOSReset(&gMap.LOS);
+	CA_FOREACH(const PlayerData, p, gPlayerDatas)
+		if (p->ActorUID == -1) {
+			continue;
+		}
+		const TActor *player = ActorGetByUID(p->ActorUID);
+		if (player->dead > DEATH_MAX) {
+			continue;
+		}
+		LOSCalcFrom(&gMap, Vec2ToTile(player->thing.Pos), true);
+	CA_FOREACH_END()
+
+	sData->aiUpdateCounter -= ticksPerFrame;
+	if (sData->aiUpdateCounter <= 0) {
+		const int enemies = AICommand(ticksPerFrame);
+		AIAddRandomEnemies(enemies, gMission.missionData);
+		sData->aiUpdateCounter = 4;
+	} else {
+		AICommandLast(ticksPerFrame);
+	}
+
+	UpdateAllActors(ticksPerFrame);
+	UpdateObjects(ticksPerFrame);
+	UpdateMobileObjects(ticksPerFrame);
+	PickupsUpdate(&gPickups, ticksPerFrame);
+	ParticlesUpdate(&gParticles, ticksPerFrame);
+
+	UpdateWatches(&gMap.triggers, ticksPerFrame);
+
+	PowerupSpawnerUpdate(&sData->healthSpawner, ticksPerFrame);
+	CA_FOREACH(PowerupSpawner, a, sData->ammoSpawners)
+		PowerupSpawnerUpdate(a, ticksPerFrame);
+	CA_FOREACH_END()
+
+	MissionCheckCompletion(&gMission);
+
+	HandleGameEvents(&gGameEvents, NULL, &sData->healthSpawner,
+			&sData->ammoSpawners);
+
+	NetServerSendSnapshot(&gNetServer);
+
+	gMission.time += ticksPerFrame;
+
+	return UPDATE_RESULT_OK;
+}
+static void NextMission(void) {
+	// Move on if the mission was completed; otherwise replay it
+	const bool completed = GetNumPlayers(PLAYER_ALIVE, false, false) > 0
+			&& MissionAllObjectivesComplete(&gMission);
+	if (!completed || HasRounds(gCampaign.Entry.Mode)) {
+		return;
+	}
+	// Start the campaign again after the last mission, so that the server
+	// keeps running
+	gCampaign.MissionIndex = (gCampaign.MissionIndex + 1)
+			% (int) gCampaign.Setting.Missions.size;
+}
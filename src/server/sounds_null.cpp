@@ -0,0 +1,142 @@
+/*
+ C-Dogs SDL
+ A port of the legendary (and fun) action/arcade cdogs.
+
+ Copyright (c) 2020 Cong Xu
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <cdogs/music.h>
+#include <cdogs/sounds.h>
+
+// Sound and music for the headless server, which has no audio device;
+// everything is a no-op, and sounds are never loaded
+
+SoundDevice gSoundDevice;
+
+MusicType& operator++(MusicType &d) {
+	return d = static_cast<MusicType>(static_cast<int>(d) + 1);
+}
+
+void SoundInitialize(SoundDevice *device, const char *path) {
+	UNUSED(path);
+	memset(device, 0, sizeof *device);
+}
+void SoundLoadDir(map_t sounds, const char *path, const char *prefix) {
+	UNUSED(sounds);
+	UNUSED(path);
+	UNUSED(prefix);
+}
+void SoundReconfigure(SoundDevice *s) {
+	UNUSED(s);
+}
+void SoundReopen(SoundDevice *s) {
+	UNUSED(s);
+}
+void SoundClear(map_t sounds) {
+	UNUSED(sounds);
+}
+void SoundTerminate(SoundDevice *device, const bool waitForSoundsComplete) {
+	UNUSED(device);
+	UNUSED(waitForSoundsComplete);
+}
+void SoundPlay(SoundDevice *device, Mix_Chunk *data) {
+	UNUSED(device);
+	UNUSED(data);
+}
+void SoundSetEarsSide(const bool isLeft, const struct vec2 pos) {
+	UNUSED(isLeft);
+	UNUSED(pos);
+}
+void SoundSetEar(const bool isLeft, const int idx, const struct vec2 pos) {
+	UNUSED(isLeft);
+	UNUSED(idx);
+	UNUSED(pos);
+}
+void SoundSetEars(const struct vec2 pos) {
+	UNUSED(pos);
+}
+void SoundPlayAt(SoundDevice *device, Mix_Chunk *data, const struct vec2 pos) {
+	UNUSED(device);
+	UNUSED(data);
+	UNUSED(pos);
+}
+void SoundPlayAtPlusDistance(SoundDevice *device, Mix_Chunk *data,
+		const struct vec2 pos, const int plusDistance) {
+	UNUSED(device);
+	UNUSED(data);
+	UNUSED(pos);
+	UNUSED(plusDistance);
+}
+Mix_Chunk* StrSound(const char *s) {
+	UNUSED(s);
+	return NULL;
+}
+void SoundPrefetch(SoundDevice *device, Mix_Chunk *data) {
+	UNUSED(device);
+	UNUSED(data);
+}
+void SoundPrefetchStr(SoundDevice *device, const char *s) {
+	UNUSED(device);
+	UNUSED(s);
+}
+
+bool MusicIsSupported(const char *path) {
+	UNUSED(path);
+	return false;
+}
+Mix_Music* MusicLoad(const char *path) {
+	UNUSED(path);
+	return NULL;
+}
+void MusicPlay(SoundDevice *device, const MusicType type,
+		const char *missionPath, const char *music) {
+	UNUSED(device);
+	UNUSED(type);
+	UNUSED(missionPath);
+	UNUSED(music);
+}
+void MusicPrefetch(SoundDevice *device, const MusicType type) {
+	UNUSED(device);
+	UNUSED(type);
+}
+void MusicPrefetchClear(SoundDevice *device) {
+	UNUSED(device);
+}
+void MusicStop(SoundDevice *device) {
+	UNUSED(device);
+}
+void MusicPause(SoundDevice *s) {
+	UNUSED(s);
+}
+void MusicResume(SoundDevice *device) {
+	UNUSED(device);
+}
+void MusicSetPlaying(SoundDevice *device, int isPlaying) {
+	UNUSED(device);
+	UNUSED(isPlaying);
+}
+const char* MusicGetErrorMessage(SoundDevice *device) {
+	UNUSED(device);
+	return "";
+}
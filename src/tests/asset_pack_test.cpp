@@ -0,0 +1,111 @@
+#include <cbehave/cbehave.h>
+
+#include <asset_pack.h>
+#include <sys_config.h>
+#include <sys_specifics.h>
+
+#include <string.h>
+
+#define ROOT "/tmp/asset_pack_test"
+#define PACK ROOT "/" ASSET_PACK_FILE
+
+static void WriteFile(const char *rel, const char *s) {
+	char path[CDOGS_PATH_MAX];
+	sprintf(path, "%s/%s", ROOT, rel);
+	FILE *f = fopen(path, "w");
+	fputs(s, f);
+	fclose(f);
+}
+static bool BuildPack(void) {
+	mkdir(ROOT, MKDIR_MODE);
+	mkdir(ROOT "/data", MKDIR_MODE);
+	mkdir(ROOT "/data/sub", MKDIR_MODE);
+	mkdir(ROOT "/other", MKDIR_MODE);
+	WriteFile("data/b.txt", "bee");
+	WriteFile("data/a.txt", "ay");
+	WriteFile("data/sub/c.txt", "sea");
+	WriteFile("data/.hidden", "skipped");
+	WriteFile("other/d.txt", "dee");
+	const char *dirs[] = { "data", "other" };
+	return AssetPackBuild(PACK, ROOT, dirs, 2);
+}
+
+FEATURE(AssetPackBuild, "Build and read asset packs")
+	SCENARIO("Find packed files")
+		GIVEN("a pack built from some dirs")
+		const bool built = BuildPack();
+		AssetPack p;
+		AssetPackInit(&p);
+
+		WHEN("I open it")
+		const bool opened = AssetPackOpen(&p, PACK, ROOT);
+
+		THEN("the files should be found by their full paths")
+		SHOULD_BE_TRUE(built);
+		SHOULD_BE_TRUE(opened);
+		SHOULD_INT_EQUAL((int) p.Count, 4);
+		AssetPackFile f;
+		SHOULD_BE_TRUE(AssetPackFind(&p, ROOT "/data/sub/c.txt", &f));
+		SHOULD_INT_EQUAL((int) f.Size, 3);
+		SHOULD_MEM_EQUAL(f.Data, "sea", 3);
+		SHOULD_BE_TRUE(AssetPackFind(&p, ROOT "\\other\\d.txt", &f));
+		SHOULD_MEM_EQUAL(f.Data, "dee", 3);
+		AND("other files should not")
+		SHOULD_BE_FALSE(AssetPackFind(&p, ROOT "/data/.hidden", &f));
+		SHOULD_BE_FALSE(AssetPackFind(&p, ROOT "/data/sub", &f));
+		SHOULD_BE_FALSE(AssetPackFind(&p, "/elsewhere/data/a.txt", &f));
+		AssetPackTerminate(&p);
+		SCENARIO_END
+
+	SCENARIO("List a packed dir")
+		GIVEN("a pack built from some dirs")
+		BuildPack();
+		AssetPack p;
+		AssetPackInit(&p);
+		AssetPackOpen(&p, PACK, ROOT);
+
+		WHEN("I list a dir")
+		AssetPackDir d;
+		const bool hasFiles = AssetPackDirOpen(&d, &p, ROOT "/data/");
+
+		THEN("its files should be listed in order, recursively")
+		SHOULD_BE_TRUE(hasFiles);
+		SHOULD_BE_TRUE(AssetPackDirNext(&d));
+		SHOULD_STR_EQUAL(d.Name, "a.txt");
+		SHOULD_STR_EQUAL(d.Path, ROOT "/data/a.txt");
+		SHOULD_BE_TRUE(AssetPackDirNext(&d));
+		SHOULD_STR_EQUAL(d.Name, "b.txt");
+		SHOULD_BE_TRUE(AssetPackDirNext(&d));
+		SHOULD_STR_EQUAL(d.Name, "sub/c.txt");
+		SHOULD_BE_FALSE(AssetPackDirNext(&d));
+		AND("dirs without files should be empty")
+		SHOULD_BE_FALSE(AssetPackDirOpen(&d, &p, ROOT "/dat"));
+		AssetPackTerminate(&p);
+		SCENARIO_END
+
+	SCENARIO("Open packed files")
+		GIVEN("the game's pack")
+		BuildPack();
+		AssetPackInit(&gAssetPack);
+		AssetPackOpen(&gAssetPack, PACK, ROOT);
+
+		WHEN("I open a packed file for reading")
+		FILE *f = AssetFOpen(ROOT "/data/b.txt", "r");
+
+		THEN("it should read the packed data")
+		SHOULD_BE_TRUE(f != NULL);
+		char buf[8] = "";
+		SHOULD_BE_TRUE(fgets(buf, sizeof buf, f) != NULL);
+		SHOULD_STR_EQUAL(buf, "bee");
+		fclose(f);
+		AND("it should not open for writing")
+		SHOULD_BE_TRUE(AssetFOpen(ROOT "/data/b.txt", "w") == NULL);
+		SHOULD_BE_TRUE(AssetFOpen(ROOT "/data/b.txt", "r+") == NULL);
+		AssetPackTerminate(&gAssetPack);
+		SCENARIO_END
+	FEATURE_END
+
+CBEHAVE_RUN(
+		"AssetPack features are:",
+		TEST_FEATURE(AssetPackBuild)
+)
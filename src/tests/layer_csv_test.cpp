@@ -0,0 +1,167 @@
+#include <cbehave/cbehave.h>
+
+#include <layer_csv.h>
+
+#include <string.h>
+
+static bool LoadRow(CArray *layer, const int size, const char *s) {
+	return LayerCSVLoadRow(layer, size, s, strlen(s));
+}
+
+FEATURE(LayerCSVSaveRow, "Save layer rows")
+	SCENARIO("Save runs of the same value")
+		GIVEN("a row with a long run, a short run and single values")
+		const int values[] = { 4, 4, 4, 4, 1, 1, 2, -3, -3, -3 };
+		const int width = (int) (sizeof values / sizeof values[0]);
+		CArray layer;
+		CArrayInit(&layer, sizeof(int));
+		for (int i = 0; i < width; i++) {
+			CArrayPushBack(&layer, &values[i]);
+		}
+
+		WHEN("I save the row")
+		char buf[LAYER_CSV_ROW_MAX(width)];
+		LayerCSVSaveRow(buf, &layer, width, 0);
+
+		THEN("only runs of three or more should be value*count")
+		SHOULD_STR_EQUAL(buf, "4*4,1,1,2,-3*3");
+		CArrayTerminate(&layer);
+		SCENARIO_END
+
+	SCENARIO("Round trip")
+		GIVEN("a layer of two rows")
+		const int values[] = { 7, 7, 7, 0, 9, 9, 9, 9, 9, 9 };
+		const int width = 5;
+		const int size = (int) (sizeof values / sizeof values[0]);
+		CArray layer;
+		CArrayInit(&layer, sizeof(int));
+		for (int i = 0; i < size; i++) {
+			CArrayPushBack(&layer, &values[i]);
+		}
+
+		WHEN("I save each row and load them back")
+		CArray loaded;
+		CArrayInit(&loaded, sizeof(int));
+		bool ok = true;
+		for (int i = 0; i < size / width; i++) {
+			char buf[LAYER_CSV_ROW_MAX(width)];
+			LayerCSVSaveRow(buf, &layer, width, i);
+			ok = ok && LoadRow(&loaded, size, buf);
+		}
+
+		THEN("the layers should be the same")
+		SHOULD_BE_TRUE(ok);
+		SHOULD_INT_EQUAL((int) loaded.size, size);
+		SHOULD_MEM_EQUAL(loaded.data, layer.data, sizeof values);
+		CArrayTerminate(&layer);
+		CArrayTerminate(&loaded);
+		SCENARIO_END
+	FEATURE_END
+
+FEATURE(LayerCSVLoadRow, "Load layer rows")
+	SCENARIO("Load old rows without runs")
+		GIVEN("a row of plain values, with an empty value")
+		CArray layer;
+		CArrayInit(&layer, sizeof(int));
+
+		WHEN("I load it")
+		const bool ok = LoadRow(&layer, 4, "3,,-1,0,12");
+
+		THEN("it should load the values")
+		SHOULD_BE_TRUE(ok);
+		SHOULD_INT_EQUAL((int) layer.size, 4);
+		SHOULD_INT_EQUAL(*(int*) CArrayGet(&layer, 1), -1);
+		SHOULD_INT_EQUAL(*(int*) CArrayGet(&layer, 3), 12);
+		CArrayTerminate(&layer);
+		SCENARIO_END
+
+	SCENARIO("Reject runs longer than the layer")
+		GIVEN("a row with a huge run")
+		CArray layer;
+		CArrayInit(&layer, sizeof(int));
+
+		WHEN("I load it into a small layer")
+		const bool ok = LoadRow(&layer, 10, "1,2*2000000000");
+
+		THEN("it should fail, and only fill the layer")
+		SHOULD_BE_FALSE(ok);
+		SHOULD_INT_EQUAL((int) layer.size, 10);
+		SHOULD_INT_EQUAL(*(int*) CArrayGet(&layer, 9), 2);
+		CArrayTerminate(&layer);
+		SCENARIO_END
+
+	SCENARIO("Reject counts that overflow")
+		GIVEN("a row with a count too big for an int")
+		CArray layer;
+		CArrayInit(&layer, sizeof(int));
+
+		WHEN("I load it")
+		const bool ok = LoadRow(&layer, 10, "5*99999999999999999999");
+
+		THEN("it should fail without adding more than the layer size")
+		SHOULD_BE_FALSE(ok);
+		SHOULD_INT_EQUAL((int) layer.size, 10);
+		CArrayTerminate(&layer);
+		SCENARIO_END
+
+	SCENARIO("Reject empty and negative counts")
+		GIVEN("rows with runs of zero, negative and missing counts")
+		const char *rows[] = { "1*0", "1*-5", "1*" };
+
+		WHEN("I load them")
+
+		THEN("they should fail without adding values")
+		for (int i = 0; i < (int) (sizeof rows / sizeof rows[0]); i++) {
+			CArray layer;
+			CArrayInit(&layer, sizeof(int));
+			SHOULD_BE_FALSE(LoadRow(&layer, 10, rows[i]));
+			SHOULD_INT_EQUAL((int) layer.size, 0);
+			CArrayTerminate(&layer);
+		}
+		SCENARIO_END
+
+	SCENARIO("Reject malformed runs")
+		GIVEN("rows with a run missing its value, and a run of runs")
+		const char *rows[] = { "*5", "1*2*3", "*" };
+
+		WHEN("I load them")
+
+		THEN("they should fail without adding values")
+		for (int i = 0; i < (int) (sizeof rows / sizeof rows[0]); i++) {
+			CArray layer;
+			CArrayInit(&layer, sizeof(int));
+			SHOULD_BE_FALSE(LoadRow(&layer, 10, rows[i]));
+			SHOULD_INT_EQUAL((int) layer.size, 0);
+			CArrayTerminate(&layer);
+		}
+		AND("the other values in the row should still load")
+		CArray layer;
+		CArrayInit(&layer, sizeof(int));
+		SHOULD_BE_FALSE(LoadRow(&layer, 10, "4,*5,6"));
+		SHOULD_INT_EQUAL((int) layer.size, 2);
+		SHOULD_INT_EQUAL(*(int*) CArrayGet(&layer, 1), 6);
+		CArrayTerminate(&layer);
+		SCENARIO_END
+
+	SCENARIO("Reject rows past the end of the layer")
+		GIVEN("a layer that is already full")
+		CArray layer;
+		CArrayInit(&layer, sizeof(int));
+		const bool first = LoadRow(&layer, 3, "1*3");
+
+		WHEN("I load another row")
+		const bool second = LoadRow(&layer, 3, "2");
+
+		THEN("the extra row should fail and not be added")
+		SHOULD_BE_TRUE(first);
+		SHOULD_BE_FALSE(second);
+		SHOULD_INT_EQUAL((int) layer.size, 3);
+		CArrayTerminate(&layer);
+		SCENARIO_END
+	FEATURE_END
+
+CBEHAVE_RUN(
+		"Layer CSV features are:",
+		TEST_FEATURE(LayerCSVSaveRow),
+		TEST_FEATURE(LayerCSVLoadRow)
+)
@@ -0,0 +1,146 @@
+#include <cbehave/cbehave.h>
+
+#include <json_utils.h>
+#include <map_archive.h>
+#include <map_compiled.h>
+#include <sys_config.h>
+#include <sys_specifics.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define ARCHIVE "/tmp/map_archive_test.cdogscpn"
+
+static void WriteFile(const char *name, const char *s) {
+	char path[CDOGS_PATH_MAX];
+	sprintf(path, "%s/%s", ARCHIVE, name);
+	FILE *f = fopen(path, "w");
+	fputs(s, f);
+	fclose(f);
+}
+// A version 15 archive with one static 4x2 mission, in plain CSV rows
+static void WriteArchive(void) {
+	char path[CDOGS_PATH_MAX];
+	sprintf(path, "%s/%s", ARCHIVE, MAP_COMPILED_FILE);
+	remove(path);
+	mkdir(ARCHIVE, MKDIR_MODE);
+	WriteFile("campaign.json",
+		"{\"Version\": 15, \"Title\": \"Test\", \"Missions\": 1}");
+	WriteFile("missions.json",
+		"{\"Missions\": [{\"Title\": \"Static\", \"Type\": \"Static\","
+		" \"Width\": 4, \"Height\": 2,"
+		" \"TileClasses\": {"
+		"  \"0\": {\"Name\": \"floor\", \"Type\": \"Floor\","
+		"   \"Style\": \"tile\", \"CanWalk\": true},"
+		"  \"1\": {\"Name\": \"wall\", \"Type\": \"Wall\","
+		"   \"Style\": \"brick\", \"IsOpaque\": true}},"
+		" \"Tiles\": [\"1,1,1,1\", \"1,0,0,0\"],"
+		" \"Access\": [\"0,0,0,0\", \"0,0,0,256\"]}]}");
+}
+static json_t* ReadJSON(const char *name) {
+	char path[CDOGS_PATH_MAX];
+	sprintf(path, "%s/%s", ARCHIVE, name);
+	FILE *f = fopen(path, "r");
+	if (f == NULL) {
+		return NULL;
+	}
+	json_t *root = NULL;
+	if (json_stream_parse(f, &root) != JSON_OK) {
+		root = NULL;
+	}
+	fclose(f);
+	return root;
+}
+static json_t* ReadMission(json_t *root) {
+	return json_find_first_label(root, "Missions")->child->child;
+}
+static int ReadVersion(void) {
+	json_t *root = ReadJSON("campaign.json");
+	int version = 0;
+	LoadInt(&version, root, "Version");
+	json_free_value(&root);
+	return version;
+}
+static bool FileExists(const char *name) {
+	char path[CDOGS_PATH_MAX];
+	sprintf(path, "%s/%s", ARCHIVE, name);
+	FILE *f = fopen(path, "r");
+	if (f != NULL) {
+		fclose(f);
+	}
+	return f != NULL;
+}
+static int LayerAt(const CArray *layer, const int i) {
+	return *(const int*) CArrayGet(layer, i);
+}
+
+FEATURE(MapArchiveCompile, "Compile and decompile archives")
+	SCENARIO("Compile an archive")
+		GIVEN("an archive with a static mission")
+		WriteArchive();
+
+		WHEN("I compile it")
+		const bool ok = MapArchiveCompile(ARCHIVE);
+
+		THEN("the layers should move into the compiled file")
+		SHOULD_BE_TRUE(ok);
+		json_t *root = ReadJSON("missions.json");
+		json_t *m = ReadMission(root);
+		SHOULD_BE_TRUE(json_find_first_label(m, "Tiles") == NULL);
+		SHOULD_BE_TRUE(json_find_first_label(m, "Access") == NULL);
+		SHOULD_BE_TRUE(json_find_first_label(m, "TileClasses") == NULL);
+		json_free_value(&root);
+		AND("older builds should reject the archive")
+		SHOULD_INT_EQUAL(ReadVersion(), MAP_VERSION);
+		AND("the compiled layers should load")
+		char path[CDOGS_PATH_MAX];
+		sprintf(path, "%s/%s", ARCHIVE, MAP_COMPILED_FILE);
+		MapCompiled mc;
+		SHOULD_BE_TRUE(MapCompiledOpen(&mc, path));
+		SHOULD_INT_EQUAL((int) mc.count, 1);
+		MissionStatic ms;
+		MissionStaticInit(&ms);
+		MapCompiledLoadStatic(&mc, 0, &ms);
+		SHOULD_INT_EQUAL((int) ms.Tiles.size, 8);
+		SHOULD_INT_EQUAL(LayerAt(&ms.Tiles, 5), 0);
+		SHOULD_INT_EQUAL(LayerAt(&ms.Access, 7), 256);
+		SHOULD_INT_EQUAL((int) hashmap_length(ms.TileClasses), 2);
+		MissionStaticTerminate(&ms);
+		MapCompiledClose(&mc);
+		SCENARIO_END
+
+	SCENARIO("Round trip an archive")
+		GIVEN("a compiled archive")
+		WriteArchive();
+		MapArchiveCompile(ARCHIVE);
+
+		WHEN("I decompile it and load the mission")
+		const bool ok = MapArchiveDecompile(ARCHIVE);
+		json_t *root = ReadJSON("missions.json");
+		MissionStatic ms;
+		MissionStaticInit(&ms);
+		const bool loaded = MissionStaticLoadTilesJSON(&ms,
+				ReadMission(root), svec2i(4, 2));
+
+		THEN("the layers should be back in missions.json")
+		SHOULD_BE_TRUE(ok);
+		SHOULD_BE_TRUE(loaded);
+		SHOULD_BE_FALSE(FileExists(MAP_COMPILED_FILE));
+		AND("the layers should be the same")
+		const int tiles[] = { 1, 1, 1, 1, 1, 0, 0, 0 };
+		SHOULD_INT_EQUAL((int) ms.Tiles.size, 8);
+		SHOULD_MEM_EQUAL(ms.Tiles.data, tiles, sizeof tiles);
+		SHOULD_INT_EQUAL((int) ms.Access.size, 8);
+		SHOULD_INT_EQUAL(LayerAt(&ms.Access, 7), 256);
+		SHOULD_INT_EQUAL((int) hashmap_length(ms.TileClasses), 2);
+		AND("the version should allow the run-length encoded rows")
+		SHOULD_INT_EQUAL(ReadVersion(), MAP_VERSION);
+		MissionStaticTerminate(&ms);
+		json_free_value(&root);
+		SCENARIO_END
+	FEATURE_END
+
+CBEHAVE_RUN(
+		"MapArchive features are:",
+		TEST_FEATURE(MapArchiveCompile)
+)
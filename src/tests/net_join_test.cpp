@@ -0,0 +1,218 @@
+#include <cbehave/cbehave.h>
+
+#include <actors.h>
+#include <game_events.h>
+#include <map.h>
+#include <net_join.h>
+#include <net_util.h>
+#include <objs.h>
+#include <pickup.h>
+
+#include <string.h>
+
+// Stubs
+Map gMap;
+CArray gActors;
+CArray gPickups;
+CArray gObjs;
+CArray gGameEvents;
+static TileClass sTileClasses[] = {
+	{ (char*) "floor" }, { (char*) "wall" }, { (char*) "" }
+};
+GameEventEntry GameEventGetEntry(const GameEventType e) {
+	GameEventEntry entry;
+	memset(&entry, 0, sizeof entry);
+	entry.Type = e;
+	return entry;
+}
+bool MissionHasRequiredObjectives(const struct MissionOptions *mo) {
+	UNUSED(mo);
+	return false;
+}
+ENetPacket* enet_packet_create(const void *data, size_t len, enet_uint32 f) {
+	UNUSED(data);
+	UNUSED(len);
+	UNUSED(f);
+	return NULL;
+}
+void enet_packet_destroy(ENetPacket *p) {
+	UNUSED(p);
+}
+int enet_packet_resize(ENetPacket *p, size_t len) {
+	UNUSED(p);
+	UNUSED(len);
+	return -1;
+}
+int enet_peer_send(ENetPeer *peer, enet_uint8 channel, ENetPacket *p) {
+	UNUSED(peer);
+	UNUSED(channel);
+	UNUSED(p);
+	return -1;
+}
+Tile* MapGetTile(const Map *map, const struct vec2i pos) {
+	return (Tile*) CArrayGet(&map->Tiles, pos.y * map->Size.x + pos.x);
+}
+void MapMarkAsVisited(Map *map, struct vec2i pos) {
+	MapGetTile(map, pos)->isVisited = true;
+}
+const TileClass* StrTileClass(const char *name) {
+	for (int i = 0; i < (int) (sizeof sTileClasses / sizeof sTileClasses[0]);
+			i++) {
+		if (strcmp(sTileClasses[i].Name, name) == 0) {
+			return &sTileClasses[i];
+		}
+	}
+	return NULL;
+}
+GameEvent GameEventNew(GameEventType type) {
+	GameEvent e;
+	memset(&e, 0, sizeof e);
+	e.Type = type;
+	return e;
+}
+void GameEventsEnqueue(CArray *store, GameEvent e) {
+	CArrayPushBack(store, &e);
+}
+
+static void SetupMap(const struct vec2i size) {
+	memset(&gMap, 0, sizeof gMap);
+	gMap.Size = size;
+	CArrayInit(&gMap.Tiles, sizeof(Tile));
+	for (int i = 0; i < size.x * size.y; i++) {
+		Tile t;
+		memset(&t, 0, sizeof t);
+		CArrayPushBack(&gMap.Tiles, &t);
+	}
+	CArrayInit(&gActors, sizeof(TActor));
+	CArrayInit(&gPickups, sizeof(Pickup));
+	CArrayInit(&gObjs, sizeof(TObject));
+	CArrayInit(&gGameEvents, sizeof(GameEvent));
+}
+static void TerminateMap(void) {
+	CArrayTerminate(&gMap.Tiles);
+	CArrayTerminate(&gActors);
+	CArrayTerminate(&gPickups);
+	CArrayTerminate(&gObjs);
+	CArrayTerminate(&gGameEvents);
+}
+
+FEATURE(NetJoinApply, "Apply join state")
+	SCENARIO("Round trip a map with entities")
+		GIVEN("a map with walls, explored tiles, and entities")
+		SetupMap(svec2i(5, 3));
+		for (int i = 0; i < 15; i++) {
+			Tile *t = (Tile*) CArrayGet(&gMap.Tiles, i);
+			t->Class = &sTileClasses[i % 4 == 0 ? 1 : 0];
+			t->isVisited = i >= 3 && i < 9;
+		}
+		TActor a;
+		memset(&a, 0, sizeof a);
+		a.isInUse = true;
+		a.uid = 7;
+		a.health = 42;
+		a.Pos = svec2(12, 34);
+		CArrayPushBack(&gActors, &a);
+		a.isInUse = false;
+		a.uid = 8;
+		CArrayPushBack(&gActors, &a);
+		PickupClass pc;
+		memset(&pc, 0, sizeof pc);
+		pc.Name = (char*) "health";
+		Pickup p;
+		memset(&p, 0, sizeof p);
+		p.isInUse = true;
+		p.UID = 3;
+		p.pickupClass = &pc;
+		CArrayPushBack(&gPickups, &p);
+		MapObject mo;
+		memset(&mo, 0, sizeof mo);
+		mo.Name = (char*) "barrel";
+		TObject o;
+		memset(&o, 0, sizeof o);
+		o.isInUse = true;
+		o.uid = 5;
+		o.Class = &mo;
+		o.Health = 9;
+		CArrayPushBack(&gObjs, &o);
+
+		WHEN("I write the join state and apply it to a blank map")
+		CArray buf;
+		CArrayInit(&buf, sizeof(uint8_t));
+		NetJoinWrite(&buf);
+		TerminateMap();
+		SetupMap(svec2i(5, 3));
+		const bool ok = NetJoinApply(&buf);
+
+		THEN("the tiles and explored state should match")
+		SHOULD_BE_TRUE(ok);
+		for (int i = 0; i < 15; i++) {
+			const Tile *t = (const Tile*) CArrayGet(&gMap.Tiles, i);
+			SHOULD_STR_EQUAL(t->Class->Name, i % 4 == 0 ? "wall" : "floor");
+			SHOULD_INT_EQUAL(t->isVisited, i >= 3 && i < 9);
+		}
+		AND("the entities in use should be added as events")
+		SHOULD_INT_EQUAL((int) gGameEvents.size, 3);
+		const GameEvent *e = (const GameEvent*) CArrayGet(&gGameEvents, 0);
+		SHOULD_INT_EQUAL(e->Type, GAME_EVENT_ACTOR_ADD);
+		SHOULD_INT_EQUAL(e->u.ActorAdd.UID, 7);
+		SHOULD_INT_EQUAL(e->u.ActorAdd.Health, 42);
+		e = (const GameEvent*) CArrayGet(&gGameEvents, 1);
+		SHOULD_INT_EQUAL(e->Type, GAME_EVENT_ADD_PICKUP);
+		SHOULD_INT_EQUAL(e->u.AddPickup.UID, 3);
+		SHOULD_STR_EQUAL(e->u.AddPickup.PickupClass, "health");
+		e = (const GameEvent*) CArrayGet(&gGameEvents, 2);
+		SHOULD_INT_EQUAL(e->Type, GAME_EVENT_MAP_OBJECT_ADD);
+		SHOULD_INT_EQUAL(e->u.MapObjectAdd.UID, 5);
+		SHOULD_STR_EQUAL(e->u.MapObjectAdd.MapObjectClass, "barrel");
+		SHOULD_INT_EQUAL(e->u.MapObjectAdd.Health, 9);
+
+		CArrayTerminate(&buf);
+		TerminateMap();
+		SCENARIO_END
+
+	SCENARIO("Reject a different map size")
+		GIVEN("a join state for one map")
+		SetupMap(svec2i(5, 3));
+		CArray buf;
+		CArrayInit(&buf, sizeof(uint8_t));
+		NetJoinWrite(&buf);
+		TerminateMap();
+
+		WHEN("I apply it to a map of a different size")
+		SetupMap(svec2i(3, 5));
+		const bool ok = NetJoinApply(&buf);
+
+		THEN("it should fail")
+		SHOULD_BE_FALSE(ok);
+		AND("no entities should be added")
+		SHOULD_INT_EQUAL((int) gGameEvents.size, 0);
+
+		CArrayTerminate(&buf);
+		TerminateMap();
+		SCENARIO_END
+
+	SCENARIO("Reject a truncated payload")
+		GIVEN("a join state that is cut short")
+		SetupMap(svec2i(5, 3));
+		CArray buf;
+		CArrayInit(&buf, sizeof(uint8_t));
+		NetJoinWrite(&buf);
+		TerminateMap();
+		CArrayResize(&buf, buf.size / 2, NULL);
+
+		WHEN("I apply it")
+		SetupMap(svec2i(5, 3));
+		const bool ok = NetJoinApply(&buf);
+
+		THEN("it should fail")
+		SHOULD_BE_FALSE(ok);
+
+		CArrayTerminate(&buf);
+		TerminateMap();
+		SCENARIO_END
+	FEATURE_END
+
+CBEHAVE_RUN(
+		"NetJoin features are:",
+		TEST_FEATURE(NetJoinApply)
+)
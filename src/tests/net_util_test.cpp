@@ -0,0 +1,158 @@
+#include <cbehave/cbehave.h>
+
+#include <net_util.h>
+
+#include <math.h>
+
+// Stubs
+GameEventEntry GameEventGetEntry(const GameEventType e) {
+	GameEventEntry entry;
+	memset(&entry, 0, sizeof entry);
+	entry.Type = e;
+	return entry;
+}
+bool MissionHasRequiredObjectives(const struct MissionOptions *mo) {
+	UNUSED(mo);
+	return false;
+}
+ENetPacket* enet_packet_create(const void *data, size_t len, enet_uint32 f) {
+	UNUSED(data);
+	UNUSED(len);
+	UNUSED(f);
+	return NULL;
+}
+void enet_packet_destroy(ENetPacket *p) {
+	UNUSED(p);
+}
+int enet_packet_resize(ENetPacket *p, size_t len) {
+	UNUSED(p);
+	UNUSED(len);
+	return -1;
+}
+int enet_peer_send(ENetPeer *peer, enet_uint8 channel, ENetPacket *p) {
+	UNUSED(peer);
+	UNUSED(channel);
+	UNUSED(p);
+	return -1;
+}
+
+// Difference between two angles, wrapped into [-pi, pi]
+static float AngleDiff(const float a, const float b) {
+	float d = fmodf(a - b, (float) (MPI * 2));
+	if (d > (float) MPI) {
+		d -= (float) (MPI * 2);
+	} else if (d < (float) -MPI) {
+		d += (float) (MPI * 2);
+	}
+	return fabsf(d);
+}
+
+FEATURE(RadiansToNet, "Angle conversion")
+	SCENARIO("Convert arbitrary angles")
+		GIVEN("angles that are not one of the 8 directions")
+		const float angles[] = { 0.1f, 1.0f, 2.5f, 3.0f, 4.2f, 6.2f };
+
+		WHEN("I convert them to net and back")
+
+		THEN("they should be within half a step of the original")
+		const float halfStep =
+				(float) MPI / (1 << NET_ANGLE_BITS_GUN_FIRE) + 1e-5f;
+		for (int i = 0; i < (int) (sizeof angles / sizeof angles[0]); i++) {
+			const float a = NetToRadians(
+					RadiansToNet(angles[i], NET_ANGLE_BITS_GUN_FIRE),
+					NET_ANGLE_BITS_GUN_FIRE);
+			SHOULD_BE_TRUE(AngleDiff(a, angles[i]) <= halfStep);
+		}
+		SCENARIO_END
+
+	SCENARIO("Convert directions")
+		GIVEN("angles that are exact fractions of a turn")
+
+		WHEN("I convert them to net")
+
+		THEN("they should be exact steps")
+		SHOULD_INT_EQUAL((int) RadiansToNet(0, 16), 0);
+		SHOULD_INT_EQUAL((int) RadiansToNet((float) MPI_2, 16), 1 << 14);
+		SHOULD_INT_EQUAL((int) RadiansToNet((float) MPI, 16), 1 << 15);
+		SHOULD_INT_EQUAL((int) RadiansToNet((float) MPI, 8), 1 << 7);
+		SCENARIO_END
+
+	SCENARIO("Wrap angles outside a turn")
+		GIVEN("angles of a full turn, or less than zero")
+
+		WHEN("I convert them to net")
+
+		THEN("they should wrap into the range of steps")
+		SHOULD_INT_EQUAL((int) RadiansToNet((float) (MPI * 2), 16), 0);
+		SHOULD_INT_EQUAL((int) RadiansToNet((float) (MPI * 4), 16), 0);
+		SHOULD_INT_EQUAL((int) RadiansToNet((float) -MPI_2, 16), 3 << 14);
+		SHOULD_INT_EQUAL(
+				(int) RadiansToNet((float) (MPI * 2) - 1e-6f, 16), 0);
+		SHOULD_INT_EQUAL((int) RadiansToNet(-1e-6f, 16), 0);
+		SHOULD_INT_LT((int) RadiansToNet(-0.01f, 8), 1 << 8);
+		SCENARIO_END
+	FEATURE_END
+
+FEATURE(Vec2ToNet, "Vector conversion")
+	SCENARIO("Convert fixed point vectors")
+		GIVEN("a vector in multiples of the net precision")
+		const struct vec2 v = svec2(123.0625f, -45.5f);
+
+		WHEN("I convert it to net and back")
+		const struct vec2 r = NetToVec2(Vec2ToNet(v));
+
+		THEN("it should be unchanged")
+		SHOULD_BE_TRUE(svec2_is_equal(v, r));
+		SCENARIO_END
+
+	SCENARIO("Convert arbitrary vectors")
+		GIVEN("vectors that are not multiples of the net precision")
+		const struct vec2 vs[] = {
+			svec2(0.7071f, -0.7071f), svec2(1.3f, 2.9f),
+			svec2(-0.01f, 0.01f), svec2(4000.123f, -3000.987f)
+		};
+
+		WHEN("I convert them to net and back")
+
+		THEN("they should be within half a step of the original")
+		const float halfStep = 0.5f / NET_VEC2_SCALE + 1e-3f;
+		for (int i = 0; i < (int) (sizeof vs / sizeof vs[0]); i++) {
+			const struct vec2 r = NetToVec2(Vec2ToNet(vs[i]));
+			SHOULD_BE_TRUE(fabsf(r.x - vs[i].x) <= halfStep);
+			SHOULD_BE_TRUE(fabsf(r.y - vs[i].y) <= halfStep);
+		}
+		SCENARIO_END
+
+	SCENARIO("Round halfway values")
+		GIVEN("components exactly halfway between two steps")
+		const struct vec2 v =
+				svec2(0.5f / NET_VEC2_SCALE, -0.5f / NET_VEC2_SCALE);
+
+		WHEN("I convert it to net")
+		const NVec2 nv = Vec2ToNet(v);
+
+		THEN("they should round away from zero, symmetrically")
+		SHOULD_INT_EQUAL(nv.x, 1);
+		SHOULD_INT_EQUAL(nv.y, -1);
+		SCENARIO_END
+
+	SCENARIO("Convert zero")
+		GIVEN("a zero vector, and one with tiny components")
+
+		WHEN("I convert them to net")
+		const NVec2 z = Vec2ToNet(svec2_zero());
+		const NVec2 t = Vec2ToNet(svec2(0.01f, -0.01f));
+
+		THEN("they should both be zero")
+		SHOULD_INT_EQUAL(z.x, 0);
+		SHOULD_INT_EQUAL(z.y, 0);
+		SHOULD_INT_EQUAL(t.x, 0);
+		SHOULD_INT_EQUAL(t.y, 0);
+		SCENARIO_END
+	FEATURE_END
+
+CBEHAVE_RUN(
+		"Net util features are:",
+		TEST_FEATURE(RadiansToNet),
+		TEST_FEATURE(Vec2ToNet)
+)
@@ -0,0 +1,184 @@
+#include <cbehave/cbehave.h>
+
+#include <color.h>
+#include <pixels.h>
+
+#include <stdlib.h>
+
+// Same layout as the graphics device format, ARGB8888
+static const PixelShifts shifts = { 16, 8, 0, 24 };
+static uint32_t ToPixel(const color_t c) {
+	return ((uint32_t) c.a << shifts.A) | ((uint32_t) c.r << shifts.R)
+			| ((uint32_t) c.g << shifts.G) | ((uint32_t) c.b << shifts.B);
+}
+static color_t ToColor(const uint32_t p) {
+	color_t c;
+	c.r = (uint8_t) (p >> shifts.R);
+	c.g = (uint8_t) (p >> shifts.G);
+	c.b = (uint8_t) (p >> shifts.B);
+	c.a = (uint8_t) (p >> shifts.A);
+	return c;
+}
+// Odd count so that the non-vectorised tail is covered too
+#define NUM_PIXELS 1023
+static void RandomPixels(uint32_t *pixels) {
+	srand(42);
+	for (int i = 0; i < NUM_PIXELS; i++) {
+		pixels[i] = (uint32_t) rand() ^ ((uint32_t) rand() << 16);
+	}
+}
+
+FEATURE(PixelsMult, "Multiply pixels")
+	SCENARIO("Multiply by a mask")
+		GIVEN("random pixels and a mask")
+		uint32_t src[NUM_PIXELS];
+		RandomPixels(src);
+		const color_t mask = { 12, 200, 255, 128 };
+
+		WHEN("I multiply them")
+		uint32_t dst[NUM_PIXELS];
+		PixelsMult(dst, src, NUM_PIXELS, ToPixel(mask));
+
+		THEN("the result should equal ColorMult for each pixel")
+		bool same = true;
+		for (int i = 0; i < NUM_PIXELS; i++) {
+			same = same && dst[i] == ToPixel(ColorMult(ToColor(src[i]), mask));
+		}
+		SHOULD_BE_TRUE(same);
+		SCENARIO_END
+
+	SCENARIO("Multiply every component value")
+		GIVEN("pixels covering all component values")
+		uint32_t src[256 * 4];
+		uint32_t masks[256 * 4];
+		for (int i = 0; i < 256 * 4; i++) {
+			src[i] = 0x01010101u * (uint32_t) (i % 256);
+			masks[i] = 0x01010101u * (uint32_t) (i / 4);
+		}
+
+		WHEN("I multiply each by each")
+		bool same = true;
+		for (int i = 0; i < 256 * 4; i++) {
+			uint32_t dst[256 * 4];
+			uint32_t expected[256 * 4];
+			PixelsMult(dst, src, 256 * 4, masks[i]);
+			PixelsMultScalar(expected, src, 256 * 4, masks[i]);
+			for (int j = 0; j < 256 * 4; j++) {
+				same = same && dst[j] == expected[j];
+			}
+		}
+
+		THEN("the result should equal the scalar version")
+		SHOULD_BE_TRUE(same);
+		SCENARIO_END
+	FEATURE_END
+
+FEATURE(PixelsMultAlt, "Multiply pixels with alt mask")
+	SCENARIO("Multiply by masks")
+		GIVEN("random pixels, some of them red only, and two masks")
+		uint32_t src[NUM_PIXELS];
+		RandomPixels(src);
+		for (int i = 0; i < NUM_PIXELS; i += 3) {
+			color_t c = ToColor(src[i]);
+			c.g = (uint8_t) (i % 3);
+			c.b = (uint8_t) (i % 4);
+			src[i] = ToPixel(c);
+		}
+		const color_t mask = { 12, 200, 255, 128 };
+		const color_t maskAlt = { 99, 0, 42, 255 };
+
+		WHEN("I multiply them")
+		uint32_t dst[NUM_PIXELS];
+		PixelsMultAlt(dst, src, NUM_PIXELS, shifts, ToPixel(mask),
+				ToPixel(maskAlt));
+
+		THEN("the result should equal the scalar version")
+		uint32_t expected[NUM_PIXELS];
+		PixelsMultAltScalar(expected, src, NUM_PIXELS, shifts, ToPixel(mask),
+				ToPixel(maskAlt));
+		SHOULD_MEM_EQUAL(dst, expected, sizeof dst);
+		AND("red only pixels should use the alt mask")
+		color_t c = ToColor(src[0]);
+		c.g = c.b = c.r;
+		SHOULD_INT_EQUAL(dst[0], ToPixel(ColorMult(c, maskAlt)));
+		SCENARIO_END
+	FEATURE_END
+
+FEATURE(PixelsMultCharChannels, "Multiply char pixels by channel")
+	SCENARIO("Multiply by channel masks")
+		GIVEN("random pixels in each channel, and channel masks")
+		uint32_t src[NUM_PIXELS];
+		RandomPixels(src);
+		for (int i = 0; i < NUM_PIXELS; i++) {
+			color_t c = ToColor(src[i]);
+			// Include some unknown channels
+			c.a = (uint8_t) (255 - i % (PIXEL_CHAR_CHANNELS + 1));
+			src[i] = ToPixel(c);
+		}
+		src[0] = 0;
+		const color_t colors[PIXEL_CHAR_CHANNELS] = {
+			{ 255, 255, 255, 255 }, { 1, 2, 3, 255 }, { 200, 100, 50, 255 },
+			{ 0, 255, 0, 255 }, { 70, 70, 70, 128 }, { 255, 0, 255, 255 }
+		};
+		uint32_t masks[PIXEL_CHAR_CHANNELS];
+		for (int i = 0; i < PIXEL_CHAR_CHANNELS; i++) {
+			masks[i] = ToPixel(colors[i]);
+		}
+
+		WHEN("I multiply them")
+		uint32_t dst[NUM_PIXELS];
+		PixelsMultCharChannels(dst, src, NUM_PIXELS, shifts, masks);
+
+		THEN("the result should equal the scalar version")
+		uint32_t expected[NUM_PIXELS];
+		PixelsMultCharChannelsScalar(expected, src, NUM_PIXELS, shifts, masks);
+		SHOULD_MEM_EQUAL(dst, expected, sizeof dst);
+		AND("each pixel should be multiplied by its channel colour")
+		SHOULD_INT_EQUAL(dst[0], 0);
+		SHOULD_INT_EQUAL(dst[1],
+				ToPixel(ColorMult(ToColor(src[1]), colors[1])));
+		AND("unknown channels should be unchanged")
+		SHOULD_INT_EQUAL(dst[6], src[6]);
+		SCENARIO_END
+	FEATURE_END
+
+FEATURE(PixelsToCharChannels, "Convert char pixels to channels")
+	SCENARIO("Convert pure colours")
+		GIVEN("pure coloured pixels")
+		const color_t in[] = {
+			{ 200, 0, 0, 255 }, { 0, 200, 0, 255 }, { 0, 0, 200, 255 },
+			{ 200, 200, 0, 255 }, { 0, 200, 200, 255 }, { 100, 100, 100, 255 },
+			{ 200, 0, 0, 254 }
+		};
+		uint32_t pixels[sizeof in / sizeof in[0]];
+		for (int i = 0; i < (int) (sizeof in / sizeof in[0]); i++) {
+			pixels[i] = ToPixel(in[i]);
+		}
+
+		WHEN("I convert them")
+		PixelsToCharChannels(pixels, sizeof in / sizeof in[0], shifts);
+
+		THEN("they should be grey with the channel in alpha")
+		const color_t skin = { 200, 200, 200, 254 };
+		SHOULD_INT_EQUAL(pixels[0], ToPixel(skin));
+		const color_t hair = { 200, 200, 200, 250 };
+		SHOULD_INT_EQUAL(pixels[1], ToPixel(hair));
+		const color_t arms = { 200, 200, 200, 253 };
+		SHOULD_INT_EQUAL(pixels[2], ToPixel(arms));
+		const color_t body = { 200, 200, 200, 252 };
+		SHOULD_INT_EQUAL(pixels[3], ToPixel(body));
+		const color_t legs = { 200, 200, 200, 251 };
+		SHOULD_INT_EQUAL(pixels[4], ToPixel(legs));
+		AND("grey and processed pixels should be unchanged")
+		SHOULD_INT_EQUAL(pixels[5], ToPixel(in[5]));
+		SHOULD_INT_EQUAL(pixels[6], ToPixel(in[6]));
+		SCENARIO_END
+	FEATURE_END
+
+CBEHAVE_RUN(
+		"Pixels features are:",
+		TEST_FEATURE(PixelsMult),
+		TEST_FEATURE(PixelsMultAlt),
+		TEST_FEATURE(PixelsMultCharChannels),
+		TEST_FEATURE(PixelsToCharChannels)
+)